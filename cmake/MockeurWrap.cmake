@@ -0,0 +1,108 @@
+########################################################################
+# mockeur_wrap: mock functions while keeping their real implementation
+# linked, thanks to the "--wrap=symbol" option of GNU ld.
+#
+# mockeur_wrap(TARGET <target>
+#              [HEADERS <header>...]
+#              FUNCTIONS <signature>...)
+#
+# Each signature is a C declaration without argument names, e.g.
+#   "int ftp_send(const char*, unsigned int)"
+#
+# For each function, a WrappedMock named wrap_<function> is defined in a
+# generated source file added to the target, and the target is linked with
+# "-Wl,--wrap=<function>". The mocks are declared in the generated header
+# "<target>-mockeur-wrap.hpp", which includes the provided headers.
+#
+# While wrap_<function> is disarmed (the default), the calls go to the real
+# implementation; once armed, they go to wrap_<function>.value().
+########################################################################
+include(CMakeParseArguments)
+
+function(mockeur_wrap)
+    cmake_parse_arguments(MOCKEUR_WRAP "" "TARGET" "HEADERS;FUNCTIONS" ${ARGN})
+
+    if (NOT MOCKEUR_WRAP_TARGET)
+        message(FATAL_ERROR "mockeur_wrap: TARGET is missing")
+    endif()
+    if (NOT COMMAND target_sources)
+        message(FATAL_ERROR "mockeur_wrap: CMake 3.1 or newer is required")
+    endif()
+
+    set(target ${MOCKEUR_WRAP_TARGET})
+    set(guard "${target}_MOCKEUR_WRAP_HPP_")
+    string(MAKE_C_IDENTIFIER "${guard}" guard)
+    string(TOUPPER "${guard}" guard)
+
+    set(header "/* Generated by mockeur_wrap, do not edit. */\n\n")
+    set(header "${header}#ifndef ${guard}\n#define ${guard}\n\n")
+    set(header "${header}#include \"WrappedMock.hpp\"\n\n")
+    if (MOCKEUR_WRAP_HEADERS)
+        set(header "${header}extern \"C\"\n{\n")
+        foreach(included ${MOCKEUR_WRAP_HEADERS})
+            set(header "${header}#include \"${included}\"\n")
+        endforeach()
+        set(header "${header}}\n\n")
+    endif()
+
+    set(source "/* Generated by mockeur_wrap, do not edit. */\n\n")
+    set(source "${source}#include \"${target}-mockeur-wrap.hpp\"\n")
+
+    set(wrapFlags "")
+
+    foreach(signature ${MOCKEUR_WRAP_FUNCTIONS})
+        string(STRIP "${signature}" signature)
+        if (NOT signature MATCHES "^(.+[^A-Za-z0-9_])([A-Za-z_][A-Za-z0-9_]*)[ \t]*\\((.*)\\)$")
+            message(FATAL_ERROR "mockeur_wrap: unable to parse \"${signature}\"")
+        endif()
+        string(STRIP "${CMAKE_MATCH_1}" returnType)
+        set(name "${CMAKE_MATCH_2}")
+        string(STRIP "${CMAKE_MATCH_3}" arguments)
+
+        # Name the arguments a0, a1...
+        set(mockTypes "${returnType}")
+        set(parameters "")
+        set(values "")
+        if (NOT arguments STREQUAL "" AND NOT arguments STREQUAL "void")
+            string(REPLACE "," ";" argumentTypes "${arguments}")
+            set(index 0)
+            foreach(argumentType ${argumentTypes})
+                string(STRIP "${argumentType}" argumentType)
+                set(mockTypes "${mockTypes}, ${argumentType}")
+                if (index GREATER 0)
+                    set(parameters "${parameters}, ")
+                    set(values "${values}, ")
+                endif()
+                set(parameters "${parameters}${argumentType} a${index}")
+                set(values "${values}a${index}")
+                math(EXPR index "${index} + 1")
+            endforeach()
+        endif()
+
+        set(header "${header}extern WrappedMock<${mockTypes}> wrap_${name};\n")
+
+        set(source "${source}\nextern \"C\" ${returnType} __real_${name}(${parameters});\n\n")
+        set(source "${source}WrappedMock<${mockTypes}> wrap_${name};\n\n")
+        set(source "${source}extern \"C\" ${returnType} __wrap_${name}(${parameters})\n{\n")
+        set(source "${source}    if (wrap_${name}.armed())\n")
+        set(source "${source}        return wrap_${name}.value(${values});\n\n")
+        set(source "${source}    return __real_${name}(${values});\n}\n")
+
+        set(wrapFlags "${wrapFlags} -Wl,--wrap=${name}")
+    endforeach()
+
+    set(header "${header}\n#endif /* ${guard} */\n")
+
+    set(outputDir ${CMAKE_CURRENT_BINARY_DIR}/${target}-mockeur-wrap)
+    # Only rewrite the files when they change, to avoid useless rebuilds
+    file(WRITE ${outputDir}/${target}-mockeur-wrap.hpp.tmp "${header}")
+    file(WRITE ${outputDir}/${target}-mockeur-wrap.cpp.tmp "${source}")
+    execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different
+                    ${outputDir}/${target}-mockeur-wrap.hpp.tmp ${outputDir}/${target}-mockeur-wrap.hpp)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different
+                    ${outputDir}/${target}-mockeur-wrap.cpp.tmp ${outputDir}/${target}-mockeur-wrap.cpp)
+
+    target_sources(${target} PRIVATE ${outputDir}/${target}-mockeur-wrap.cpp)
+    set_property(TARGET ${target} APPEND PROPERTY INCLUDE_DIRECTORIES ${outputDir})
+    set_property(TARGET ${target} APPEND_STRING PROPERTY LINK_FLAGS "${wrapFlags}")
+endfunction()
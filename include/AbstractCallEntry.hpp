@@ -14,14 +14,25 @@
 #ifndef ABSTRACTCALLENTRY_HPP_
 #define ABSTRACTCALLENTRY_HPP_
 
+#include <tuple>
+
+#include "ArgumentMatcher/AbstractArgumentMatcher.hpp"
+#include "ArgumentMatchers.hpp"
+#include "internal/CallRecord.hpp"
+
+/**
+ * Call recorded in the history of a mock, with its arguments. The sequence
+ * numbers of the call are handled by the @ref CallRecord without template.
+ */
 template<typename ... ArgTypes>
-class AbstractCallEntry
+class AbstractCallEntry : public CallRecord
 {
 public:
     /**
      * Constructor of BaseCallEntry
      */
     AbstractCallEntry()
+        : CallRecord()
     {
     }
 
@@ -41,6 +52,34 @@ public:
      *         argument matchers.
      */
     virtual bool acceptedBy(AbstractArgumentMatcher<ArgTypes>* ... matchersPtr) const = 0;
+
+    /**
+     * Returns whether the current object is matched by the instance of
+     * argument matchers. The arguments are checked in the order learnt by
+     * the instance over the previous entries.
+     *
+     * @param matchers An instance of argument matchers
+     * @return Whether the current object is matched by the instance of
+     *         argument matchers.
+     */
+    virtual bool acceptedBy(const ArgumentMatchers<ArgTypes...>& matchers) const = 0;
+
+    /**
+     * Returns the arguments of the call.
+     *
+     * @return The arguments of the call
+     */
+    virtual const std::tuple<ArgTypes...>& arguments() const = 0;
+
+    /**
+     * Returns whether the arguments of the call equal (with the "=="
+     * operator) the provided ones. It is always false when the arguments
+     * cannot be compared.
+     *
+     * @param args The instance of arguments
+     * @return Whether the arguments of the call equal the provided ones
+     */
+    virtual bool sameArguments(ArgTypes ... args) const = 0;
 };
 
 #endif /* ABSTRACTCALLENTRY_HPP_ */
@@ -13,6 +13,8 @@
 #ifndef ABSTRACT_ARGUMENT_MATCHER_HPP_
 #define ABSTRACT_ARGUMENT_MATCHER_HPP_
 
+#include <type_traits>
+
 #include "internal/BaseArgumentMatcher.hpp"
 
 /**
@@ -39,6 +41,18 @@ public:
      * @return Whether the object matches the argument.
      */
     virtual bool match(Type arg) const = 0;
+
+    /**
+     * Returns the single value matched by the object, if it matches a single
+     * value (with the "==" operator), so that the calls it matches can be
+     * found by their fingerprint.
+     *
+     * @return The matched value, or null if several values are matched
+     */
+    virtual const typename std::remove_reference<Type>::type* fixedValue() const
+    {
+        return nullptr;
+    }
 };
 
 #endif /* ABSTRACT_ARGUMENT_MATCHER_HPP_ */
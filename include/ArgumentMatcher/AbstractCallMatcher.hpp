@@ -0,0 +1,73 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE.txt in this distribution.
+ */
+
+/**
+ * @file AbstractCallMatcher.hpp
+ * @brief Declaration of the class AbstractCallMatcher
+ */
+
+#ifndef ABSTRACT_CALL_MATCHER_HPP_
+#define ABSTRACT_CALL_MATCHER_HPP_
+
+#include <cstddef>
+#include <string>
+
+#include "ArgumentView.hpp"
+#include "internal/BaseArgumentMatcher.hpp"
+
+/**
+ * Abstract class for the matchers of several arguments of a call at once,
+ * like a buffer passed as a pointer and a length. Unlike an argument matcher,
+ * it is not typed: it reads the arguments it needs through an
+ * @ref ArgumentView, and checks their types once, when it is given to a
+ * mock.
+ */
+class AbstractCallMatcher: public BaseArgumentMatcher
+{
+public:
+    AbstractCallMatcher()
+        : BaseArgumentMatcher()
+    {
+    }
+
+    virtual ~AbstractCallMatcher()
+    {
+    }
+
+    /**
+     * Throws a std::runtime_error if the matcher cannot read the arguments of
+     * a signature.
+     *
+     * @param types The types of the arguments
+     * @param count The number of arguments
+     */
+    virtual void checkTypes(const ArgumentType* types, std::size_t count) const = 0;
+
+    /**
+     * Returns whether the object matches the arguments of a call.
+     *
+     * @param arguments The arguments of the call
+     * @return Whether the object matches the arguments of the call.
+     */
+    virtual bool match(const ArgumentView& arguments) const = 0;
+
+    /**
+     * Returns the single content matched by the object for a buffer passed
+     * as a pointer and a length, if it matches a single one, so that the
+     * calls it matches can be found by their fingerprint.
+     *
+     * @param pointerPosition The position of the pointer argument
+     * @param lengthPosition The position of the length argument
+     * @return The matched content, or null
+     */
+    virtual const std::string* fixedBytes(std::size_t, std::size_t) const
+    {
+        return nullptr;
+    }
+};
+
+#endif /* ABSTRACT_CALL_MATCHER_HPP_ */
@@ -0,0 +1,73 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE.txt in this distribution.
+ */
+
+/**
+ * @file AllOfArgumentMatcher.hpp
+ * @brief Declaration and definition of the class AllOfArgumentMatcher
+ */
+
+#ifndef ALLOF_ARGUMENT_MATCHER_HPP_
+#define ALLOF_ARGUMENT_MATCHER_HPP_
+
+#include <vector>
+
+#include "AbstractArgumentMatcher.hpp"
+#include "internal/AdaptiveOrder.hpp"
+
+/**
+ * This matcher matches the arguments matched by every one of its matchers.
+ * The matchers are not evaluated in the order they are given: their order
+ * adapts to the arguments (see @ref AdaptiveOrder), so that the cheapest
+ * matchers which most often decide the result are evaluated first. The
+ * matchers must therefore not depend on each other.
+ */
+template<typename Type>
+class AllOfArgumentMatcher: public AbstractArgumentMatcher<Type>
+{
+public:
+    /**
+     * Constructor of AllOfArgumentMatcher. The matchers are not owned.
+     *
+     * @param providedMatchers The matchers
+     */
+    AllOfArgumentMatcher(const std::vector<AbstractArgumentMatcher<Type>*>& providedMatchers)
+        : AbstractArgumentMatcher<Type>(),
+          matchers(providedMatchers),
+          order(static_cast<unsigned int>(providedMatchers.size()), AdaptiveOrder::STOP_ON_REJECT)
+    {
+    }
+
+    /**
+     * Returns whether every matcher matches the argument.
+     *
+     * @param arg The argument to match.
+     * @return Whether every matcher matches the argument.
+     */
+    bool match(Type arg) const
+    {
+        return order.evaluate([this, &arg] (unsigned int index) {
+            return matchers[index]->match(arg);
+        });
+    }
+
+    /* The adaptive order is updated with atomic operations only */
+    bool threadSafe() const
+    {
+        for (AbstractArgumentMatcher<Type>* matcherPtr : matchers) {
+            if (!matcherPtr->threadSafe())
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    std::vector<AbstractArgumentMatcher<Type>*> matchers;
+    AdaptiveOrder order;
+};
+
+#endif /* ALLOF_ARGUMENT_MATCHER_HPP_ */
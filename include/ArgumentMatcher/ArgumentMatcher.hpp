@@ -13,9 +13,16 @@
 #ifndef ARGUMENT_MATCHER_HPP_
 #define ARGUMENT_MATCHER_HPP_
 
-#include <list>
+#include <string>
+#include <vector>
 
+#include "AllOfArgumentMatcher.hpp"
+#include "AnyOfArgumentMatcher.hpp"
+#include "BytesCallMatcher.hpp"
 #include "FixedValueArgumentMatcher.hpp"
+#include "NotArgumentMatcher.hpp"
+#include "RegexArgumentMatcher.hpp"
+#include "StringArgumentMatcher.hpp"
 #include "TypeArgumentMatcher.hpp"
 
 /**
@@ -44,7 +51,7 @@ public:
     {
         FixedValueArgumentMatcher<Type>* matcher = new FixedValueArgumentMatcher<Type>(arg);
 
-        fixedValueMatcher.push_back(matcher);
+        registerMatcher(matcher);
 
         return matcher;
     }
@@ -59,11 +66,169 @@ public:
     {
         TypeArgumentMatcher<Type>* matcher = new TypeArgumentMatcher<Type>();
 
-        fixedValueMatcher.push_back(matcher);
+        registerMatcher(matcher);
 
         return matcher;
     }
 
+    /**
+     * Dynamically creates a matcher of the arguments matched by every
+     * provided matcher. The matchers are evaluated in an adaptive order.
+     *
+     * @param firstMatcherPtr The first matcher
+     * @param otherMatchersPtr The other matchers, of the same type
+     * @return A pointer to a newly created matcher.
+     */
+    template<typename Type, typename ... OtherMatchers>
+    static AllOfArgumentMatcher<Type>* allOf(AbstractArgumentMatcher<Type>* firstMatcherPtr,
+                                             OtherMatchers* ... otherMatchersPtr)
+    {
+        const std::vector<AbstractArgumentMatcher<Type>*> matchers = { firstMatcherPtr, otherMatchersPtr... };
+        AllOfArgumentMatcher<Type>* matcher = new AllOfArgumentMatcher<Type>(matchers);
+
+        registerMatcher(matcher);
+
+        return matcher;
+    }
+
+    /**
+     * Dynamically creates a matcher of the arguments matched by at least one
+     * provided matcher. The matchers are evaluated in an adaptive order.
+     *
+     * @param firstMatcherPtr The first matcher
+     * @param otherMatchersPtr The other matchers, of the same type
+     * @return A pointer to a newly created matcher.
+     */
+    template<typename Type, typename ... OtherMatchers>
+    static AnyOfArgumentMatcher<Type>* anyOf(AbstractArgumentMatcher<Type>* firstMatcherPtr,
+                                             OtherMatchers* ... otherMatchersPtr)
+    {
+        const std::vector<AbstractArgumentMatcher<Type>*> matchers = { firstMatcherPtr, otherMatchersPtr... };
+        AnyOfArgumentMatcher<Type>* matcher = new AnyOfArgumentMatcher<Type>(matchers);
+
+        registerMatcher(matcher);
+
+        return matcher;
+    }
+
+    /**
+     * Dynamically creates a matcher of the arguments not matched by the
+     * provided matcher.
+     *
+     * @param matcherPtr The negated matcher
+     * @return A pointer to a newly created matcher.
+     */
+    template<typename Type>
+    static NotArgumentMatcher<Type>* not_(AbstractArgumentMatcher<Type>* matcherPtr)
+    {
+        NotArgumentMatcher<Type>* matcher = new NotArgumentMatcher<Type>(matcherPtr);
+
+        registerMatcher(matcher);
+
+        return matcher;
+    }
+
+    /**
+     * Dynamically creates a matcher of the strings equal to the provided one.
+     *
+     * @param expected The string, which is copied
+     * @return A pointer to a newly created matcher (of char* arguments with
+     *         strEq<char*>).
+     */
+    template<typename Type = const char*>
+    static StringArgumentMatcher<Type>* strEq(const char* expected)
+    {
+        return createStringMatcher<Type>(StringArgumentMatcher<Type>::EQUAL, expected);
+    }
+
+    /**
+     * Dynamically creates a matcher of the strings starting with the provided
+     * one.
+     *
+     * @param prefix The string, which is copied
+     * @return A pointer to a newly created matcher.
+     */
+    template<typename Type = const char*>
+    static StringArgumentMatcher<Type>* strPrefix(const char* prefix)
+    {
+        return createStringMatcher<Type>(StringArgumentMatcher<Type>::PREFIX, prefix);
+    }
+
+    /**
+     * Dynamically creates a matcher of the strings containing the provided
+     * one.
+     *
+     * @param substring The string, which is copied
+     * @return A pointer to a newly created matcher.
+     */
+    template<typename Type = const char*>
+    static StringArgumentMatcher<Type>* strContains(const char* substring)
+    {
+        return createStringMatcher<Type>(StringArgumentMatcher<Type>::CONTAINS, substring);
+    }
+
+    /**
+     * Dynamically creates a matcher of the strings in which the provided
+     * POSIX extended regular expression is found. The expression is compiled
+     * once, here: it throws a std::runtime_error if it is not valid.
+     *
+     * @param pattern The regular expression
+     * @return A pointer to a newly created matcher.
+     */
+    template<typename Type = const char*>
+    static RegexArgumentMatcher<Type>* regex(const std::string& pattern)
+    {
+        RegexArgumentMatcher<Type>* matcher = new RegexArgumentMatcher<Type>(pattern);
+
+        registerMatcher(matcher);
+
+        return matcher;
+    }
+
+    /**
+     * Dynamically creates a matcher of the calls whose buffer, passed as a
+     * pointer and a length in bytes, equals the provided bytes.
+     *
+     * @param pointerPosition The position of the pointer argument
+     * @param lengthPosition The position of the length argument
+     * @param expected The bytes, which are copied
+     * @return A pointer to a newly created matcher.
+     */
+    static BytesCallMatcher* bytesEq(std::size_t pointerPosition, std::size_t lengthPosition,
+                                     const std::string& expected);
+
+    /**
+     * Dynamically creates a matcher of the calls whose buffer, passed as a
+     * pointer and a length in bytes, starts with the provided bytes.
+     *
+     * @param pointerPosition The position of the pointer argument
+     * @param lengthPosition The position of the length argument
+     * @param prefix The bytes, which are copied
+     * @return A pointer to a newly created matcher.
+     */
+    static BytesCallMatcher* bytesPrefix(std::size_t pointerPosition, std::size_t lengthPosition,
+                                         const std::string& prefix);
+
+    /**
+     * Dynamically creates a matcher of the calls whose buffer, passed as a
+     * pointer and a length in bytes, has the provided hash.
+     *
+     * @param pointerPosition The position of the pointer argument
+     * @param lengthPosition The position of the length argument
+     * @param hash The expected hash, computed by @ref hashBytes
+     * @return A pointer to a newly created matcher.
+     */
+    static BytesCallMatcher* bytesHash(std::size_t pointerPosition, std::size_t lengthPosition, std::uint64_t hash);
+
+    /**
+     * Returns the hash of a buffer, as compared by @ref bytesHash.
+     *
+     * @param dataPtr The buffer
+     * @param length The length of the buffer
+     * @return The hash of the buffer
+     */
+    static std::uint64_t hashBytes(const void* dataPtr, std::size_t length);
+
     static TypeArgumentMatcher<int>* anyInt();
     static TypeArgumentMatcher<char>* anyChar();
     static TypeArgumentMatcher<char*>* anyCharPointer();
@@ -71,7 +236,30 @@ public:
     static TypeArgumentMatcher<void*>* anyVoidPointer();
 
 private:
-    static std::list<BaseArgumentMatcher*> fixedValueMatcher;
+    /**
+     * Dynamically creates a matcher of the content of the strings.
+     *
+     * @param comparison The comparison of the content
+     * @param string The string to compare the arguments with
+     * @return A pointer to a newly created matcher.
+     */
+    template<typename Type>
+    static StringArgumentMatcher<Type>* createStringMatcher(typename StringArgumentMatcher<Type>::Comparison comparison,
+                                                           const char* string)
+    {
+        StringArgumentMatcher<Type>* matcher = new StringArgumentMatcher<Type>(comparison, string);
+
+        registerMatcher(matcher);
+
+        return matcher;
+    }
+
+    /**
+     * Keep track of a dynamically created matcher, to delete it on @ref clear.
+     *
+     * @param matcher The created matcher
+     */
+    static void registerMatcher(BaseArgumentMatcher* matcher);
 
     static TypeArgumentMatcher<int> anyIntMatcher;
     static TypeArgumentMatcher<char> anyCharMatcher;
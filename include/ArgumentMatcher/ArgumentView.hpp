@@ -0,0 +1,190 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE.txt in this distribution.
+ */
+
+/**
+ * @file ArgumentView.hpp
+ * @brief Declaration and definition of the class ArgumentView
+ */
+
+#ifndef ARGUMENT_VIEW_HPP_
+#define ARGUMENT_VIEW_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Type of an argument, as seen by an @ref ArgumentView
+ */
+struct ArgumentType
+{
+    /**
+     * Kind of the argument
+     */
+    enum Kind
+    {
+        OTHER,            /**< Not readable through a view */
+        POINTER,          /**< Pointer to an object */
+        SIGNED_INTEGER,   /**< Signed integral type */
+        UNSIGNED_INTEGER  /**< Unsigned integral type */
+    };
+
+    Kind kind;
+    unsigned int size;
+
+    constexpr ArgumentType()
+        : kind(OTHER), size(0)
+    {
+    }
+
+    constexpr ArgumentType(Kind providedKind, unsigned int providedSize)
+        : kind(providedKind), size(providedSize)
+    {
+    }
+
+    /**
+     * Returns whether an argument of this type can be read as a length.
+     *
+     * @return Whether the type is integral
+     */
+    constexpr bool isInteger() const
+    {
+        return kind == SIGNED_INTEGER || kind == UNSIGNED_INTEGER;
+    }
+};
+
+/**
+ * Returns the @ref ArgumentType of a C++ type, as ArgumentTypeOf<Type>::value.
+ */
+template<typename Type,
+         typename BareType = typename std::remove_cv<typename std::remove_reference<Type>::type>::type>
+struct ArgumentTypeOf
+{
+    static constexpr ArgumentType value = ArgumentType(
+        std::is_pointer<BareType>::value ? ArgumentType::POINTER
+            : !std::is_integral<BareType>::value ? ArgumentType::OTHER
+            : std::is_signed<BareType>::value ? ArgumentType::SIGNED_INTEGER
+            : ArgumentType::UNSIGNED_INTEGER,
+        static_cast<unsigned int>(sizeof(BareType)));
+};
+
+template<typename Type, typename BareType>
+constexpr ArgumentType ArgumentTypeOf<Type, BareType>::value;
+
+/**
+ * The types of the arguments of a signature, as
+ * ArgumentTypeList<ArgumentTypes...>::types.
+ */
+template<typename ... ArgumentTypes>
+struct ArgumentTypeList
+{
+    /* The last entry keeps the array from being empty */
+    static constexpr ArgumentType types[] = { ArgumentTypeOf<ArgumentTypes>::value..., ArgumentType() };
+};
+
+template<typename ... ArgumentTypes>
+constexpr ArgumentType ArgumentTypeList<ArgumentTypes...>::types[];
+
+/**
+ * View of all the arguments of a call, whatever their types: each argument
+ * is reached by its position. It lets an @ref AbstractCallMatcher check
+ * arguments which go together, like a buffer passed as a pointer and a
+ * length.
+ */
+class ArgumentView
+{
+public:
+    /**
+     * Constructor of ArgumentView
+     *
+     * @param providedAddresses The addresses of the arguments
+     * @param providedTypes The types of the arguments
+     * @param providedCount The number of arguments
+     */
+    ArgumentView(const void* const* providedAddresses, const ArgumentType* providedTypes, std::size_t providedCount)
+        : addresses(providedAddresses), types(providedTypes), count(providedCount)
+    {
+    }
+
+    /**
+     * Returns the number of arguments.
+     *
+     * @return The number of arguments
+     */
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    /**
+     * Returns the type of an argument.
+     *
+     * @param position The position of the argument
+     * @return The type of the argument
+     */
+    const ArgumentType& type(std::size_t position) const
+    {
+        return types[position];
+    }
+
+    /**
+     * Returns the value of a pointer argument.
+     *
+     * @param position The position of the argument, of kind POINTER
+     * @return The value of the pointer
+     */
+    const void* pointer(std::size_t position) const
+    {
+        return *static_cast<const void* const*>(addresses[position]);
+    }
+
+    /**
+     * Returns the value of an integral argument, as a length: a negative
+     * value is 0.
+     *
+     * @param position The position of the argument, of an integral kind
+     * @return The value of the argument
+     */
+    std::size_t length(std::size_t position) const
+    {
+        const void* addressPtr = addresses[position];
+        const bool isSigned = (types[position].kind == ArgumentType::SIGNED_INTEGER);
+        long long signedValue = 0;
+
+        switch (types[position].size) {
+        case 1:
+            if (!isSigned)
+                return *static_cast<const std::uint8_t*>(addressPtr);
+            signedValue = *static_cast<const std::int8_t*>(addressPtr);
+            break;
+        case 2:
+            if (!isSigned)
+                return *static_cast<const std::uint16_t*>(addressPtr);
+            signedValue = *static_cast<const std::int16_t*>(addressPtr);
+            break;
+        case 4:
+            if (!isSigned)
+                return *static_cast<const std::uint32_t*>(addressPtr);
+            signedValue = *static_cast<const std::int32_t*>(addressPtr);
+            break;
+        default:
+            if (!isSigned)
+                return static_cast<std::size_t>(*static_cast<const std::uint64_t*>(addressPtr));
+            signedValue = *static_cast<const std::int64_t*>(addressPtr);
+            break;
+        }
+
+        return signedValue < 0 ? 0 : static_cast<std::size_t>(signedValue);
+    }
+
+private:
+    const void* const* addresses;
+    const ArgumentType* types;
+    std::size_t count;
+};
+
+#endif /* ARGUMENT_VIEW_HPP_ */
@@ -0,0 +1,88 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE.txt in this distribution.
+ */
+
+/**
+ * @file BytesCallMatcher.hpp
+ * @brief Declaration of the class BytesCallMatcher
+ */
+
+#ifndef BYTES_CALL_MATCHER_HPP_
+#define BYTES_CALL_MATCHER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "AbstractCallMatcher.hpp"
+
+/**
+ * This matcher matches the content of a buffer passed as two arguments: a
+ * pointer and a length (in bytes). The content is compared with memcmp, or
+ * through its hash (see @ref hash).
+ */
+class BytesCallMatcher: public AbstractCallMatcher
+{
+public:
+    /**
+     * Comparison of the content of the buffer
+     */
+    enum Comparison
+    {
+        EQUAL,  /**< The buffer equals the bytes */
+        PREFIX, /**< The buffer starts with the bytes */
+        HASH    /**< The hash of the buffer equals the expected hash */
+    };
+
+    /**
+     * Constructor of BytesCallMatcher
+     *
+     * @param providedPointerPosition The position of the pointer argument
+     * @param providedLengthPosition The position of the length argument
+     * @param providedComparison The comparison of the content (EQUAL or
+     *                           PREFIX)
+     * @param providedBytes The bytes to compare the buffer with
+     */
+    BytesCallMatcher(std::size_t providedPointerPosition, std::size_t providedLengthPosition,
+                     Comparison providedComparison, const std::string& providedBytes);
+
+    /**
+     * Constructor of BytesCallMatcher, comparing the hash of the buffer.
+     *
+     * @param providedPointerPosition The position of the pointer argument
+     * @param providedLengthPosition The position of the length argument
+     * @param providedHash The expected hash, computed by @ref hash
+     */
+    BytesCallMatcher(std::size_t providedPointerPosition, std::size_t providedLengthPosition,
+                     std::uint64_t providedHash);
+
+    void checkTypes(const ArgumentType* types, std::size_t count) const;
+
+    bool match(const ArgumentView& arguments) const;
+
+    const std::string* fixedBytes(std::size_t providedPointerPosition, std::size_t providedLengthPosition) const;
+
+    bool threadSafe() const;
+
+    /**
+     * Returns the 64-bit hash of a buffer. It reads 32 bytes per step, and
+     * depends on the byte order of the machine.
+     *
+     * @param dataPtr The buffer
+     * @param length The length of the buffer
+     * @return The hash of the buffer
+     */
+    static std::uint64_t hash(const void* dataPtr, std::size_t length);
+
+private:
+    std::size_t pointerPosition;
+    std::size_t lengthPosition;
+    Comparison comparison;
+    std::string bytes;
+    std::uint64_t expectedHash;
+};
+
+#endif /* BYTES_CALL_MATCHER_HPP_ */
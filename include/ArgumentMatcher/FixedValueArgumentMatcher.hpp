@@ -13,6 +13,8 @@
 #ifndef FIXED_VALUE_ARGUMENT_MATCHER_HPP_
 #define FIXED_VALUE_ARGUMENT_MATCHER_HPP_
 
+#include <type_traits>
+
 #include "AbstractArgumentMatcher.hpp"
 
 /**
@@ -42,6 +44,16 @@ public:
         return valueMatched == valueToTest;
     }
 
+    const typename std::remove_reference<Type>::type* fixedValue() const
+    {
+        return &valueMatched;
+    }
+
+    bool threadSafe() const
+    {
+        return true;
+    }
+
 private:
     Type valueMatched;
 };
@@ -0,0 +1,55 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE.txt in this distribution.
+ */
+
+/**
+ * @file NotArgumentMatcher.hpp
+ * @brief Declaration and definition of the class NotArgumentMatcher
+ */
+
+#ifndef NOT_ARGUMENT_MATCHER_HPP_
+#define NOT_ARGUMENT_MATCHER_HPP_
+
+#include "AbstractArgumentMatcher.hpp"
+
+/**
+ * This matcher matches the arguments which its matcher does not match.
+ */
+template<typename Type>
+class NotArgumentMatcher: public AbstractArgumentMatcher<Type>
+{
+public:
+    /**
+     * Constructor of NotArgumentMatcher. The matcher is not owned.
+     *
+     * @param providedMatcherPtr The negated matcher
+     */
+    NotArgumentMatcher(AbstractArgumentMatcher<Type>* providedMatcherPtr)
+        : AbstractArgumentMatcher<Type>(), matcherPtr(providedMatcherPtr)
+    {
+    }
+
+    /**
+     * Returns whether the negated matcher does not match the argument.
+     *
+     * @param arg The argument to match.
+     * @return Whether the negated matcher does not match the argument.
+     */
+    bool match(Type arg) const
+    {
+        return !matcherPtr->match(arg);
+    }
+
+    bool threadSafe() const
+    {
+        return matcherPtr->threadSafe();
+    }
+
+private:
+    AbstractArgumentMatcher<Type>* matcherPtr;
+};
+
+#endif /* NOT_ARGUMENT_MATCHER_HPP_ */
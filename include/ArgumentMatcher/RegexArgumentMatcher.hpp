@@ -0,0 +1,63 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE.txt in this distribution.
+ */
+
+/**
+ * @file RegexArgumentMatcher.hpp
+ * @brief Declaration and definition of the class RegexArgumentMatcher
+ */
+
+#ifndef REGEX_ARGUMENT_MATCHER_HPP_
+#define REGEX_ARGUMENT_MATCHER_HPP_
+
+#include <string>
+
+#include "AbstractArgumentMatcher.hpp"
+#include "internal/StringSearch.hpp"
+
+/**
+ * This matcher matches the null-terminated strings (const char* or char*) in
+ * which a POSIX extended regular expression is found. The expression is
+ * compiled once, by the constructor. A null pointer is never matched.
+ */
+template<typename Type>
+class RegexArgumentMatcher: public AbstractArgumentMatcher<Type>
+{
+public:
+    /**
+     * Constructor of RegexArgumentMatcher. It throws a std::runtime_error if
+     * the expression is not valid.
+     *
+     * @param pattern The extended regular expression (use ^ and $ to match
+     *                the whole argument)
+     */
+    RegexArgumentMatcher(const std::string& pattern)
+        : AbstractArgumentMatcher<Type>(), regex(pattern)
+    {
+    }
+
+    /**
+     * Returns whether the regular expression is found in the argument.
+     *
+     * @param arg The null-terminated string to test
+     * @return Whether the regular expression is found in the argument
+     */
+    bool match(Type arg) const
+    {
+        return arg != nullptr && regex.search(arg);
+    }
+
+    /* The compiled expression is only read */
+    bool threadSafe() const
+    {
+        return true;
+    }
+
+private:
+    CompiledRegex regex;
+};
+
+#endif /* REGEX_ARGUMENT_MATCHER_HPP_ */
@@ -0,0 +1,83 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE.txt in this distribution.
+ */
+
+/**
+ * @file StringArgumentMatcher.hpp
+ * @brief Declaration and definition of the class StringArgumentMatcher
+ */
+
+#ifndef STRING_ARGUMENT_MATCHER_HPP_
+#define STRING_ARGUMENT_MATCHER_HPP_
+
+#include <cstring>
+#include <string>
+
+#include "AbstractArgumentMatcher.hpp"
+#include "internal/StringSearch.hpp"
+
+/**
+ * This matcher matches the null-terminated strings (const char* or char*)
+ * according to their content: equal to, starting with or containing the
+ * string given at its constructor. A null pointer is never matched.
+ */
+template<typename Type>
+class StringArgumentMatcher: public AbstractArgumentMatcher<Type>
+{
+public:
+    /**
+     * Comparison of the content of the argument
+     */
+    enum Comparison
+    {
+        EQUAL,   /**< The argument equals the string */
+        PREFIX,  /**< The argument starts with the string */
+        CONTAINS /**< The argument contains the string */
+    };
+
+    /**
+     * Constructor of StringArgumentMatcher. The string is copied.
+     *
+     * @param providedComparison The comparison of the content
+     * @param providedString The string to compare the arguments with
+     */
+    StringArgumentMatcher(Comparison providedComparison, const char* providedString)
+        : AbstractArgumentMatcher<Type>(), comparison(providedComparison), expected(providedString)
+    {
+    }
+
+    /**
+     * Returns whether the content of the argument is matched.
+     *
+     * @param arg The null-terminated string to test
+     * @return Whether the content of the argument is matched
+     */
+    bool match(Type arg) const
+    {
+        if (arg == nullptr)
+            return false;
+
+        switch (comparison) {
+        case EQUAL:
+            return std::strcmp(arg, expected.c_str()) == 0;
+        case PREFIX:
+            return std::strncmp(arg, expected.c_str(), expected.size()) == 0;
+        default:
+            return StringSearch::contains(arg, expected.data(), expected.size());
+        }
+    }
+
+    bool threadSafe() const
+    {
+        return true;
+    }
+
+private:
+    Comparison comparison;
+    std::string expected;
+};
+
+#endif /* STRING_ARGUMENT_MATCHER_HPP_ */
@@ -31,6 +31,24 @@ public:
     {
         return true;
     }
+
+    bool threadSafe() const
+    {
+        return true;
+    }
+
+    /**
+     * Returns a matcher of the type which is never deleted, for the
+     * arguments which are only matched by an @ref AbstractCallMatcher.
+     *
+     * @return A matcher of any object of the type
+     */
+    static TypeArgumentMatcher* shared()
+    {
+        static TypeArgumentMatcher sharedMatcher;
+
+        return &sharedMatcher;
+    }
 };
 
 #endif /* TYPE_ARGUMENT_MATCHER_HPP_ */
@@ -0,0 +1,382 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file BaseMock.hpp
+ * @brief Declaration and definition of the class BaseMock
+ */
+
+#ifndef BASEMOCK_HPP_
+#define BASEMOCK_HPP_
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CallSequence.hpp"
+#include "internal/CallSiteTable.hpp"
+#include "internal/CallTimer.hpp"
+#include "internal/QueryPool.hpp"
+
+/**
+ * Base class without template of every @ref Mock. It holds what does not
+ * depend on the signature of the mocked function:
+ *  - the name of the mock, which registers it in the @ref MockRegistry;
+ *  - the timestamps of the calls, when they are recorded;
+ *  - the number of calls per call site, when they are recorded;
+ *  - the named behaviors of the mock, to switch between them at runtime.
+ *
+ * Its constructor is a constant initialization: what needs an allocation is
+ * created on first use, so that the global mocks cost nothing before main.
+ */
+class BaseMock
+{
+public:
+    /**
+     * Timestamp of a call to the mock
+     */
+    struct TimedCall
+    {
+        /**
+         * The sequence number of the call (see @ref CallSequence)
+         */
+        CallSequence::Number sequenceNumber;
+
+        /**
+         * The time of the call, in ticks of the @ref CallTimer (see
+         * BaseMock::timestampScale to convert it into nanoseconds)
+         */
+        long long timestamp;
+    };
+
+    /**
+     * Number of calls from a call site of the code under test
+     */
+    struct CallSite
+    {
+        /**
+         * The return address of the calls
+         */
+        const void* address;
+
+        /**
+         * The number of calls
+         */
+        unsigned long long count;
+
+        /**
+         * The name of the function containing the call site, empty if
+         * unknown. The symbols of an executable are only known if it is
+         * linked with "-rdynamic".
+         */
+        std::string function;
+
+        /**
+         * The offset of the return address in the function
+         */
+        unsigned long offset;
+
+        /**
+         * The path of the executable or shared library containing the call
+         * site, empty if unknown
+         */
+        std::string object;
+    };
+
+    /**
+     * Constructor of BaseMock. The mock has no name and does not record the
+     * timestamps nor the call sites of the calls.
+     */
+    constexpr BaseMock()
+        : baseStatePtr(nullptr), timestampsEnabled(false), callersEnabled(false), totalCallCount(0)
+    {
+    }
+
+    /**
+     * Destructor of BaseMock. The mock is removed from the @ref MockRegistry.
+     */
+    virtual ~BaseMock();
+
+    /**
+     * Names the mock, usually after the mocked function, and registers it in
+     * the @ref MockRegistry.
+     *
+     * @param providedName The name of the mock
+     */
+    void setName(const std::string& providedName);
+
+    /**
+     * Returns the name of the mock, empty when it has not been named.
+     *
+     * @return The name of the mock
+     */
+    const std::string& name() const
+    {
+        const BaseState* statePtr = baseStatePtr.load(std::memory_order_acquire);
+
+        return statePtr != nullptr ? statePtr->mockName : noName();
+    }
+
+    /**
+     * Enables or disables the recording of the timestamps of the calls. It is
+     * disabled by default.
+     *
+     * @param enabled Whether the timestamps of the calls must be recorded
+     */
+    void recordTimestamps(bool enabled)
+    {
+        if (enabled)
+            CallTimer::start();
+
+        timestampsEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the conversion of the timestamps recorded so far into
+     * nanoseconds of std::chrono::steady_clock.
+     *
+     * @return The conversion of the timestamps into nanoseconds
+     */
+    static CallTimer::Scale timestampScale()
+    {
+        return CallTimer::scale();
+    }
+
+    /**
+     * Returns the timestamps of the calls recorded since the last reset of
+     * the mock, in the order of the calls.
+     *
+     * @return The timestamps of the calls
+     */
+    const std::vector<TimedCall>& timedCalls() const
+    {
+        return baseState().timedCallList;
+    }
+
+    /**
+     * Returns the number of calls to the mock since its construction. Unlike
+     * the history of the calls, it is not reset by the clear of the mock.
+     *
+     * @return The number of calls to the mock since its construction
+     */
+    unsigned long long callCount() const
+    {
+        return totalCallCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sets the size of the histories from which Mock::numberOfCalls is
+     *        split between the cores. It is 1048576 calls by default.
+     *
+     * The history is split into chunks, counted by a pool of worker threads
+     * (one per core) and by the calling thread, and the counts are summed.
+     * The query stays on the calling thread if one of its matchers is not
+     * thread-safe (see BaseArgumentMatcher::threadSafe), or if another thread
+     * is using the pool.
+     *
+     * @param callCount The minimum number of entries of a parallel query
+     */
+    static void setParallelQueryThreshold(std::size_t callCount)
+    {
+        QueryPool::setThreshold(callCount);
+    }
+
+    /**
+     * Sets the number of threads between which the queries of large
+     * histories are split (see @ref setParallelQueryThreshold). It is the
+     * number of cores by default.
+     *
+     * @param threadCount The number of threads, including the calling one (1
+     *                    keeps every query on the calling thread)
+     */
+    static void setParallelQueryThreads(unsigned int threadCount)
+    {
+        QueryPool::setThreadCount(threadCount);
+    }
+
+    /**
+     * Returns the size of the histories from which the queries are split
+     * between the cores (see @ref setParallelQueryThreshold).
+     *
+     * @return The minimum number of entries of a parallel query
+     */
+    static std::size_t parallelQueryThreshold()
+    {
+        return QueryPool::threshold();
+    }
+
+    /**
+     * Enables or disables the counting of the calls per call site, that is to
+     * say per caller of the mocked function. It is disabled by default.
+     *
+     * @param enabled Whether the calls must be counted per call site
+     */
+    void recordCallers(bool enabled)
+    {
+        callersEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of calls per call site since the last reset of the
+     * mock, the most frequent first. The call sites are symbolized (with
+     * dladdr) by this method only.
+     *
+     * @return The number of calls per call site
+     */
+    std::vector<CallSite> callSites() const;
+
+    /**
+     * Switches the mock to one of its behaviors (see Mock::addBehavior),
+     * from any thread. The history of the calls is kept.
+     *
+     * @param behaviorName The name of the behavior
+     * @return Whether the mock has the behavior
+     */
+    bool switchBehavior(const std::string& behaviorName);
+
+    /**
+     * Returns the names of the behaviors of the mock.
+     *
+     * @return The names of the behaviors, sorted
+     */
+    std::vector<std::string> behaviors() const;
+
+    /**
+     * Replaces the call handlers of the mock by one returning a value for
+     * every call, from any thread. The value is read from a text, which is
+     * only possible when the mock returns a number or an enumeration (as its
+     * integer value).
+     *
+     * @param text The value, as text
+     * @return Whether the value has been read and set
+     */
+    virtual bool setReturnValue(const std::string& text);
+
+protected:
+    /**
+     * Removes the mock from the @ref MockRegistry, if it has been named.
+     */
+    void unregister();
+
+    /**
+     * Adds a behavior to the mock, or replaces the behavior of the same name.
+     *
+     * @param behaviorName The name of the behavior
+     * @param apply The function switching the mock to the behavior
+     */
+    void defineBehavior(const std::string& behaviorName, const std::function<void()>& apply);
+
+    /**
+     * Counts a call in the total number of calls.
+     */
+    void countCall()
+    {
+        /* The calls are counted under the lock of the history */
+        totalCallCount.store(totalCallCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Counts a call for its call site, if enabled.
+     *
+     * @param callerAddress The return address of the call to the mocked
+     *                      function
+     */
+    void attributeCall(const void* callerAddress)
+    {
+        if (callersEnabled.load(std::memory_order_relaxed))
+            baseState().callSiteTable.record(callerAddress);
+    }
+
+    /**
+     * Records the timestamp of a call, if enabled.
+     *
+     * @param sequenceNumber The sequence number of the call
+     */
+    void timestampCall(CallSequence::Number sequenceNumber)
+    {
+        if (timestampsEnabled.load(std::memory_order_relaxed)) {
+            const TimedCall timedCall = { sequenceNumber, CallTimer::now() };
+
+            baseState().timedCallList.push_back(timedCall);
+        }
+    }
+
+    /**
+     * Removes the recorded timestamps.
+     */
+    void clearTimestamps()
+    {
+        BaseState* statePtr = baseStatePtr.load(std::memory_order_acquire);
+
+        if (statePtr != nullptr)
+            statePtr->timedCallList.clear();
+    }
+
+    /**
+     * Removes the counts of calls per call site.
+     */
+    void clearCallSites()
+    {
+        BaseState* statePtr = baseStatePtr.load(std::memory_order_acquire);
+
+        if (statePtr != nullptr)
+            statePtr->callSiteTable.clear();
+    }
+
+private:
+    /**
+     * What the mock allocates, created on first use
+     */
+    struct BaseState
+    {
+        std::string mockName;
+        std::vector<TimedCall> timedCallList;
+        CallSiteTable callSiteTable;
+        std::mutex behaviorsMutex;
+        std::map<std::string, std::function<void()> > behaviorMap;
+    };
+
+    mutable std::atomic<BaseState*> baseStatePtr;
+    /* Set by the test while other threads may call the mock */
+    std::atomic<bool> timestampsEnabled;
+    std::atomic<bool> callersEnabled;
+    std::atomic<unsigned long long> totalCallCount;
+
+    /**
+     * Returns the state of the mock, created on first use.
+     *
+     * @return The state of the mock
+     */
+    BaseState& baseState() const
+    {
+        BaseState* statePtr = baseStatePtr.load(std::memory_order_acquire);
+
+        return statePtr != nullptr ? *statePtr : createBaseState();
+    }
+
+    /**
+     * Creates the state of the mock, unless another thread creates it first.
+     *
+     * @return The state of the mock
+     */
+    BaseState& createBaseState() const;
+
+    /**
+     * Returns the name of the mocks without state.
+     *
+     * @return An empty name
+     */
+    static const std::string& noName();
+
+    BaseMock(const BaseMock&);
+    BaseMock& operator=(const BaseMock&);
+};
+
+#endif /* BASEMOCK_HPP_ */
@@ -14,10 +14,18 @@
 #ifndef CALLHANDLER_HPP_
 #define CALLHANDLER_HPP_
 
+#include <chrono>
+#include <functional>
+#include <memory>
+
 #include "ArgumentMatcher/AbstractArgumentMatcher.hpp"
 #include "ArgumentMatchers.hpp"
+#include "MockScript.hpp"
+#include "VirtualClock.hpp"
 
 #include "internal/AbstractCallHandler.hpp"
+#include "internal/CallBehavior.hpp"
+#include "internal/FaultInjector.hpp"
 
 /**
  * Abstract implementation for CallHandler. Everything in this class is common
@@ -36,7 +44,8 @@ public:
     CallHandler_impl(AbstractArgumentMatcher<ArgumentTypes>* ... args)
         : AbstractCallHandler<ReturnType, ArgumentTypes...>(args...),
           matchers(args...),
-          callbackFunction()
+          callbackFunction(),
+          behaviorPtr()
     {
     }
 
@@ -51,11 +60,39 @@ public:
      * @brief Callback function to call when the value function is called.
      * The arguments will be forwarded to the callback function.
      *
+     * The handler is published to the calls once it is configured by this
+     * method or by another then*, so that the calls never see it before. It
+     * must not be configured again while other threads call the mock, which
+     * may call the callback function concurrently.
+     *
      * @param fct The callback function
      */
     virtual void then(const std::function<ReturnType(ArgumentTypes...)> fct)
     {
         callbackFunction = fct;
+        behaviorPtr.reset();
+        this->configured();
+    }
+
+    /**
+     * Returns whether the behavior of the handler depends on the previous
+     * calls.
+     *
+     * @return Whether the handler has a state
+     */
+    bool hasState() const
+    {
+        return behaviorPtr != nullptr;
+    }
+
+    /**
+     * Brings the behavior of the handler back to its state before the first
+     * call.
+     */
+    void rewind()
+    {
+        if (behaviorPtr)
+            behaviorPtr->rewind();
     }
 
     /**
@@ -66,6 +103,9 @@ public:
      */
     ReturnType value(ArgumentTypes ... args)
     {
+        if (behaviorPtr)
+            return behaviorPtr->value(args...);
+
         return callbackFunction(args...);
     }
 
@@ -80,9 +120,37 @@ public:
         return matchers.matchArguments(args...);
     }
 
+    /**
+     * Sets a matcher of the whole call, checked once each argument is
+     * matched.
+     *
+     * @param callMatcherPtr The call matcher
+     */
+    void matchCall(const AbstractCallMatcher* callMatcherPtr)
+    {
+        matchers.setCallMatcher(callMatcherPtr);
+    }
+
 protected:
     ArgumentMatchers<ArgumentTypes...> matchers;
     std::function<ReturnType(ArgumentTypes...)> callbackFunction;
+    /* Answers the calls instead of the callback function, if any. Only
+     * allocated by the behaviors which change from one call to another. */
+    std::unique_ptr<CallBehavior<ReturnType, ArgumentTypes...> > behaviorPtr;
+
+    /**
+     * Sets the behavior answering the calls, instead of a callback function.
+     * The behavior must be configured, as the handler is published with it,
+     * and handle the concurrent calls.
+     *
+     * @param providedBehaviorPtr The behavior, deleted by the handler
+     */
+    void thenBehave(CallBehavior<ReturnType, ArgumentTypes...>* providedBehaviorPtr)
+    {
+        callbackFunction = nullptr;
+        behaviorPtr.reset(providedBehaviorPtr);
+        this->configured();
+    }
 };
 
 
@@ -94,7 +162,7 @@ protected:
  * The class has 3 main types of methods:
  *  - to tell if it matches the arguments: matchArguments;
  *  - to return the value: value;
- *  - to store the expected behavior: then and thenReturn.
+ *  - to store the expected behavior: then, thenReturn, thenReturnAfter...
  *
  * This class is templatized on the return type of the mock and the instance of
  * the arguments types.
@@ -143,6 +211,32 @@ public:
     {
         this->then([] (ArgumentTypes...) {});
     }
+
+    /**
+     * Instantiates the CallHandler object to do nothing when called, except
+     * advancing the @ref VirtualClock by the provided latency.
+     *
+     * @param latency The time the call takes
+     */
+    template<typename Rep, typename Period>
+    void thenReturnAfter(std::chrono::duration<Rep, Period> latency)
+    {
+        const VirtualClock::duration elapsedTime = std::chrono::duration_cast<VirtualClock::duration>(latency);
+
+        this->then([=] (ArgumentTypes...) { VirtualClock::advance(elapsedTime); });
+    }
+
+    /**
+     * Instantiates the CallHandler object to simulate a call which times out:
+     * the @ref VirtualClock is advanced by the provided time.
+     *
+     * @param after The time after which the call times out
+     */
+    template<typename Rep, typename Period>
+    void thenTimeout(std::chrono::duration<Rep, Period> after)
+    {
+        thenReturnAfter(after);
+    }
 };
 
 
@@ -176,6 +270,36 @@ public:
     {
     }
 
+    using CallHandler_impl<ReturnType, ArgumentTypes...>::then;
+
+#ifdef MOCKEUR_HAS_COROUTINES
+    /**
+     * @brief Script answering the successive calls, see MockScript.hpp (C++20
+     * only). The frame of the script is allocated from memory owned by the
+     * handler, and each call resumes the script.
+     *
+     * The runner of the script is the behavior of the handler, which each
+     * call resumes directly, so that the layout of the handler does not
+     * depend on the C++ standard. The method is a template, so that the
+     * explicit instantiations of the handler, built in C++11, do not have to
+     * provide it. Restoring a snapshot starts the script over.
+     *
+     * The script answers one call at a time: a concurrent call throws a
+     * std::runtime_error instead of waiting.
+     *
+     * Only this specialization has it: a mock returning void cannot be
+     * scripted.
+     *
+     * @param scriptFunction The function which creates the script
+     */
+    template<typename ScriptFunction>
+        requires std::is_invocable_r_v<MockScript<ReturnType, ArgumentTypes...>, ScriptFunction>
+    void then(ScriptFunction scriptFunction)
+    {
+        this->thenBehave(new MockScriptRunner<ReturnType, ArgumentTypes...>(scriptFunction));
+    }
+#endif
+
     /**
      * Instantiates the CallHandler object to return the provided argument when
      * called.
@@ -189,6 +313,132 @@ public:
          * function */
         this->then([=] (ArgumentTypes...) { return valueToReturn; });
     }
+
+    /**
+     * Instantiates the CallHandler object to return the provided argument
+     * when called, after having advanced the @ref VirtualClock by the
+     * provided latency.
+     *
+     * @param latency The time the call takes
+     * @param valueToReturn The argument to return when the value of the
+     *                      object is called.
+     */
+    template<typename Rep, typename Period>
+    void thenReturnAfter(std::chrono::duration<Rep, Period> latency, ReturnType valueToReturn)
+    {
+        const VirtualClock::duration elapsedTime = std::chrono::duration_cast<VirtualClock::duration>(latency);
+
+        this->then([=] (ArgumentTypes...) {
+            VirtualClock::advance(elapsedTime);
+            return valueToReturn;
+        });
+    }
+
+    /**
+     * Instantiates the CallHandler object to simulate a call which times out:
+     * the @ref VirtualClock is advanced by the provided time and the
+     * value-initialized ReturnType (0, nullptr...) is returned.
+     *
+     * @param after The time after which the call times out
+     */
+    template<typename Rep, typename Period>
+    void thenTimeout(std::chrono::duration<Rep, Period> after)
+    {
+        thenReturnAfter(after, ReturnType());
+    }
+
+    /**
+     * Instantiates the CallHandler object to simulate a call which times out:
+     * the @ref VirtualClock is advanced by the provided time and the provided
+     * value is returned.
+     *
+     * @param after The time after which the call times out
+     * @param valueOnTimeout The value returned by the function on timeout
+     */
+    template<typename Rep, typename Period>
+    void thenTimeout(std::chrono::duration<Rep, Period> after, ReturnType valueOnTimeout)
+    {
+        thenReturnAfter(after, valueOnTimeout);
+    }
+
+    /**
+     * Instantiates the CallHandler object to act as a time source: it returns
+     * the time of the @ref VirtualClock, counted in the provided unit.
+     *
+     * Example, for a function returning the time in milliseconds:
+     *  mock_now_ms.when()->thenReturnVirtualTime(std::chrono::milliseconds(1));
+     *
+     * @param unit The unit of the returned time
+     */
+    template<typename Rep, typename Period>
+    void thenReturnVirtualTime(std::chrono::duration<Rep, Period> unit)
+    {
+        const VirtualClock::duration unitDuration = std::chrono::duration_cast<VirtualClock::duration>(unit);
+
+        this->then([=] (ArgumentTypes...) {
+            return static_cast<ReturnType>(VirtualClock::now().time_since_epoch() / unitDuration);
+        });
+    }
+
+    /**
+     * Instantiates the CallHandler object to fail randomly: each call returns
+     * errorValue with the provided probability, and okValue otherwise.
+     *
+     * The random generator is owned by the handler: for a given seed, the
+     * sequence of failures of the calls from one thread is always the same.
+     *
+     * @param probability The probability for a call to fail (between 0 and 1)
+     * @param errorValueToReturn The value returned by a failing call
+     * @param okValueToReturn The value returned by a successful call
+     * @param seed The seed of the random generator
+     */
+    void thenFailWithProbability(double probability, ReturnType errorValueToReturn, ReturnType okValueToReturn,
+                                 std::uint64_t seed = FaultInjector::DEFAULT_SEED)
+    {
+        FaultBehavior<ReturnType, ArgumentTypes...>* faultBehaviorPtr =
+            new FaultBehavior<ReturnType, ArgumentTypes...>(errorValueToReturn, okValueToReturn);
+
+        faultBehaviorPtr->injector().failWithProbability(probability, seed);
+        this->thenBehave(faultBehaviorPtr);
+    }
+
+    /**
+     * Instantiates the CallHandler object to fail in bursts: when no burst is
+     * ongoing, a burst starts with the provided probability, then burstLength
+     * consecutive calls return errorValue. The other calls return okValue.
+     *
+     * @param probability The probability for a burst to start
+     * @param burstLength The number of consecutive failing calls of a burst
+     * @param errorValueToReturn The value returned by a failing call
+     * @param okValueToReturn The value returned by a successful call
+     * @param seed The seed of the random generator
+     */
+    void thenFailInBursts(double probability, std::uint64_t burstLength, ReturnType errorValueToReturn,
+                          ReturnType okValueToReturn, std::uint64_t seed = FaultInjector::DEFAULT_SEED)
+    {
+        FaultBehavior<ReturnType, ArgumentTypes...>* faultBehaviorPtr =
+            new FaultBehavior<ReturnType, ArgumentTypes...>(errorValueToReturn, okValueToReturn);
+
+        faultBehaviorPtr->injector().failInBursts(probability, burstLength, seed);
+        this->thenBehave(faultBehaviorPtr);
+    }
+
+    /**
+     * Instantiates the CallHandler object to return okValue for the first
+     * successfulCalls calls, and errorValue for every following call.
+     *
+     * @param successfulCalls The number of calls which succeed
+     * @param errorValueToReturn The value returned by a failing call
+     * @param okValueToReturn The value returned by a successful call
+     */
+    void thenFailAfter(std::uint64_t successfulCalls, ReturnType errorValueToReturn, ReturnType okValueToReturn)
+    {
+        FaultBehavior<ReturnType, ArgumentTypes...>* faultBehaviorPtr =
+            new FaultBehavior<ReturnType, ArgumentTypes...>(errorValueToReturn, okValueToReturn);
+
+        faultBehaviorPtr->injector().failAfter(successfulCalls);
+        this->thenBehave(faultBehaviorPtr);
+    }
 };
 
 #endif /* CALLHANDLER_HPP_ */
@@ -0,0 +1,197 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallPattern.hpp
+ * @brief Declaration of the class CallPattern
+ */
+
+#ifndef CALLPATTERN_HPP_
+#define CALLPATTERN_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "CallSequence.hpp"
+#include "internal/MockCore.hpp"
+
+template<typename ReturnType, typename ... ArgumentTypes>
+class Mock;
+
+/**
+ * Pattern of consecutive calls, over the history of a mock or across mocks,
+ * like a regular expression whose characters are calls. Example, to check
+ * that the data model is set to BINARY before some content is sent, then an
+ * empty buffer:
+ *  CallPattern transfer = mock_ftp_setDataModel.callWith(ArgumentMatcher::eq<enum DataModel>(BINARY))
+ *      .then(mock_ftp_send.callWith(ArgumentMatcher::any<const char*>(),
+ *                                   ArgumentMatcher::not_(ArgumentMatcher::eq<unsigned int>(0))).oneOrMore())
+ *      .then(mock_ftp_send.callWith(ArgumentMatcher::any<const char*>(),
+ *                                   ArgumentMatcher::eq<unsigned int>(0)));
+ *  assert(1u == transfer.count());
+ *
+ * The pattern is matched against the calls to the mocks it names, merged in
+ * the order of their sequence numbers (see @ref CallSequence): "then" means
+ * the next call to one of these mocks, while the calls to other mocks are
+ * ignored. The matches are found like a regular expression search: the
+ * leftmost and longest match first, then the next one after it, without
+ * overlap. An empty match is never reported.
+ *
+ * The pattern is compiled to a nondeterministic automaton, which tries every
+ * match at once while the histories are merged. To know that a match is the
+ * longest, the automaton reads on until no attempt which started as early
+ * can extend it; the calls read after the end of the match are then read
+ * again, to search for the next match. With short matches, each call is
+ * read about once. A pattern whose attempts survive up to the last call,
+ * like first.then(CallPattern::anyCall().zeroOrMore()).then(last), may read
+ * the rest of the histories again after each match: n calls may take up to
+ * n * (n + 1) / 2 steps of the automaton. The matchers of the pattern
+ * must remain valid, like the mocks, while the pattern is used.
+ */
+class CallPattern
+{
+public:
+    /**
+     * Calls matched by the pattern
+     */
+    struct Match
+    {
+        CallSequence::Number first; /**< Sequence number of the first call */
+        CallSequence::Number last; /**< Sequence number of the last call */
+        unsigned int callCount; /**< Number of calls of the match */
+    };
+
+    /**
+     * Returns a pattern matching any call to the mocks of the pattern it is
+     * combined with, like "." in a regular expression.
+     *
+     * @return The pattern of any call
+     */
+    static CallPattern anyCall();
+
+    /**
+     * Returns a pattern matching the calls of this pattern, then the calls of
+     * another one.
+     *
+     * @param next The pattern of the next calls
+     * @return The concatenation of the patterns
+     */
+    CallPattern then(const CallPattern& next) const;
+
+    /**
+     * Returns a pattern matching the calls of this pattern or of another one.
+     *
+     * @param other The other pattern
+     * @return The alternative between the patterns
+     */
+    CallPattern or_(const CallPattern& other) const;
+
+    /**
+     * Returns a pattern matching the calls of this pattern, repeated one or
+     * more times.
+     *
+     * @return The repetition of the pattern
+     */
+    CallPattern oneOrMore() const;
+
+    /**
+     * Returns a pattern matching the calls of this pattern, repeated zero or
+     * more times.
+     *
+     * @return The repetition of the pattern
+     */
+    CallPattern zeroOrMore() const;
+
+    /**
+     * Returns a pattern matching the calls of this pattern, or no call.
+     *
+     * @return The optional pattern
+     */
+    CallPattern optional() const;
+
+    /**
+     * Returns the matches of the pattern in the histories of its mocks. The
+     * histories are locked during the search.
+     *
+     * @return The matches, in the order of the calls
+     */
+    std::vector<Match> matches() const;
+
+    /**
+     * Returns the number of matches of the pattern (see @ref matches).
+     *
+     * @return The number of matches
+     */
+    unsigned int count() const
+    {
+        return static_cast<unsigned int>(matches().size());
+    }
+
+private:
+    template<typename ReturnType, typename ... ArgumentTypes>
+    friend class Mock;
+
+    /**
+     * Pattern of a single call
+     */
+    struct Step
+    {
+        const MockCore* corePtr; /* nullptr for any call */
+        MockCore::RecordFilter filter;
+        std::shared_ptr<const void> queryPtr;
+    };
+
+    /**
+     * Node of the syntax tree of the pattern
+     */
+    struct Node
+    {
+        enum Kind
+        {
+            STEP,
+            SEQUENCE,
+            ALTERNATIVE,
+            ONE_OR_MORE,
+            ZERO_OR_MORE,
+            OPTIONAL
+        };
+
+        Kind kind;
+        Step step;
+        std::shared_ptr<const Node> firstPtr;
+        std::shared_ptr<const Node> secondPtr;
+    };
+
+    std::shared_ptr<const Node> rootPtr;
+
+    /**
+     * Constructor of CallPattern, for Mock::callWith.
+     *
+     * @param core The core of the mock
+     * @param filter The function matching the calls
+     * @param queryPtr The instance of argument matchers
+     */
+    CallPattern(const MockCore& core, MockCore::RecordFilter filter, const std::shared_ptr<const void>& queryPtr);
+
+    /**
+     * Constructor of CallPattern
+     *
+     * @param providedRootPtr The syntax tree of the pattern
+     */
+    CallPattern(const std::shared_ptr<const Node>& providedRootPtr);
+
+    /**
+     * Returns a pattern combining this pattern with another one.
+     *
+     * @param kind The kind of the combination
+     * @param otherPtr The other pattern, or nullptr for a repetition
+     * @return The combination
+     */
+    CallPattern combine(Node::Kind kind, const std::shared_ptr<const Node>& otherPtr) const;
+};
+
+#endif /* CALLPATTERN_HPP_ */
@@ -0,0 +1,78 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallSequence.hpp
+ * @brief Declaration of the class CallSequence
+ */
+
+#ifndef CALLSEQUENCE_HPP_
+#define CALLSEQUENCE_HPP_
+
+/**
+ * Global sequence of the calls to the mocks. Every call recorded by any mock
+ * gets the next sequence number, so that the order of calls to different
+ * mocks can be checked.
+ *
+ * Example, to check that ftp_setDataModel has been called before ftp_send:
+ *  assert(CallSequence::inOrder(
+ *      mock_ftp_setDataModel.firstCallIndex(ArgumentMatcher::eq<enum DataModel>(BINARY)),
+ *      mock_ftp_send.firstCallIndex(ArgumentMatcher::any<const char*>(),
+ *                                   ArgumentMatcher::any<unsigned int>())));
+ */
+class CallSequence
+{
+public:
+    /**
+     * Type of the sequence numbers
+     */
+    typedef unsigned long long Number;
+
+    /**
+     * Sequence number meaning "no call". It is greater than any sequence
+     * number given to a call.
+     */
+    static const Number NONE = ~0ULL;
+
+    /**
+     * Returns the sequence number of a new call. The first call gets 1.
+     *
+     * @return The sequence number of a new call
+     */
+    static Number next();
+
+    /**
+     * Returns whether the provided sequence numbers are the ones of actual
+     * calls, in strictly increasing order.
+     *
+     * @param first The first sequence number
+     * @return Whether the provided sequence numbers are the ones of actual
+     *         calls, in strictly increasing order
+     */
+    static bool inOrder(Number first)
+    {
+        return first != NONE;
+    }
+
+    /**
+     * Returns whether the provided sequence numbers are the ones of actual
+     * calls, in strictly increasing order.
+     *
+     * @param first The first sequence number
+     * @param second The second sequence number
+     * @param others The next sequence numbers
+     * @return Whether the provided sequence numbers are the ones of actual
+     *         calls, in strictly increasing order
+     */
+    template<typename ... OtherNumbers>
+    static bool inOrder(Number first, Number second, OtherNumbers ... others)
+    {
+        return first < second && inOrder(second, others...);
+    }
+};
+
+#endif /* CALLSEQUENCE_HPP_ */
@@ -0,0 +1,192 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file ControlPlane.hpp
+ * @brief Declaration of the classes ControlPlane and ControlClient
+ */
+
+#ifndef CONTROLPLANE_HPP_
+#define CONTROLPLANE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "internal/ControlRegion.hpp"
+
+/**
+ * Control of the named mocks of a running process (see BaseMock::setName)
+ * from another process, like the mockeur-ctl tool: a thread attaches a
+ * POSIX shared-memory region, through which a @ref ControlClient reads the
+ * call counts of the mocks, switches them between their behaviors (see
+ * Mock::addBehavior) and changes the values they return.
+ *
+ * The commands and the responses go through lock-free rings. The thread
+ * sleeps while no command is pending, and the changes of the mocks are
+ * published like those of Mock::beginUpdate: the calls to the mocks never
+ * wait for the control plane.
+ */
+class ControlPlane
+{
+public:
+    /**
+     * Constructor of ControlPlane. It creates the shared-memory region, or
+     * takes it over if a previous process left it, and starts the thread.
+     * A std::runtime_error is thrown if the region cannot be created, or if
+     * another living control plane is serving it.
+     *
+     * @param providedRegionName The name of the region, like "/my-simulator"
+     * @param providedPollInterval The time the thread sleeps when no command
+     *                             is pending
+     */
+    ControlPlane(const std::string& providedRegionName,
+                 std::chrono::milliseconds providedPollInterval = std::chrono::milliseconds(10));
+
+    /**
+     * Destructor of ControlPlane. It stops the thread and removes the region.
+     */
+    ~ControlPlane();
+
+    /**
+     * Returns the name of the shared-memory region.
+     *
+     * @return The name of the region
+     */
+    const std::string& regionName() const
+    {
+        return name;
+    }
+
+private:
+    std::string name;
+    std::chrono::milliseconds pollInterval;
+    ControlRegion* regionPtr;
+    std::atomic<bool> stopping;
+    std::thread controlThread;
+
+    /**
+     * Loop of the thread: executes the commands until the control plane is
+     * destroyed.
+     */
+    void run();
+
+    /**
+     * Executes a command and sends its responses.
+     *
+     * @param command The command
+     */
+    void execute(const ControlCommand& command);
+
+    /**
+     * Sends a response, waiting for the client to make room if needed.
+     *
+     * @param response The response
+     */
+    void respond(const ControlResponse& response);
+
+    ControlPlane(const ControlPlane&);
+    ControlPlane& operator=(const ControlPlane&);
+};
+
+/**
+ * Client of the @ref ControlPlane of another process (or of the same one).
+ * A region accepts a single client at a time. The methods throw a
+ * std::runtime_error when the command fails, or when the control plane does
+ * not respond in time.
+ */
+class ControlClient
+{
+public:
+    /**
+     * Call count of a mock
+     */
+    struct MockStatus
+    {
+        std::string name;
+        unsigned long long callCount;
+    };
+
+    /**
+     * Constructor of ControlClient. It attaches the region of a control
+     * plane; a std::runtime_error is thrown if there is none, or if another
+     * living process is attached to it.
+     *
+     * @param regionName The name of the region
+     * @param providedTimeout The maximum time to wait for a response
+     */
+    ControlClient(const std::string& regionName,
+                  std::chrono::milliseconds providedTimeout = std::chrono::milliseconds(2000));
+
+    /**
+     * Destructor of ControlClient. It detaches the region.
+     */
+    ~ControlClient();
+
+    /**
+     * Returns the named mocks and their call counts.
+     *
+     * @return The named mocks, in the order of their registration
+     */
+    std::vector<MockStatus> mocks();
+
+    /**
+     * Returns the number of calls to a mock since its construction (see
+     * BaseMock::callCount).
+     *
+     * @param mockName The name of the mock
+     * @return The number of calls to the mock
+     */
+    unsigned long long callCount(const std::string& mockName);
+
+    /**
+     * Switches a mock to one of its behaviors (see BaseMock::switchBehavior).
+     *
+     * @param mockName The name of the mock
+     * @param behaviorName The name of the behavior
+     */
+    void switchBehavior(const std::string& mockName, const std::string& behaviorName);
+
+    /**
+     * Makes a mock return a value for every call (see
+     * BaseMock::setReturnValue).
+     *
+     * @param mockName The name of the mock
+     * @param value The value, as text
+     */
+    void setReturnValue(const std::string& mockName, const std::string& value);
+
+private:
+    ControlRegion* regionPtr;
+    std::chrono::milliseconds timeout;
+
+    /**
+     * Sends a command.
+     *
+     * @param type The type of the command
+     * @param mockName The name of the mock, if any
+     * @param argument The argument of the command, if any
+     * @return The identifier of the command
+     */
+    std::uint32_t send(ControlCommand::Type type, const std::string& mockName, const std::string& argument);
+
+    /**
+     * Waits for the next response to a command. The responses to previous
+     * commands, left by a previous client, are skipped.
+     *
+     * @param id The identifier of the command
+     * @return The response
+     */
+    ControlResponse receive(std::uint32_t id);
+
+    ControlClient(const ControlClient&);
+    ControlClient& operator=(const ControlClient&);
+};
+
+#endif /* CONTROLPLANE_HPP_ */
@@ -0,0 +1,197 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file LookupTable.hpp
+ * @brief Declaration and definition of the classes LookupTable and
+ *        LookupTableBuilder
+ */
+
+#ifndef LOOKUPTABLE_HPP_
+#define LOOKUPTABLE_HPP_
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "TableFile.hpp"
+
+/**
+ * Tells whether a type can be a column of a lookup table: an integer, a
+ * floating-point number or an enumeration, compared by its bytes.
+ */
+template<typename ... Types>
+struct IsTableColumn;
+
+template<>
+struct IsTableColumn<>
+{
+    static const bool value = true;
+};
+
+template<typename Type, typename ... Types>
+struct IsTableColumn<Type, Types...>
+{
+    static const bool value = (std::is_arithmetic<Type>::value || std::is_enum<Type>::value)
+                              && IsTableColumn<Types...>::value;
+};
+
+/**
+ * Size in bytes of the key made of the arguments of a mock.
+ */
+template<typename ... Types>
+struct TableKeySize;
+
+template<>
+struct TableKeySize<>
+{
+    static const std::size_t value = 0;
+};
+
+template<typename Type, typename ... Types>
+struct TableKeySize<Type, Types...>
+{
+    static const std::size_t value = sizeof(Type) + TableKeySize<Types...>::value;
+};
+
+/**
+ * Writes the arguments of a call one after the other, to make the key of a
+ * lookup table.
+ *
+ * @param out Where to write the key, of TableKeySize bytes
+ * @param args The arguments
+ */
+template<typename ... ArgumentTypes>
+void packTableKey(unsigned char* out, ArgumentTypes ... args)
+{
+    std::size_t offset = 0;
+    /* The initializer list is evaluated from left to right */
+    int ignored[] = { 0, (std::memcpy(out + offset, &args, sizeof(args)), offset += sizeof(args), 0)... };
+
+    (void) ignored;
+    (void) offset;
+}
+
+/**
+ * Lookup table from the arguments of a mocked function to its return value,
+ * mapped in memory from a table file (see @ref TableFile). It is meant for
+ * large tables, like register maps, to stub with @ref Mock::whenInTable
+ * instead of thousands of calls to when and thenReturn.
+ *
+ * The arguments and the return value must be integers, floating-point
+ * numbers or enumerations. The file is written by a @ref LookupTableBuilder
+ * of the same types, or by the mockeur-table tool from a CSV file.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class LookupTable
+{
+    static_assert(IsTableColumn<ReturnType, ArgumentTypes...>::value,
+                  "The arguments and the return value of a lookup table must be numbers or enumerations");
+
+public:
+    /**
+     * Maps a table file in memory.
+     *
+     * @param path The path of the file
+     * @throws std::runtime_error if the file is not a table of these types
+     */
+    explicit LookupTable(const std::string& path)
+        : file(path)
+    {
+        if (file.keySize() != TableKeySize<ArgumentTypes...>::value || file.valueSize() != sizeof(ReturnType))
+            throw std::runtime_error("The table file " + path + " does not match the types of the mock");
+    }
+
+    /**
+     * Finds the value of a call.
+     *
+     * @param value Set to the value of the call, if found
+     * @param args The arguments of the call
+     * @return Whether the arguments are in the table
+     */
+    bool find(ReturnType& value, ArgumentTypes ... args) const
+    {
+        unsigned char key[TableKeySize<ArgumentTypes...>::value + 1];
+
+        packTableKey(key, args...);
+
+        const void* valuePtr = file.find(key);
+
+        if (valuePtr == nullptr)
+            return false;
+
+        std::memcpy(&value, valuePtr, sizeof(ReturnType));
+        return true;
+    }
+
+    /**
+     * Returns the number of rows of the table.
+     *
+     * @return The number of rows of the table
+     */
+    std::size_t size() const
+    {
+        return file.size();
+    }
+
+private:
+    TableFile file;
+};
+
+/**
+ * Builds the file of a @ref LookupTable from code.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class LookupTableBuilder
+{
+    static_assert(IsTableColumn<ReturnType, ArgumentTypes...>::value,
+                  "The arguments and the return value of a lookup table must be numbers or enumerations");
+
+public:
+    /**
+     * Constructor of LookupTableBuilder, without any row.
+     */
+    LookupTableBuilder()
+        : builder(TableKeySize<ArgumentTypes...>::value, sizeof(ReturnType))
+    {
+    }
+
+    /**
+     * Adds a row.
+     *
+     * @param value The value returned for the arguments
+     * @param args The arguments
+     */
+    void add(ReturnType value, ArgumentTypes ... args)
+    {
+        unsigned char key[TableKeySize<ArgumentTypes...>::value + 1];
+
+        packTableKey(key, args...);
+        builder.add(key, &value);
+    }
+
+    /**
+     * Writes the table file.
+     *
+     * @param path The path of the file
+     * @throws std::runtime_error if two rows have the same arguments or if the
+     *         file cannot be written
+     */
+    void write(const std::string& path) const
+    {
+        builder.write(path);
+    }
+
+private:
+    TableBuilder builder;
+};
+
+/* Needed by Mock::whenInTable */
+#include "internal/TableCallHandler.hpp"
+
+#endif /* LOOKUPTABLE_HPP_ */
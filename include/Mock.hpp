@@ -15,17 +15,43 @@
 #ifndef MOCK_HPP_
 #define MOCK_HPP_
 
-#include <list>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
+#include "BaseMock.hpp"
 #include "CallHandler.hpp"
+#include "CallPattern.hpp"
+#include "CallSequence.hpp"
 #include "AbstractCallEntry.hpp"
+#include "MockInstantiation.hpp"
 #include "MockPolicy.hpp"
+#include "ArgumentMatcher/AbstractCallMatcher.hpp"
+#include "ArgumentMatcher/TypeArgumentMatcher.hpp"
 #include "internal/AbstractCallHandler.hpp"
+#include "internal/CallFingerprint.hpp"
 #include "internal/DefaultMockPolicy.hpp"
+#include "internal/EpochReclaimer.hpp"
+#include "internal/HandlerSnapshot.hpp"
+#include "internal/MockCore.hpp"
+#include "internal/ValueParser.hpp"
+
+template<typename ReturnType, typename ... ArgumentTypes>
+class LookupTable;
+
+template<typename ReturnType, typename ... ArgumentTypes>
+class TableCallHandler;
 
 /**
  * This class is templatized on the return type of the mock and the instance of
- * the arguments types.
+ * the arguments types. It is a typed layer over a @ref MockCore, compiled once
+ * in the library, which stores the handlers and the history of any mock.
  * Example:
  *  For a function declared as:
  *   char *strncat(char *dest, const char *src, size_t n)
@@ -33,9 +59,25 @@
  *   Mock<char*, char*, const char*, size_t>
  */
 template<typename ReturnType, typename ... ArgumentTypes>
-class Mock
+class Mock: public BaseMock
 {
 public:
+    /**
+     * Shared and immutable configuration of the mock, see @ref snapshot.
+     */
+    typedef std::shared_ptr<const MockSnapshot<ReturnType, ArgumentTypes...> > Snapshot;
+
+    /**
+     * Arguments of calls with equal arguments, and their number, see
+     * @ref topCalls.
+     */
+    struct CallFrequency
+    {
+        std::tuple<ArgumentTypes...> arguments;
+        unsigned int count;
+        CallSequence::Number firstCall; /**< Sequence number of the first call */
+    };
+
     /**
      * Default constructor of mock object.
      *
@@ -43,33 +85,152 @@ public:
      *  - uses the "=" operator to store results for later comparisons
      *  - throws an exception whenever no instance of matchers match the
      *    arguments.
+     *
+     * The construction of a mock is a constant initialization: the policy,
+     * the handlers and the history are only created on first use.
      */
-    Mock();
+    constexpr Mock()
+        : Mock(nullptr)
+    {
+    }
 
     /**
      * Constructor of mock which will act following the rules of the provided
      * @ref MockPolicy
      *
-     * @param mockPolicyPtr A pointer to the mock policy to use
+     * @param mockPolicyPtr A pointer to the mock policy to use, or nullptr
+     *                      for the default policy
      */
-    Mock(MockPolicy<ReturnType, ArgumentTypes...>* providedMockPolicyPtr);
+    constexpr Mock(MockPolicy<ReturnType, ArgumentTypes...>* providedMockPolicyPtr)
+        : BaseMock(), initialPolicyPtr(providedMockPolicyPtr), statePtr(nullptr)
+    {
+    }
 
     /**
      * Destructor of mock
      */
     virtual ~Mock();
 
+    /**
+     * Change of the call handlers started by @ref replace, and published when
+     * the object is destroyed: at the end of the statement, unless it is
+     * kept. Example, to replace the behavior of a mock while other threads
+     * call it, without any moment where the mock has no handler:
+     *  mock_ftp_send.replace().when(ArgumentMatcher::any<const char*>(),
+     *                               ArgumentMatcher::any<unsigned int>())->thenReturn(-1);
+     */
+    class Update
+    {
+    public:
+        /**
+         * Move constructor of Update: the commit is left to the new object.
+         *
+         * @param other The moved update
+         */
+        Update(Update&& other)
+            : mockPtr(other.mockPtr)
+        {
+            other.mockPtr = nullptr;
+        }
+
+        /**
+         * Destructor of Update. It publishes the changes.
+         */
+        ~Update()
+        {
+            if (mockPtr != nullptr)
+                mockPtr->commitUpdate();
+        }
+
+        /**
+         * See Mock::when
+         */
+        CallHandler<ReturnType, ArgumentTypes...>* when(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
+        {
+            return mockPtr->when(matchersPtr...);
+        }
+
+        /**
+         * See Mock::when
+         */
+        CallHandler<ReturnType, ArgumentTypes...>* when(const AbstractCallMatcher* callMatcherPtr) const
+        {
+            return mockPtr->when(callMatcherPtr);
+        }
+
+    private:
+        friend class Mock;
+
+        Mock* mockPtr;
+
+        /**
+         * Constructor of Update. It starts an update of the mock.
+         *
+         * @param mock The updated mock
+         */
+        explicit Update(Mock& mock)
+            : mockPtr(&mock)
+        {
+            mock.beginUpdate();
+        }
+
+        Update(const Update&);
+        Update& operator=(const Update&);
+    };
+
     /**
      * Reset the mock to the initial state. The history and the instance of
      * arguments matchers are removed.
      */
     void clear();
 
+    /**
+     * @brief Removes the call handlers, to replace them while other threads
+     *        call the mock. Unlike @ref clear, the history of the calls is
+     *        kept.
+     *
+     * The removal of the handlers is published with the handlers added
+     * through the returned @ref Update, at the end of the statement: the
+     * threads calling the mock switch at once from the previous handlers to
+     * the new ones.
+     *
+     * @return The update of the handlers, published when it is destroyed
+     */
+    Update replace();
+
+    /**
+     * @brief Starts a change of the call handlers while other threads call
+     *        the mock.
+     *
+     * The threads calling the mock never wait for the changes of the
+     * handlers, nor see a partial change: each change publishes a new list of
+     * handlers, and the removed handlers are deleted once no thread uses
+     * them. A handler returned by @ref when is only published once it is
+     * configured by a then* method. Until @ref commitUpdate, the changes
+     * (when, whenInTable, clear, replace, snapshot and restore) are not
+     * published, so that the calls switch at once to a whole new
+     * configuration. The updates may be nested.
+     *
+     * Only the lookup of the handlers is free of locks: each call still takes
+     * the lock of the history of the mock to record itself, which the
+     * queries of the history (numberOfCalls, CallPattern::matches,
+     * waitForCalls...) also hold while they read it.
+     */
+    void beginUpdate();
+
+    /**
+     * Publishes the changes of the handlers made since @ref beginUpdate.
+     */
+    void commitUpdate();
+
     /**
      * @brief Initialize the mock to match some arguments with an instance of
      *        argument matchers. It returns a new @ref CallHandler which must
      *        be initialized to return the expected value.
      *
+     * The calls only see the handler once it is initialized, so that it may
+     * be added while other threads call the mock.
+     *
      * @param matchersPtr Pointers to argument matchers (the instance of
      *                    argument matchers).
      * @return A call handler which will match the same arguments as the
@@ -77,6 +238,84 @@ public:
      */
     CallHandler<ReturnType, ArgumentTypes...>* when(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr);
 
+    /**
+     * @brief Initialize the mock to match the calls accepted by a matcher of
+     *        several arguments at once, like ArgumentMatcher::bytesEq. It
+     *        throws a std::runtime_error if the matcher cannot read the
+     *        arguments of the mock.
+     *
+     * @param callMatcherPtr Pointer to the call matcher
+     * @return A call handler which will match the same calls as the call
+     *         matcher.
+     */
+    CallHandler<ReturnType, ArgumentTypes...>* when(const AbstractCallMatcher* callMatcherPtr);
+
+    /**
+     * @brief Initialize the mock to match the calls whose arguments are in a
+     *        lookup table, and to return the value of the table (see
+     *        LookupTable.hpp, which must be included).
+     *
+     * Like a call handler returned by @ref when, the table is tried after the
+     * handlers instantiated before it. The table is searched once per call,
+     * with a binary search.
+     *
+     * @param tablePtr The lookup table, which may be shared with other mocks
+     */
+    template<typename TableReturnType>
+    void whenInTable(const std::shared_ptr<const LookupTable<TableReturnType, ArgumentTypes...> >& tablePtr);
+
+    /**
+     * @brief Returns the current configuration of the mock (its call
+     *        handlers), to restore it later with @ref restore.
+     *
+     * The handlers are not copied: they are moved to the snapshot, which is
+     * shared by the mock and by every copy of the snapshot. The handlers added
+     * after the snapshot are kept apart, so that restoring the snapshot only
+     * deletes them. A handler of a snapshot must not be configured again.
+     *
+     * @return The configuration of the mock
+     */
+    Snapshot snapshot();
+
+    /**
+     * @brief Resets the mock like @ref clear, then restores the configuration
+     *        of a snapshot, without copying its handlers.
+     *
+     * The snapshot has its own list of handlers, built once when it is taken,
+     * which the mock publishes again as it is: restoring a snapshot allocates
+     * nothing when no handler has been added since, and otherwise only
+     * retires the added handlers, whatever the size of the snapshot.
+     *
+     * The handlers of the snapshot which inject faults are brought back to
+     * their state as configured, so that the same calls fail again, starting
+     * over from their first call: the calls they answered before the
+     * snapshot was taken are not skipped.
+     *
+     * @param providedSnapshot A snapshot of a mock of the same type
+     */
+    void restore(const Snapshot& providedSnapshot);
+
+    /**
+     * @brief Names a configuration of the mock, to switch to it later with
+     *        BaseMock::switchBehavior, like the @ref ControlPlane does.
+     *
+     * Unlike @ref restore, switching to a behavior keeps the history of the
+     * calls, and may be done while other threads call the mock.
+     *
+     * @param behaviorName The name of the behavior
+     * @param behavior A snapshot of the configuration (see @ref snapshot)
+     */
+    void addBehavior(const std::string& behaviorName, const Snapshot& behavior);
+
+    /**
+     * @brief Replaces the call handlers by one returning a value for every
+     *        call (see BaseMock::setReturnValue).
+     *
+     * @param text The value, as text
+     * @return Whether the value has been read and set
+     */
+    bool setReturnValue(const std::string& text);
+
     /**
      * @brief Returns the number of calls to this mock which are matched by the
      *        provided instance of argument matchers.
@@ -91,6 +330,112 @@ public:
      */
     unsigned int numberOfCalls(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const;
 
+    /**
+     * @brief Returns the number of calls to this mock which are matched by a
+     *        matcher of several arguments at once. It throws a
+     *        std::runtime_error if the matcher cannot read the arguments of
+     *        the mock.
+     *
+     * @param callMatcherPtr Pointer to the call matcher
+     * @return The number of calls matched by the call matcher.
+     */
+    unsigned int numberOfCalls(const AbstractCallMatcher* callMatcherPtr) const;
+
+    /**
+     * @brief Returns the sequence number (see @ref CallSequence) of the first
+     *        call to this mock which is matched by the provided instance of
+     *        argument matchers.
+     *
+     * @param matchersPtr Pointers to argument matchers (the instance of argument
+     *                    matchers).
+     *
+     * @return The sequence number of the first matched call, or
+     *         CallSequence::NONE if no call is matched.
+     */
+    CallSequence::Number firstCallIndex(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const;
+
+    /**
+     * @brief Returns the sequence number (see @ref CallSequence) of the last
+     *        call to this mock which is matched by the provided instance of
+     *        argument matchers.
+     *
+     * @param matchersPtr Pointers to argument matchers (the instance of argument
+     *                    matchers).
+     *
+     * @return The sequence number of the last matched call, or
+     *         CallSequence::NONE if no call is matched.
+     */
+    CallSequence::Number lastCallIndex(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const;
+
+    /**
+     * @brief Returns the sequence number (see @ref CallSequence) of the first
+     *        call to this mock which happened after the provided sequence
+     *        number and which is matched by the provided instance of argument
+     *        matchers.
+     *
+     * The calls preceding the provided sequence number are skipped with a
+     * binary search.
+     *
+     * @param after The sequence number after which the calls are searched
+     * @param matchersPtr Pointers to argument matchers (the instance of argument
+     *                    matchers).
+     *
+     * @return The sequence number of the first matched call, or
+     *         CallSequence::NONE if no call is matched.
+     */
+    CallSequence::Number nextCallIndex(CallSequence::Number after,
+                                       AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const;
+
+    /**
+     * @brief Returns the number of calls to this mock which happened strictly
+     *        between the two provided sequence numbers and which are matched
+     *        by the provided instance of argument matchers.
+     *
+     * The bounds are found with a binary search: only the calls between them
+     * are checked by the matchers.
+     *
+     * @param after The sequence number after which the calls are counted
+     * @param before The sequence number before which the calls are counted
+     * @param matchersPtr Pointers to argument matchers (the instance of argument
+     *                    matchers).
+     *
+     * @return The number of matched calls between the two sequence numbers.
+     */
+    unsigned int callsBetween(CallSequence::Number after, CallSequence::Number before,
+                              AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const;
+
+    /**
+     * @brief Returns a pattern (see @ref CallPattern) matching a call to this
+     *        mock with arguments matched by the provided instance of argument
+     *        matchers.
+     *
+     * @param matchersPtr Pointers to argument matchers (the instance of argument
+     *                    matchers). They must remain valid while the pattern is
+     *                    used.
+     *
+     * @return The pattern of the call, to be combined with other patterns.
+     */
+    CallPattern callWith(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const;
+
+    /**
+     * @brief Waits until the mock has been called a number of times with
+     *        arguments matched by the provided instance of argument matchers,
+     *        for code under test which calls the mock from other threads.
+     *
+     * The calls recorded before the wait are counted. The waiting thread is
+     * woken by the calls to the mock, which only signal it while a thread is
+     * waiting.
+     *
+     * @param count The number of calls to wait for
+     * @param matchersPtr Pointers to argument matchers (the instance of argument
+     *                    matchers).
+     * @param timeout The maximum time to wait
+     *
+     * @return Whether the number of calls has been reached before the timeout
+     */
+    bool waitForCalls(unsigned int count, AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr,
+                      std::chrono::nanoseconds timeout);
+
     /**
      * @brief Returns the value which has been stored for the provided instance
      *        of arguments.
@@ -109,7 +454,79 @@ public:
      * @return The value which has been stored/computed for the provided
      *         instance of arguments.
      */
-    ReturnType value(ArgumentTypes ... args);
+    MOCKEUR_ALWAYS_INLINE ReturnType value(ArgumentTypes ... args);
+
+    /**
+     * @brief Enables or disables the recording of a 64-bit fingerprint (a
+     *        hash of the arguments) with each call. It is disabled by default,
+     *        and only available when the arguments are integers, enumerations,
+     *        floating-point numbers or pointers (a std::runtime_error is thrown
+     *        otherwise).
+     *
+     * The calls already recorded get their fingerprint too. Then the queries
+     * of @ref numberOfCalls which match a single value per argument (with
+     * ArgumentMatcher::eq) only check the calls with the same fingerprint,
+     * and @ref distinctCalls and @ref topCalls are available.
+     *
+     * @param enabled Whether the fingerprints must be recorded
+     */
+    void recordFingerprints(bool enabled);
+
+    /**
+     * @brief Hashes a buffer passed as a pointer and a length by content
+     *        instead of by address in the fingerprints of the calls (see
+     *        @ref recordFingerprints). It throws a std::runtime_error if the
+     *        arguments are not a pointer and an integer.
+     *
+     * Then the calls sending the same bytes from different buffers are equal
+     * for @ref distinctCalls and @ref topCalls, and the queries of
+     * @ref numberOfCalls with ArgumentMatcher::bytesEq on the pair check the
+     * fingerprints, when the pair is the only arguments. The queries with
+     * ArgumentMatcher::eq, which compare addresses, no longer do.
+     *
+     * @param pointerPosition The position of the pointer argument
+     * @param lengthPosition The position of the length argument
+     */
+    void fingerprintContent(std::size_t pointerPosition, std::size_t lengthPosition);
+
+    /**
+     * @brief Enables or disables the compression of the history: a call with
+     *        the same arguments (with the "==" operator) as the previous call
+     *        to the mock is added to its entry, as a repeat count, instead of
+     *        creating an entry. It is disabled by default, and only available
+     *        when the arguments can be compared (a std::runtime_error is
+     *        thrown otherwise).
+     *
+     * The sequence number of each call is kept (see @ref CallSequence), so
+     * that the queries on the order of the calls give the same results. An
+     * entry stores nothing more while the sequence numbers of its calls are
+     * evenly spaced, like the calls of a polling loop which only calls this
+     * mock; once the spacing changes, like when the loop calls other mocks a
+     * variable number of times, each further call takes a byte or two. The
+     * calls already recorded are kept as they are.
+     *
+     * @param enabled Whether the consecutive identical calls must be
+     *                compressed
+     */
+    void compressRepeatedCalls(bool enabled);
+
+    /**
+     * Returns the number of distinct instances of arguments among the calls,
+     * by fingerprint (see @ref recordFingerprints, which must be enabled).
+     *
+     * @return The number of distinct instances of arguments
+     */
+    unsigned int distinctCalls() const;
+
+    /**
+     * Returns the most frequent instances of arguments among the calls, by
+     * fingerprint (see @ref recordFingerprints, which must be enabled), the
+     * most frequent first.
+     *
+     * @param maximumCount The maximum number of instances to return
+     * @return The most frequent instances of arguments
+     */
+    std::vector<CallFrequency> topCalls(unsigned int maximumCount) const;
 
     /**
      * Set the policy of the mock
@@ -118,62 +535,322 @@ public:
      */
     void setPolicy(MockPolicy<ReturnType, ArgumentTypes...>* providedMockPolicyPtr);
 
+protected:
+    /**
+     * Called at the end of @ref clear, so that a derived mock resets its own
+     * state even when it is cleared through a reference to Mock.
+     */
+    virtual void cleared()
+    {
+    }
+
 private:
-    MockPolicy<ReturnType, ArgumentTypes...>* mockPolicyPtr;
-    std::list<CallHandler<ReturnType, ArgumentTypes...>*> callHandlerList;
-    std::list<AbstractCallEntry<ArgumentTypes...>*> callHistoryList;
-    bool policyOwner; /* Used to know whether the current class must delete itself the mock policy object */
+    /**
+     * What the mock allocates, created on first use (see @ref state)
+     */
+    struct State
+    {
+        MockPolicy<ReturnType, ArgumentTypes...>* mockPolicyPtr;
+        bool policyOwner; /* Used to know whether the current class must delete itself the mock policy object */
+        MockCore core;
+        CallFingerprinter<ArgumentTypes...> fingerprinter;
+
+        /**
+         * Constructor of State
+         *
+         * @param providedMockPolicyPtr The policy of the mock, or nullptr to
+         *                              create the default one
+         */
+        State(MockPolicy<ReturnType, ArgumentTypes...>* providedMockPolicyPtr);
+
+        /**
+         * Destructor of State. It deletes the policy if it is the default
+         * one.
+         */
+        ~State();
+    };
+
+    /* The policy given to the constructor, until the state is created */
+    MockPolicy<ReturnType, ArgumentTypes...>* initialPolicyPtr;
+    mutable std::atomic<State*> statePtr;
+
+    /**
+     * Returns the state of the mock, created on first use.
+     *
+     * @return The state of the mock
+     */
+    State& state() const
+    {
+        State* createdStatePtr = statePtr.load(std::memory_order_acquire);
+
+        return createdStatePtr != nullptr ? *createdStatePtr : createState();
+    }
+
+    /**
+     * Creates the state of the mock, unless another thread creates it first.
+     *
+     * @return The state of the mock
+     */
+    State& createState() const;
+
+    AbstractCallHandler<ReturnType, ArgumentTypes...>* getMatchingHandler(State& mockState,
+                                                                        ArgumentTypes ... args) const;
 
-    AbstractCallHandler<ReturnType, ArgumentTypes...>* getMatchingHandler(ArgumentTypes ... args) const;
+    /**
+     * Implementation of @ref value.
+     *
+     * @param callerAddress The return address of the mocked function
+     * @param args The arguments of the call to the mock
+     *
+     * @return The value which has been stored/computed for the provided
+     *         instance of arguments.
+     */
+    ReturnType valueFrom(const void* callerAddress, ArgumentTypes ... args);
+
+    /**
+     * Replaces the handlers by those of a snapshot, and publishes them.
+     *
+     * @param providedSnapshot A snapshot of a mock of the same type
+     */
+    void useSnapshot(const Snapshot& providedSnapshot);
+
+    /**
+     * Implementation of @ref setReturnValue, when the value can be read.
+     *
+     * @param text The value, as text
+     * @return Whether the value has been read and set
+     */
+    template<typename ValueType>
+    bool setParsedReturnValue(const std::string& text, std::true_type);
+
+    template<typename ValueType>
+    bool setParsedReturnValue(const std::string&, std::false_type)
+    {
+        return false;
+    }
+
+    /**
+     * Removes the history of the calls.
+     */
+    void clearCalls();
+
+    /**
+     * Tells the @ref MockCore whether a call is matched by an instance of
+     * argument matchers.
+     *
+     * @param queryPtr The instance of argument matchers
+     * @param record A call of the history of the mock
+     * @return Whether the call is matched
+     */
+    static bool acceptedBy(const void* queryPtr, const CallRecord& record)
+    {
+        return static_cast<const AbstractCallEntry<ArgumentTypes...>&>(record).acceptedBy(
+            *static_cast<const ArgumentMatchers<ArgumentTypes...>*>(queryPtr));
+    }
+
+    /**
+     * Computes the fingerprint of a call for the @ref MockCore.
+     *
+     * @param fingerprinterPtr The fingerprinter of the mock
+     * @param record A call of the history of the mock
+     * @return The fingerprint of the call
+     */
+    static std::uint64_t fingerprintOf(const void* fingerprinterPtr, const CallRecord& record)
+    {
+        return static_cast<const CallFingerprinter<ArgumentTypes...>*>(fingerprinterPtr)->of(
+            static_cast<const AbstractCallEntry<ArgumentTypes...>&>(record).arguments());
+    }
 };
 
 template<typename ReturnType, typename ... ArgumentTypes>
-Mock<ReturnType, ArgumentTypes...>::Mock()
-    : Mock<ReturnType, ArgumentTypes...>::Mock(new DefaultMockPolicy<ReturnType, ArgumentTypes...>)
+Mock<ReturnType, ArgumentTypes...>::State::State(MockPolicy<ReturnType, ArgumentTypes...>* providedMockPolicyPtr)
+    : mockPolicyPtr(providedMockPolicyPtr), policyOwner(providedMockPolicyPtr == nullptr), core(), fingerprinter()
 {
-    policyOwner = true;
+    if (policyOwner)
+        mockPolicyPtr = new DefaultMockPolicy<ReturnType, ArgumentTypes...>;
 }
 
 template<typename ReturnType, typename ... ArgumentTypes>
-Mock<ReturnType, ArgumentTypes...>::Mock(MockPolicy<ReturnType, ArgumentTypes...>* providedMockPolicyPtr)
-    : mockPolicyPtr(providedMockPolicyPtr), callHandlerList(), callHistoryList(), policyOwner(false)
+Mock<ReturnType, ArgumentTypes...>::State::~State()
 {
+    if (policyOwner) {
+        mockPolicyPtr->clear();
+
+        delete mockPolicyPtr;
+    }
 }
 
 template<typename ReturnType, typename ... ArgumentTypes>
 Mock<ReturnType, ArgumentTypes...>::~Mock()
 {
-    for (auto it = callHandlerList.begin(); it != callHandlerList.end(); ++it)
-        delete *it;
+    /* Nor can the control plane reach it once it is unregistered */
+    unregister();
 
-    callHandlerList.clear();
-
-    callHistoryList.clear();
+    delete statePtr.load();
+}
 
-    if (policyOwner) {
-        mockPolicyPtr->clear();
+template<typename ReturnType, typename ... ArgumentTypes>
+typename Mock<ReturnType, ArgumentTypes...>::State& Mock<ReturnType, ArgumentTypes...>::createState() const
+{
+    State* newStatePtr = new State(initialPolicyPtr);
+    State* createdStatePtr = nullptr;
 
-        delete mockPolicyPtr;
+    if (!statePtr.compare_exchange_strong(createdStatePtr, newStatePtr)) {
+        delete newStatePtr;
+        return *createdStatePtr;
     }
+
+    return *newStatePtr;
 }
 
 template<typename ReturnType, typename ... ArgumentTypes>
 inline CallHandler<ReturnType, ArgumentTypes...> * Mock<ReturnType, ArgumentTypes...>::when(
     AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr)
 {
+    State& mockState = state();
+
     CallHandler<ReturnType, ArgumentTypes...> *callHandlerPtr = new CallHandler<ReturnType, ArgumentTypes...>(
         matchersPtr...);
-    callHandlerList.push_back(callHandlerPtr);
+
+    mockState.core.addPendingHandler(callHandlerPtr);
 
     return callHandlerPtr;
 }
 
 template<typename ReturnType, typename ... ArgumentTypes>
-ReturnType Mock<ReturnType, ArgumentTypes...>::value(ArgumentTypes ... args)
+CallHandler<ReturnType, ArgumentTypes...>* Mock<ReturnType, ArgumentTypes...>::when(
+    const AbstractCallMatcher* callMatcherPtr)
+{
+    State& mockState = state();
+
+    callMatcherPtr->checkTypes(ArgumentTypeList<ArgumentTypes...>::types, sizeof...(ArgumentTypes));
+
+    CallHandler<ReturnType, ArgumentTypes...>* callHandlerPtr = new CallHandler<ReturnType, ArgumentTypes...>(
+        TypeArgumentMatcher<ArgumentTypes>::shared()...);
+
+    callHandlerPtr->matchCall(callMatcherPtr);
+    mockState.core.addPendingHandler(callHandlerPtr);
+
+    return callHandlerPtr;
+}
+
+/* A member template, so that the explicit instantiations of the mock do not
+ * instantiate the lookup table for any type of argument. */
+template<typename ReturnType, typename ... ArgumentTypes>
+template<typename TableReturnType>
+void Mock<ReturnType, ArgumentTypes...>::whenInTable(
+    const std::shared_ptr<const LookupTable<TableReturnType, ArgumentTypes...> >& tablePtr)
+{
+    State& mockState = state();
+
+    mockState.core.addHandler(new TableCallHandler<ReturnType, ArgumentTypes...>(tablePtr));
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+typename Mock<ReturnType, ArgumentTypes...>::Snapshot Mock<ReturnType, ArgumentTypes...>::snapshot()
+{
+    State& mockState = state();
+
+    /* The core only holds snapshots created by this factory */
+    return std::static_pointer_cast<const MockSnapshot<ReturnType, ArgumentTypes...> >(
+        mockState.core.snapshot(&MockSnapshot<ReturnType, ArgumentTypes...>::create));
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::restore(const Snapshot& providedSnapshot)
+{
+    useSnapshot(providedSnapshot);
+    clearCalls();
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::addBehavior(const std::string& behaviorName, const Snapshot& behavior)
 {
-    AbstractCallHandler<ReturnType, ArgumentTypes...>* callHandlerPtr = getMatchingHandler(args...);
+    defineBehavior(behaviorName, [this, behavior] () {
+        useSnapshot(behavior);
+    });
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+bool Mock<ReturnType, ArgumentTypes...>::setReturnValue(const std::string& text)
+{
+    return setParsedReturnValue<ReturnType>(text, std::integral_constant<bool, ValueParser<ReturnType>::SUPPORTED>());
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+template<typename ValueType>
+bool Mock<ReturnType, ArgumentTypes...>::setParsedReturnValue(const std::string& text, std::true_type)
+{
+    State& mockState = state();
+
+    ValueType value;
+
+    if (!ValueParser<ValueType>::parse(text, value))
+        return false;
+
+    CallHandler<ReturnType, ArgumentTypes...>* callHandlerPtr = new CallHandler<ReturnType, ArgumentTypes...>(
+        TypeArgumentMatcher<ArgumentTypes>::shared()...);
+
+    callHandlerPtr->thenReturn(value);
 
-    callHistoryList.push_back(mockPolicyPtr->create(args...));
+    mockState.core.replaceHandlers(callHandlerPtr);
+
+    return true;
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::beginUpdate()
+{
+    state().core.beginUpdate();
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::commitUpdate()
+{
+    state().core.commitUpdate();
+}
+
+/* The method is always inlined in the mocked function, so that the return
+ * address is the one of the mocked function, that is to say the call site in
+ * the code under test. */
+template<typename ReturnType, typename ... ArgumentTypes>
+MOCKEUR_ALWAYS_INLINE ReturnType Mock<ReturnType, ArgumentTypes...>::value(ArgumentTypes ... args)
+{
+    return valueFrom(MOCKEUR_RETURN_ADDRESS(), args...);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+ReturnType Mock<ReturnType, ArgumentTypes...>::valueFrom(const void* callerAddress, ArgumentTypes ... args)
+{
+    State& mockState = state();
+
+    /* The handlers read by the call are not deleted until it returns */
+    EpochGuard epochGuard;
+    AbstractCallHandler<ReturnType, ArgumentTypes...>* callHandlerPtr = getMatchingHandler(mockState, args...);
+
+    {
+        std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+        const CallSequence::Number sequenceNumber = CallSequence::next();
+        CallRecord* lastRecordPtr = mockState.core.repeatableRecord();
+
+        /* A repeated call only increments the count of the last entry */
+        if (lastRecordPtr == nullptr
+            || !static_cast<AbstractCallEntry<ArgumentTypes...>*>(lastRecordPtr)->sameArguments(args...)) {
+            AbstractCallEntry<ArgumentTypes...>* callEntryPtr = mockState.mockPolicyPtr->create(args...);
+
+            callEntryPtr->setSequenceNumber(sequenceNumber);
+            mockState.core.append(callEntryPtr, mockState.core.fingerprintsRecorded()
+                                                ? mockState.fingerprinter.of(std::forward_as_tuple(args...)) : 0);
+        } else {
+            lastRecordPtr->repeat(sequenceNumber);
+        }
+
+        countCall();
+        timestampCall(sequenceNumber);
+        attributeCall(callerAddress);
+
+        mockState.core.notifyRecorded();
+    }
 
     return callHandlerPtr->value(args...);
 }
@@ -182,50 +859,248 @@ template<typename ReturnType, typename ... ArgumentTypes>
 unsigned int Mock<ReturnType, ArgumentTypes...>::numberOfCalls(
     AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
 {
-    unsigned int nbrCall = 0;
+    State& mockState = state();
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+    const ArgumentMatchers<ArgumentTypes...> query(matchersPtr...);
+    std::uint64_t fingerprint;
 
-    for (AbstractCallEntry<ArgumentTypes...>* callArgument : callHistoryList) {
-        if (callArgument->acceptedBy(matchersPtr...))
-            nbrCall++;
-    }
+    /* Only the calls with the same fingerprint may be matched */
+    const bool fixedValues = mockState.core.fingerprintsRecorded()
+                             && mockState.fingerprinter.ofFixedValues(fingerprint, matchersPtr...);
 
-    return nbrCall;
+    return mockState.core.countCalls(&acceptedBy, &query, fixedValues ? &fingerprint : nullptr, query.threadSafe());
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+unsigned int Mock<ReturnType, ArgumentTypes...>::numberOfCalls(const AbstractCallMatcher* callMatcherPtr) const
+{
+    State& mockState = state();
+
+    callMatcherPtr->checkTypes(ArgumentTypeList<ArgumentTypes...>::types, sizeof...(ArgumentTypes));
+
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+    ArgumentMatchers<ArgumentTypes...> query(TypeArgumentMatcher<ArgumentTypes>::shared()...);
+    std::uint64_t fingerprint;
+
+    query.setCallMatcher(callMatcherPtr);
+
+    const bool fixedCall = mockState.core.fingerprintsRecorded()
+                           && mockState.fingerprinter.ofFixedCall(fingerprint, *callMatcherPtr);
+
+    return mockState.core.countCalls(&acceptedBy, &query, fixedCall ? &fingerprint : nullptr, query.threadSafe());
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+CallSequence::Number Mock<ReturnType, ArgumentTypes...>::firstCallIndex(
+    AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
+{
+    return nextCallIndex(0, matchersPtr...);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+CallSequence::Number Mock<ReturnType, ArgumentTypes...>::lastCallIndex(
+    AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
+{
+    State& mockState = state();
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+    const ArgumentMatchers<ArgumentTypes...> query(matchersPtr...);
+
+    return mockState.core.lastCall(&acceptedBy, &query);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+CallSequence::Number Mock<ReturnType, ArgumentTypes...>::nextCallIndex(
+    CallSequence::Number after, AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
+{
+    State& mockState = state();
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+    const ArgumentMatchers<ArgumentTypes...> query(matchersPtr...);
+
+    return mockState.core.nextCall(after, &acceptedBy, &query);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+unsigned int Mock<ReturnType, ArgumentTypes...>::callsBetween(
+    CallSequence::Number after, CallSequence::Number before,
+    AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
+{
+    State& mockState = state();
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+    const ArgumentMatchers<ArgumentTypes...> query(matchersPtr...);
+
+    return mockState.core.callsBetween(after, before, &acceptedBy, &query);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+CallPattern Mock<ReturnType, ArgumentTypes...>::callWith(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
+{
+    State& mockState = state();
+
+    return CallPattern(mockState.core, &acceptedBy,
+                       std::make_shared<const ArgumentMatchers<ArgumentTypes...>>(matchersPtr...));
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+bool Mock<ReturnType, ArgumentTypes...>::waitForCalls(unsigned int count,
+                                                      AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr,
+                                                      std::chrono::nanoseconds timeout)
+{
+    State& mockState = state();
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(mockState.core.historyMutex());
+    const ArgumentMatchers<ArgumentTypes...> query(matchersPtr...);
+
+    return mockState.core.waitForCalls(lock, count, &acceptedBy, &query, deadline);
 }
 
 template<typename ReturnType, typename ... ArgumentTypes>
 void Mock<ReturnType, ArgumentTypes...>::setPolicy(MockPolicy<ReturnType, ArgumentTypes...>* providedMockPolicyPtr)
 {
-    if (policyOwner) {
-        delete mockPolicyPtr;
+    State* createdStatePtr = statePtr.load(std::memory_order_acquire);
+
+    /* The default policy is not created if the state is not */
+    if (createdStatePtr == nullptr) {
+        initialPolicyPtr = providedMockPolicyPtr;
+        return;
+    }
+
+    if (createdStatePtr->policyOwner) {
+        delete createdStatePtr->mockPolicyPtr;
     }
 
-    mockPolicyPtr = providedMockPolicyPtr;
-    policyOwner = false;
+    createdStatePtr->mockPolicyPtr = providedMockPolicyPtr;
+    createdStatePtr->policyOwner = false;
 }
 
 template<typename ReturnType, typename ... ArgumentTypes>
 void Mock<ReturnType, ArgumentTypes...>::clear()
 {
-    for (auto it = callHandlerList.begin(); it != callHandlerList.end(); ++it)
-        delete *it;
+    state().core.clearHandlers();
 
-    callHandlerList.clear();
+    clearCalls();
+    cleared();
+}
 
-    callHistoryList.clear();
+template<typename ReturnType, typename ... ArgumentTypes>
+typename Mock<ReturnType, ArgumentTypes...>::Update Mock<ReturnType, ArgumentTypes...>::replace()
+{
+    Update update(*this);
+
+    state().core.clearHandlers();
 
-    mockPolicyPtr->clear();
+    return update;
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::useSnapshot(const Snapshot& providedSnapshot)
+{
+    state().core.useSnapshot(providedSnapshot);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::clearCalls()
+{
+    State& mockState = state();
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+
+    mockState.core.clearHistory();
+
+    clearTimestamps();
+
+    clearCallSites();
+
+    mockState.mockPolicyPtr->clear();
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::recordFingerprints(bool enabled)
+{
+    State& mockState = state();
+
+    if (enabled && !CallFingerprinter<ArgumentTypes...>::SUPPORTED)
+        throw std::runtime_error("The arguments of the mock cannot be fingerprinted");
+
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+
+    mockState.core.setFingerprints(enabled, &fingerprintOf, &mockState.fingerprinter);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::fingerprintContent(std::size_t pointerPosition, std::size_t lengthPosition)
+{
+    State& mockState = state();
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+
+    mockState.fingerprinter.addContent(pointerPosition, lengthPosition);
+    mockState.core.computeFingerprints(&fingerprintOf, &mockState.fingerprinter);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+void Mock<ReturnType, ArgumentTypes...>::compressRepeatedCalls(bool enabled)
+{
+    State& mockState = state();
+
+    if (enabled && !AllEqualityComparable<ArgumentTypes...>::value)
+        throw std::runtime_error("The arguments of the mock cannot be compared");
+
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+
+    mockState.core.setCompression(enabled);
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+unsigned int Mock<ReturnType, ArgumentTypes...>::distinctCalls() const
+{
+    State& mockState = state();
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+
+    return mockState.core.distinctCalls();
+}
+
+template<typename ReturnType, typename ... ArgumentTypes>
+std::vector<typename Mock<ReturnType, ArgumentTypes...>::CallFrequency> Mock<ReturnType, ArgumentTypes...>::topCalls(
+    unsigned int maximumCount) const
+{
+    State& mockState = state();
+    std::lock_guard<std::mutex> lock(mockState.core.historyMutex());
+    std::vector<CallFrequency> frequencies;
+
+    for (const MockCore::RecordFrequency& recordFrequency : mockState.core.topRecords(maximumCount)) {
+        const CallFrequency frequency = {
+            static_cast<const AbstractCallEntry<ArgumentTypes...>*>(recordFrequency.recordPtr)->arguments(),
+            recordFrequency.count, recordFrequency.recordPtr->sequenceNumber() };
+
+        frequencies.push_back(frequency);
+    }
+
+    return frequencies;
 }
 
 template<typename ReturnType, typename ... ArgumentTypes>
 AbstractCallHandler<ReturnType, ArgumentTypes...>* Mock<ReturnType, ArgumentTypes...>::getMatchingHandler(
-    ArgumentTypes ... args) const
+    State& mockState, ArgumentTypes ... args) const
 {
-    for (CallHandler<ReturnType, ArgumentTypes...>* callHandlerPtr : callHandlerList) {
-        if (callHandlerPtr->matchArguments(args...))
-            return callHandlerPtr;
+    const HandlerVersion* versionPtr = mockState.core.publishedHandlers();
+
+    /* The core only holds the handlers of this mock */
+    if (versionPtr != nullptr) {
+        for (BaseCallHandler* handlerPtr : versionPtr->handlers()) {
+            CallHandler<ReturnType, ArgumentTypes...>* callHandlerPtr =
+                static_cast<CallHandler<ReturnType, ArgumentTypes...>*>(handlerPtr);
+
+            if (callHandlerPtr->matchArguments(args...))
+                return callHandlerPtr;
+        }
     }
 
-    return mockPolicyPtr->getHandler(args...);
+    return mockState.mockPolicyPtr->getHandler(args...);
 }
 
+/* The common signatures are instantiated in the mockeur library. Define
+ * MOCKEUR_NO_EXTERN_TEMPLATES to instantiate them in each compilation unit
+ * instead. */
+#ifndef MOCKEUR_NO_EXTERN_TEMPLATES
+MOCKEUR_COMMON_SIGNATURES(MOCKEUR_EXTERN_TEMPLATE)
+#endif
+
 #endif /* MOCK_HPP_ */
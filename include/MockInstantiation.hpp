@@ -0,0 +1,76 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockInstantiation.hpp
+ * @brief Macros to instantiate the mock templates for a signature once, in a
+ *        single compilation unit, instead of in every compilation unit using
+ *        it.
+ *
+ * In a header included by every test of a signature:
+ *  MOCKEUR_EXTERN_TEMPLATE(int, const char*, unsigned int)
+ *
+ * In a single source file:
+ *  MOCKEUR_INSTANTIATE_TEMPLATE(int, const char*, unsigned int)
+ *
+ * The most common signatures (@ref MOCKEUR_COMMON_SIGNATURES) are already
+ * instantiated in the mockeur library.
+ */
+
+#ifndef MOCKINSTANTIATION_HPP_
+#define MOCKINSTANTIATION_HPP_
+
+/**
+ * Declares that the templates of a mock are instantiated in another
+ * compilation unit.
+ *
+ * @param ... The return type followed by the types of the arguments
+ */
+#define MOCKEUR_EXTERN_TEMPLATE(...)                      \
+    extern template class Mock<__VA_ARGS__>;              \
+    extern template class CallHandler_impl<__VA_ARGS__>;  \
+    extern template class CallHandler<__VA_ARGS__>;       \
+    extern template class DefaultMockPolicy<__VA_ARGS__>; \
+    extern template class DefaultCallHandler<__VA_ARGS__>;
+
+/**
+ * Instantiates the templates of a mock.
+ *
+ * @param ... The return type followed by the types of the arguments
+ */
+#define MOCKEUR_INSTANTIATE_TEMPLATE(...)          \
+    template class Mock<__VA_ARGS__>;              \
+    template class CallHandler_impl<__VA_ARGS__>;  \
+    template class CallHandler<__VA_ARGS__>;       \
+    template class DefaultMockPolicy<__VA_ARGS__>; \
+    template class DefaultCallHandler<__VA_ARGS__>;
+
+/**
+ * Calls the provided macro for each signature instantiated in the mockeur
+ * library.
+ *
+ * @param X The macro to call, taking the return type followed by the types
+ *          of the arguments
+ */
+#define MOCKEUR_COMMON_SIGNATURES(X)          \
+    X(void)                                   \
+    X(int)                                    \
+    X(unsigned int)                           \
+    X(void, int)                              \
+    X(void, unsigned int)                     \
+    X(void, void*)                            \
+    X(int, int)                               \
+    X(int, unsigned int)                      \
+    X(int, int, int)                          \
+    X(int, void*)                             \
+    X(int, const char*)                       \
+    X(int, void*, unsigned int)               \
+    X(int, const void*, unsigned int)         \
+    X(int, char*, unsigned int)               \
+    X(int, const char*, unsigned int)
+
+#endif /* MOCKINSTANTIATION_HPP_ */
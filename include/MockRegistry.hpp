@@ -0,0 +1,70 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockRegistry.hpp
+ * @brief Declaration of the class MockRegistry
+ */
+
+#ifndef MOCKREGISTRY_HPP_
+#define MOCKREGISTRY_HPP_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class BaseMock;
+
+/**
+ * Registry of the named mocks (see BaseMock::setName), used by the tools which
+ * work on every mock, like the @ref TraceExporter or the @ref ControlPlane.
+ */
+class MockRegistry
+{
+public:
+    /**
+     * Adds a mock to the registry. Nothing is done if it is already
+     * registered.
+     *
+     * @param mockPtr The mock to add
+     */
+    static void add(BaseMock* mockPtr);
+
+    /**
+     * Removes a mock from the registry.
+     *
+     * @param mockPtr The mock to remove
+     */
+    static void remove(BaseMock* mockPtr);
+
+    /**
+     * Returns the registered mocks, in the order of their registration.
+     *
+     * @return The registered mocks
+     */
+    static const std::vector<BaseMock*>& mocks();
+
+    /**
+     * Calls a function with the mock of a name. The registry is locked
+     * meanwhile, so that another thread cannot destroy the mock.
+     *
+     * @param mockName The name of the mock
+     * @param function The function to call with the mock
+     * @return Whether a mock has the name
+     */
+    static bool withMock(const std::string& mockName, const std::function<void(BaseMock&)>& function);
+
+    /**
+     * Calls a function with every registered mock, in the order of their
+     * registration. The registry is locked meanwhile.
+     *
+     * @param function The function to call with each mock
+     */
+    static void forEach(const std::function<void(BaseMock&)>& function);
+};
+
+#endif /* MOCKREGISTRY_HPP_ */
@@ -0,0 +1,403 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockScript.hpp
+ * @brief Declaration and definition of the class MockScript (C++20)
+ *
+ * A mock script is a coroutine which answers the successive calls to a mock,
+ * for stateful simulations like a protocol:
+ *
+ *  MockScript<int, const char*> ftpServer()
+ *  {
+ *      const std::tuple<const char*>& call = co_await CallArguments();
+ *
+ *      co_yield 220;                          // Answers the first call
+ *      while (std::strcmp(std::get<0>(call), "QUIT") != 0)
+ *          co_yield 200;                      // Answers the next calls
+ *      co_yield 221;
+ *  }
+ *
+ *  mock.when(ArgumentMatcher::any<const char*>())->then(ftpServer);
+ *
+ * The reference returned by co_await CallArguments() always holds the
+ * arguments of the call being answered. A call after the end of the script
+ * throws a std::runtime_error, as does a call when the script throws itself.
+ *
+ * Only the mocks which return a value can be scripted: the calls to a mock
+ * returning void have no value to co_yield, so CallHandler<void, ...> has no
+ * script overload of then.
+ *
+ * Restoring a snapshot of the mock (see Mock::restore) starts the script over.
+ *
+ * A script answers one call at a time: a call made while another thread is
+ * being answered by the same script throws a std::runtime_error, instead of
+ * waiting for it.
+ *
+ * Everything is only defined when the compiler supports the coroutines of
+ * C++20: mockeur itself is built in C++11.
+ */
+
+#ifndef MOCKSCRIPT_HPP_
+#define MOCKSCRIPT_HPP_
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "internal/CallBehavior.hpp"
+
+/**
+ * Defined when the mock scripts are available.
+ */
+#define MOCKEUR_HAS_COROUTINES 1
+
+/**
+ * Awaited by a @ref MockScript to get the arguments of the calls.
+ */
+struct CallArguments
+{
+};
+
+/**
+ * Memory of the frame of a @ref MockScript, owned by its call handler. The
+ * block is kept when the frame is destroyed, to be reused by the next frame.
+ */
+class ScriptArena
+{
+public:
+    ScriptArena()
+        : blockPtr(nullptr), capacity(0), inUse(false)
+    {
+    }
+
+    ~ScriptArena()
+    {
+        ::operator delete(blockPtr);
+    }
+
+    ScriptArena(const ScriptArena&) = delete;
+    ScriptArena& operator=(const ScriptArena&) = delete;
+
+    /**
+     * Returns the block of the arena, grown if needed.
+     *
+     * @param size The size of the frame
+     * @return The block of the arena, or null if it is already used
+     */
+    void* allocate(std::size_t size)
+    {
+        if (inUse)
+            return nullptr;
+
+        if (size > capacity) {
+            ::operator delete(blockPtr);
+            blockPtr = nullptr; /* In case the allocation throws */
+            blockPtr = ::operator new(size);
+            capacity = size;
+        }
+
+        inUse = true;
+        return blockPtr;
+    }
+
+    /**
+     * Gives the block back to the arena.
+     */
+    void release()
+    {
+        inUse = false;
+    }
+
+    /**
+     * Returns the arena of the script being created by the current thread.
+     *
+     * @return The arena to allocate the frame from, or null
+     */
+    static ScriptArena*& current()
+    {
+        static thread_local ScriptArena* arenaPtr = nullptr;
+
+        return arenaPtr;
+    }
+
+private:
+    void* blockPtr;
+    std::size_t capacity;
+    bool inUse;
+};
+
+/**
+ * Coroutine which answers the calls to a mock: each co_yield returns the value
+ * of a call. It is given to a call handler with CallHandler::then.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class MockScript
+{
+public:
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    /**
+     * Returns the arguments of the current call to a co_await CallArguments().
+     */
+    struct ArgumentsAwaiter
+    {
+        const std::tuple<ArgumentTypes...>* argumentsPtr;
+
+        bool await_ready() const noexcept
+        {
+            return true;
+        }
+
+        void await_suspend(std::coroutine_handle<>) const noexcept
+        {
+        }
+
+        const std::tuple<ArgumentTypes...>& await_resume() const noexcept
+        {
+            return *argumentsPtr;
+        }
+    };
+
+    struct promise_type
+    {
+        std::optional<ReturnType> yieldedValue;
+        const std::tuple<ArgumentTypes...>* argumentsPtr = nullptr;
+        std::exception_ptr exceptionPtr;
+
+        MockScript get_return_object()
+        {
+            return MockScript(Handle::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always yield_value(ReturnType value)
+        {
+            yieldedValue.emplace(value);
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception()
+        {
+            exceptionPtr = std::current_exception();
+        }
+
+        ArgumentsAwaiter await_transform(CallArguments)
+        {
+            return ArgumentsAwaiter{ argumentsPtr };
+        }
+
+        /* The frame is preceded by the arena it comes from (null if it comes
+         * from the heap) */
+        static constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+        static void* operator new(std::size_t size)
+        {
+            ScriptArena* arenaPtr = ScriptArena::current();
+            void* blockPtr = arenaPtr != nullptr ? arenaPtr->allocate(size + HEADER_SIZE) : nullptr;
+
+            if (blockPtr == nullptr) {
+                arenaPtr = nullptr;
+                blockPtr = ::operator new(size + HEADER_SIZE);
+            }
+
+            *static_cast<ScriptArena**>(blockPtr) = arenaPtr;
+            return static_cast<char*>(blockPtr) + HEADER_SIZE;
+        }
+
+        static void operator delete(void* framePtr)
+        {
+            void* blockPtr = static_cast<char*>(framePtr) - HEADER_SIZE;
+            ScriptArena* arenaPtr = *static_cast<ScriptArena**>(blockPtr);
+
+            if (arenaPtr != nullptr)
+                arenaPtr->release();
+            else
+                ::operator delete(blockPtr);
+        }
+    };
+
+    MockScript(MockScript&& other) noexcept
+        : handle(other.handle)
+    {
+        other.handle = nullptr;
+    }
+
+    MockScript& operator=(MockScript&& other) noexcept
+    {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+
+    ~MockScript()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    /**
+     * Resumes the script until it answers the call.
+     *
+     * @param arguments The arguments of the call, which must outlive the next
+     *                  call
+     * @return The value of the call
+     */
+    ReturnType answer(const std::tuple<ArgumentTypes...>& arguments)
+    {
+        if (!handle || handle.done())
+            throw std::runtime_error("The script of the mock has ended");
+
+        promise_type& promise = handle.promise();
+
+        promise.argumentsPtr = &arguments;
+        promise.yieldedValue.reset();
+        handle.resume();
+
+        if (promise.exceptionPtr) {
+            std::exception_ptr exceptionPtr = promise.exceptionPtr;
+            promise.exceptionPtr = nullptr;
+            std::rethrow_exception(exceptionPtr);
+        }
+
+        if (!promise.yieldedValue)
+            throw std::runtime_error("The script of the mock has ended");
+
+        return *promise.yieldedValue;
+    }
+
+private:
+    Handle handle;
+
+    explicit MockScript(Handle providedHandle)
+        : handle(providedHandle)
+    {
+    }
+};
+
+/**
+ * Runs a @ref MockScript for a call handler: it owns the arena of the frame
+ * and the arguments of the current call, so that a call only resumes the
+ * coroutine. It is the behavior of the handler, which calls it directly:
+ * rewinding it creates the script again, in the same arena.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class MockScriptRunner : public CallBehavior<ReturnType, ArgumentTypes...>
+{
+public:
+    /**
+     * Creates the script, in the arena.
+     *
+     * @param providedScriptFunction The function which creates the script
+     */
+    explicit MockScriptRunner(
+        const std::function<MockScript<ReturnType, ArgumentTypes...>()>& providedScriptFunction)
+        : answering(false), scriptFunction(providedScriptFunction), arena(), arguments(),
+          script(createScript(scriptFunction, arena))
+    {
+    }
+
+    MockScriptRunner(const MockScriptRunner&) = delete;
+    MockScriptRunner& operator=(const MockScriptRunner&) = delete;
+
+    /**
+     * Answers a call, by resuming the script. A call made while another one
+     * is being answered is rejected.
+     *
+     * @param args The arguments of the call
+     * @return The value yielded by the script
+     */
+    ReturnType answer(ArgumentTypes ... args)
+    {
+        if (answering.exchange(true, std::memory_order_acquire))
+            throw std::runtime_error("A mock script cannot answer concurrent calls");
+
+        try {
+            arguments.emplace(args...);
+
+            ReturnType yielded = script.answer(*arguments);
+
+            answering.store(false, std::memory_order_release);
+            return yielded;
+        } catch (...) {
+            answering.store(false, std::memory_order_release);
+            throw;
+        }
+    }
+
+    ReturnType value(ArgumentTypes ... args)
+    {
+        return answer(args...);
+    }
+
+    /**
+     * Starts the script over. No call may be answered meanwhile.
+     */
+    void rewind()
+    {
+        /* The frame of the current script goes back to the arena first */
+        {
+            MockScript<ReturnType, ArgumentTypes...> previousScript(std::move(script));
+        }
+
+        arguments.reset();
+        script = createScript(scriptFunction, arena);
+    }
+
+private:
+    /* Set while a call is answered */
+    std::atomic<bool> answering;
+    std::function<MockScript<ReturnType, ArgumentTypes...>()> scriptFunction;
+    /* The arena is destroyed after the script */
+    ScriptArena arena;
+    std::optional<std::tuple<ArgumentTypes...> > arguments;
+    MockScript<ReturnType, ArgumentTypes...> script;
+
+    static MockScript<ReturnType, ArgumentTypes...> createScript(
+        const std::function<MockScript<ReturnType, ArgumentTypes...>()>& function, ScriptArena& scriptArena)
+    {
+        ScriptArena* previousArenaPtr = ScriptArena::current();
+
+        ScriptArena::current() = &scriptArena;
+
+        try {
+            MockScript<ReturnType, ArgumentTypes...> createdScript = function();
+            ScriptArena::current() = previousArenaPtr;
+            return createdScript;
+        } catch (...) {
+            ScriptArena::current() = previousArenaPtr;
+            throw;
+        }
+    }
+};
+
+#endif /* __cpp_impl_coroutine */
+
+#endif /* MOCKSCRIPT_HPP_ */
@@ -0,0 +1,32 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockeurPch.hpp
+ * @brief Header precompiled for the targets linked with the mockeur-pch CMake
+ *        target. It includes every public header of the library.
+ */
+
+#ifndef MOCKEURPCH_HPP_
+#define MOCKEURPCH_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <stdexcept>
+#include <string>
+
+#include "ArgumentMatcher/ArgumentMatcher.hpp"
+#include "Mock.hpp"
+#include "MockRegistry.hpp"
+#include "Spy.hpp"
+#include "TraceExporter.hpp"
+#include "VirtualClock.hpp"
+#include "WrappedMock.hpp"
+
+#endif /* MOCKEURPCH_HPP_ */
@@ -0,0 +1,88 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file Spy.hpp
+ *
+ * Declaration and definition of the Spy class.
+ */
+
+#ifndef SPY_HPP_
+#define SPY_HPP_
+
+#include "Mock.hpp"
+#include "internal/SpyMockPolicy.hpp"
+
+/**
+ * A Spy is a @ref Mock which does not replace the real implementation of the
+ * function: the calls are recorded in the history as for any mock, the call
+ * handlers registered with the @ref when method are used when they match, and
+ * every other call is forwarded to the real implementation.
+ *
+ * Contrary to a plain mock, the real implementation has to be linked, in a
+ * shared library loaded after the object which defines the spied function.
+ * The real implementation is found with dlsym(RTLD_NEXT, ...) when the spy is
+ * constructed. As nothing references the library anymore, the linker must be
+ * told to keep it ("-Wl,--no-as-needed" for GNU ld).
+ *
+ * Example:
+ *  Spy<int, const char*, unsigned int> spy_ftp_send("ftp_send");
+ *
+ *  int ftp_send(const char* content, unsigned int length)
+ *  {
+ *      return spy_ftp_send.value(content, length);
+ *  }
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class Spy: public Mock<ReturnType, ArgumentTypes...>
+{
+public:
+    /**
+     * Constructor of Spy
+     *
+     * @param symbolName The name of the spied function
+     */
+    Spy(const char* symbolName)
+        : Mock<ReturnType, ArgumentTypes...>(), spyPolicy(symbolName)
+    {
+        this->setPolicy(&spyPolicy);
+    }
+
+    /**
+     * Destructor of Spy
+     */
+    virtual ~Spy()
+    {
+    }
+
+    /**
+     * Calls the real implementation of the function without recording the
+     * call.
+     *
+     * @param args The arguments of the call
+     * @return The value returned by the real implementation
+     */
+    ReturnType real(ArgumentTypes ... args)
+    {
+        return spyPolicy.realFunctionHandler().value(args...);
+    }
+
+    /**
+     * Returns whether the real implementation of the function has been found.
+     *
+     * @return Whether the real implementation of the function has been found
+     */
+    bool hasRealFunction() const
+    {
+        return spyPolicy.realFunctionHandler().function() != nullptr;
+    }
+
+private:
+    SpyMockPolicy<ReturnType, ArgumentTypes...> spyPolicy;
+};
+
+#endif /* SPY_HPP_ */
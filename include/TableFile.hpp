@@ -0,0 +1,193 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file TableFile.hpp
+ * @brief Declaration of the classes TableFile and TableBuilder
+ */
+
+#ifndef TABLEFILE_HPP_
+#define TABLEFILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only lookup table of fixed-size keys and values, mapped in memory from
+ * a file written by a @ref TableBuilder. The keys are sorted, so that a value
+ * is found with a binary search, without loading or parsing anything.
+ *
+ * File format (in the byte order of the machine):
+ *  - a header: the magic "MOCKTBL1", the size of a key and of a value (32
+ *    bits each) and the number of rows (64 bits);
+ *  - the keys, sorted as byte strings (memcmp), then padded to 8 bytes;
+ *  - the values, in the order of the keys.
+ *
+ * @see LookupTable for a table typed after the arguments of a mock
+ */
+class TableFile
+{
+public:
+    /**
+     * Maps a table file in memory.
+     *
+     * @param path The path of the file
+     * @throws std::runtime_error if the file cannot be mapped or is not a
+     *         valid table
+     */
+    explicit TableFile(const std::string& path);
+
+    /**
+     * Destructor of TableFile. It unmaps the file.
+     */
+    ~TableFile();
+
+    /**
+     * Returns the value of a key.
+     *
+     * @param keyPtr The key, of keySize() bytes
+     * @return The value of the key, of valueSize() bytes, or null if the key
+     *         is not in the table
+     */
+    const void* find(const void* keyPtr) const;
+
+    /**
+     * Returns the size of a key in bytes.
+     *
+     * @return The size of a key in bytes
+     */
+    std::size_t keySize() const
+    {
+        return keyBytes;
+    }
+
+    /**
+     * Returns the size of a value in bytes.
+     *
+     * @return The size of a value in bytes
+     */
+    std::size_t valueSize() const
+    {
+        return valueBytes;
+    }
+
+    /**
+     * Returns the number of rows of the table.
+     *
+     * @return The number of rows of the table
+     */
+    std::size_t size() const
+    {
+        return rowCount;
+    }
+
+private:
+    void* mappingPtr;
+    std::size_t mappingSize;
+    std::size_t keyBytes;
+    std::size_t valueBytes;
+    std::size_t rowCount;
+    const unsigned char* keysPtr;
+    const unsigned char* valuesPtr;
+
+    TableFile(const TableFile&);
+    TableFile& operator=(const TableFile&);
+};
+
+/**
+ * Builds a table file for @ref TableFile, from rows added one by one or read
+ * from a CSV file.
+ *
+ * @see LookupTableBuilder to add the rows of a mock with their types
+ */
+class TableBuilder
+{
+public:
+    /**
+     * Type of a column of a CSV file
+     */
+    enum FieldType
+    {
+        INT8,
+        UINT8,
+        INT16,
+        UINT16,
+        INT32,
+        UINT32,
+        INT64,
+        UINT64,
+        FLOAT,
+        DOUBLE
+    };
+
+    /**
+     * Constructor of TableBuilder, without any row.
+     *
+     * @param providedKeySize The size of a key in bytes
+     * @param providedValueSize The size of a value in bytes
+     */
+    TableBuilder(std::size_t providedKeySize, std::size_t providedValueSize);
+
+    /**
+     * Adds a row.
+     *
+     * @param keyPtr The key, of the size of a key
+     * @param valuePtr The value, of the size of a value
+     */
+    void add(const void* keyPtr, const void* valuePtr);
+
+    /**
+     * Adds the rows of a CSV file: one row per line, made of the fields of the
+     * key followed by the value, separated by commas. The integers may be
+     * written in decimal, or in hexadecimal with the "0x" prefix. The empty
+     * lines and the lines starting with '#' are skipped.
+     *
+     * @param in The CSV file
+     * @param keyFields The types of the fields of the key, whose sizes must
+     *                  add up to the size of a key
+     * @param valueField The type of the value, of the size of a value
+     * @throws std::runtime_error if a line cannot be parsed
+     */
+    void addCsv(std::istream& in, const std::vector<FieldType>& keyFields, FieldType valueField);
+
+    /**
+     * Writes the table file.
+     *
+     * @param path The path of the file
+     * @throws std::runtime_error if two rows have the same key or if the file
+     *         cannot be written
+     */
+    void write(const std::string& path) const;
+
+    /**
+     * Returns the type of a CSV field from its name: i8, u8, i16, u16, i32,
+     * u32, i64, u64, f32 or f64.
+     *
+     * @param name The name of the type
+     * @param fieldType Set to the type of the field
+     * @return Whether the name is known
+     */
+    static bool parseFieldType(const std::string& name, FieldType& fieldType);
+
+    /**
+     * Returns the size in bytes of a CSV field.
+     *
+     * @param fieldType The type of the field
+     * @return The size in bytes of the field
+     */
+    static std::size_t fieldSize(FieldType fieldType);
+
+private:
+    std::size_t keyBytes;
+    std::size_t valueBytes;
+    std::vector<unsigned char> rows; /* The key then the value of each row */
+};
+
+#endif /* TABLEFILE_HPP_ */
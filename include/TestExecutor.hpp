@@ -0,0 +1,147 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file TestExecutor.hpp
+ * @brief Declaration of the class TestExecutor
+ */
+
+#ifndef TESTEXECUTOR_HPP_
+#define TESTEXECUTOR_HPP_
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Runs test functions in parallel, in worker processes forked from the
+ * calling process. As the workers are forked once the process is fully
+ * initialized, they do not pay the static initialization again, and each of
+ * them has its own copy of the global mocks and of the argument matchers.
+ *
+ * The workers take the tests one by one from a shared-memory results area,
+ * where they also write the outcome of each test: its status, its duration
+ * and the number of calls to every named mock (see BaseMock::setName). A
+ * worker which crashes (a failed assert, a signal) fails the test it was
+ * running and is replaced by a new worker, forked from the calling process.
+ * The calling process sleeps until a worker ends, which closes a pipe only
+ * the worker holds: a process forked by a test, and still running, delays
+ * the end of its worker until it exits or executes another program.
+ *
+ * The tests of a worker share its mocks: the tear down function, called
+ * after each test, is expected to reset them.
+ */
+class TestExecutor
+{
+public:
+    typedef std::function<void ()> TestFunction;
+
+    /**
+     * Outcome of a test
+     */
+    enum Status
+    {
+        NOT_RUN,
+        PASSED,
+        FAILED,
+        CRASHED
+    };
+
+    /**
+     * Result of a test
+     */
+    struct Result
+    {
+        /**
+         * The name of the test
+         */
+        std::string name;
+
+        /**
+         * The outcome of the test
+         */
+        Status status;
+
+        /**
+         * The duration of the test in nanoseconds, 0 if it crashed
+         */
+        long long durationNs;
+
+        /**
+         * The message of the exception which failed the test, or the
+         * description of the crash
+         */
+        std::string message;
+
+        /**
+         * The number of calls to every named mock called by the test
+         */
+        std::vector<std::pair<std::string, unsigned long long> > mockCalls;
+    };
+
+    /**
+     * Constructor of TestExecutor, without any test.
+     */
+    TestExecutor();
+
+    /**
+     * Registers a test. A test fails if it throws, or if it crashes its
+     * worker process.
+     *
+     * @param name The name of the test
+     * @param testFunction The test
+     */
+    void addTest(const std::string& name, const TestFunction& testFunction);
+
+    /**
+     * Sets the function called by the workers after each test, passed or
+     * failed.
+     *
+     * @param function The tear down function
+     */
+    void setTearDown(const TestFunction& function);
+
+    /**
+     * Runs the registered tests and waits for their results. Nothing must be
+     * running in other threads of the calling process, as only the calling
+     * thread is forked.
+     *
+     * @param workerCount The number of worker processes, 0 for one per
+     *                    online processor
+     *
+     * @return The number of tests which did not pass
+     */
+    unsigned int run(unsigned int workerCount = 0);
+
+    /**
+     * Returns the results of the last run, in the order of registration of
+     * the tests.
+     *
+     * @return The results of the tests
+     */
+    const std::vector<Result>& results() const;
+
+    /**
+     * Writes a line per test of the last run, with its status and duration,
+     * followed by the number of failed tests.
+     *
+     * @param out The stream to write to
+     */
+    void writeReport(std::ostream& out) const;
+
+private:
+    std::vector<std::pair<std::string, TestFunction> > testList;
+    TestFunction tearDownFunction;
+    std::vector<Result> resultList;
+
+    TestExecutor(const TestExecutor&);
+    TestExecutor& operator=(const TestExecutor&);
+};
+
+#endif /* TESTEXECUTOR_HPP_ */
@@ -0,0 +1,61 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file TraceExporter.hpp
+ * @brief Declaration of the class TraceExporter
+ */
+
+#ifndef TRACEEXPORTER_HPP_
+#define TRACEEXPORTER_HPP_
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class BaseMock;
+
+/**
+ * Exports the timestamps of the calls recorded by the mocks (see
+ * BaseMock::recordTimestamps), to see when and how often the code under test
+ * calls the mocked layer.
+ */
+class TraceExporter
+{
+public:
+    /**
+     * Writes the calls of every mock of the @ref MockRegistry in the Chrome
+     * trace-event JSON format (loadable in chrome://tracing or Perfetto). Each
+     * mock is displayed as a thread, named after the mock, and each call as an
+     * instant event. The time origin is the first recorded call.
+     *
+     * @param out The stream to write to
+     */
+    static void writeChromeTrace(std::ostream& out);
+
+    /**
+     * Writes the calls of every mock of the @ref MockRegistry in the Chrome
+     * trace-event JSON format, to a file.
+     *
+     * @param path The path of the file to write
+     * @return Whether the file has been written
+     */
+    static bool writeChromeTrace(const std::string& path);
+
+    /**
+     * Returns the histogram of the time between two consecutive calls to the
+     * mock. The bucket i counts the gaps g (in nanoseconds) such that
+     * 2^i <= g < 2^(i+1); the bucket 0 also counts the gaps of 0 ns. The
+     * histogram stops at its last non-empty bucket.
+     *
+     * @param mock The mock
+     * @return The histogram of the gaps between the calls
+     */
+    static std::vector<unsigned long long> gapHistogram(const BaseMock& mock);
+};
+
+#endif /* TRACEEXPORTER_HPP_ */
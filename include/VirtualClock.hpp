@@ -0,0 +1,65 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file VirtualClock.hpp
+ * @brief Declaration of the class VirtualClock
+ */
+
+#ifndef VIRTUALCLOCK_HPP_
+#define VIRTUALCLOCK_HPP_
+
+#include <atomic>
+#include <chrono>
+
+/**
+ * Clock whose time only goes forward when it is explicitly advanced. It is
+ * advanced by the call handlers simulating a latency (thenReturnAfter,
+ * thenTimeout), so that timeouts and retries of the code under test can be
+ * tested without waiting.
+ *
+ * The code under test reads the virtual time through a mocked time source
+ * (see CallHandler::thenReturnVirtualTime). As it meets the requirements of
+ * the C++ Clock concept, VirtualClock can also be used directly by code
+ * templatized on the clock.
+ *
+ * The virtual time starts at 0.
+ */
+class VirtualClock
+{
+public:
+    typedef std::chrono::nanoseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<VirtualClock> time_point;
+
+    static constexpr bool is_steady = true;
+
+    /**
+     * Returns the current virtual time.
+     *
+     * @return The current virtual time
+     */
+    static time_point now();
+
+    /**
+     * Moves the virtual time forward.
+     *
+     * @param elapsedTime The time to add to the virtual time
+     */
+    static void advance(duration elapsedTime);
+
+    /**
+     * Resets the virtual time to 0.
+     */
+    static void reset();
+
+private:
+    static std::atomic<rep> elapsed;
+};
+
+#endif /* VIRTUALCLOCK_HPP_ */
@@ -0,0 +1,106 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file WrappedMock.hpp
+ *
+ * Declaration and definition of the WrappedMock class.
+ */
+
+#ifndef WRAPPEDMOCK_HPP_
+#define WRAPPEDMOCK_HPP_
+
+#include <atomic>
+
+#include "Mock.hpp"
+
+/**
+ * A WrappedMock is a @ref Mock which can be armed and disarmed at runtime. It
+ * is meant to be used with the "--wrap=symbol" option of GNU ld, which keeps
+ * the real implementation of the function linked as __real_symbol and
+ * redirects every call to __wrap_symbol.
+ *
+ * The __wrap_symbol function only calls the @ref value method of the mock
+ * while it is armed, and __real_symbol otherwise:
+ *
+ *  extern "C" int __real_ftp_send(const char* a0, unsigned int a1);
+ *
+ *  WrappedMock<int, const char*, unsigned int> wrap_ftp_send;
+ *
+ *  extern "C" int __wrap_ftp_send(const char* a0, unsigned int a1)
+ *  {
+ *      if (wrap_ftp_send.armed())
+ *          return wrap_ftp_send.value(a0, a1);
+ *
+ *      return __real_ftp_send(a0, a1);
+ *  }
+ *
+ * The mockeur_wrap CMake function generates this code for a list of
+ * functions and adds the linker options to the target.
+ *
+ * The mock is disarmed when constructed, and when the @ref clear method is
+ * called.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class WrappedMock: public Mock<ReturnType, ArgumentTypes...>
+{
+public:
+    /**
+     * Default constructor of WrappedMock
+     */
+    WrappedMock()
+        : Mock<ReturnType, ArgumentTypes...>(), armedFlag(false)
+    {
+    }
+
+    /**
+     * Destructor of WrappedMock
+     */
+    virtual ~WrappedMock()
+    {
+    }
+
+    /**
+     * Redirect the calls to the mock.
+     */
+    void arm()
+    {
+        armedFlag.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * Redirect the calls to the real implementation.
+     */
+    void disarm()
+    {
+        armedFlag.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns whether the calls are redirected to the mock.
+     *
+     * @return Whether the calls are redirected to the mock
+     */
+    bool armed() const
+    {
+        return armedFlag.load(std::memory_order_relaxed);
+    }
+
+protected:
+    /**
+     * Disarms the mock when it is cleared.
+     */
+    void cleared()
+    {
+        disarm();
+    }
+
+private:
+    std::atomic<bool> armedFlag;
+};
+
+#endif /* WRAPPEDMOCK_HPP_ */
@@ -13,13 +13,14 @@
 #ifndef ABSTRACTCALLHANDLER_HPP_
 #define ABSTRACTCALLHANDLER_HPP_
 
-#include <functional>
+#include "ArgumentMatcher/AbstractArgumentMatcher.hpp"
+#include "internal/BaseCallHandler.hpp"
 
 template<typename ReturnType, typename ... ArgumentTypes>
 class AbstractCallHandler;
 
 template<typename ... ArgumentTypes>
-class AbstractCallHandler<void, ArgumentTypes...>
+class AbstractCallHandler<void, ArgumentTypes...> : public BaseCallHandler
 {
 public:
     /**
@@ -61,7 +62,7 @@ public:
 };
 
 template<typename ReturnType>
-class AbstractCallHandler<ReturnType>
+class AbstractCallHandler<ReturnType> : public BaseCallHandler
 {
 public:
     /**
@@ -94,7 +95,7 @@ public:
 };
 
 template<>
-class AbstractCallHandler<void>
+class AbstractCallHandler<void> : public BaseCallHandler
 {
 public:
     /**
@@ -125,7 +126,7 @@ public:
 };
 
 template<typename ReturnType, typename ... ArgumentTypes>
-class AbstractCallHandler
+class AbstractCallHandler : public BaseCallHandler
 {
 public:
     /**
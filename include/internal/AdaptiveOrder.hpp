@@ -0,0 +1,212 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file AdaptiveOrder.hpp
+ * @brief Declaration of the private class AdaptiveOrder
+ */
+
+#ifndef ADAPTIVEORDER_HPP_
+#define ADAPTIVEORDER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "internal/CallTimer.hpp"
+
+/**
+ * Order in which a list of checks is evaluated, when the evaluation stops at
+ * the first check which rejects (a conjunction) or which accepts (a
+ * disjunction). The order adapts to the checks: one evaluation out of
+ * @ref SAMPLE_PERIOD is sampled, measuring the cost of each check and
+ * counting how often it stops the evaluation, and the checks are sorted every
+ * @ref REORDER_PERIOD samples so that the cheapest and most decisive checks
+ * come first.
+ *
+ * The order is packed in one atomic word, so that the evaluations of other
+ * threads always read a complete order. Only the first
+ * @ref MAX_ADAPTIVE_SIZE checks are reordered; the next ones keep their place.
+ */
+class AdaptiveOrder
+{
+public:
+    /**
+     * Packed order: the index of the check at rank r is in the bits 4r to
+     * 4r + 3.
+     */
+    typedef std::uint64_t Order;
+
+    /**
+     * Result of a check which stops the evaluation
+     */
+    enum Stop
+    {
+        STOP_ON_REJECT, /**< Conjunction: the first rejection decides */
+        STOP_ON_ACCEPT  /**< Disjunction: the first acceptance decides */
+    };
+
+    static const unsigned int MAX_ADAPTIVE_SIZE = 16;
+    static const unsigned int SAMPLE_PERIOD = 16;
+    static const unsigned int REORDER_PERIOD = 16;
+
+    /**
+     * Constructor of AdaptiveOrder. The checks are first evaluated in the
+     * order of their indexes.
+     *
+     * @param providedSize The number of checks
+     * @param providedStop The result of a check which stops the evaluation
+     */
+    AdaptiveOrder(unsigned int providedSize, Stop providedStop);
+
+    /**
+     * Evaluates the checks in the current order, until one of them stops the
+     * evaluation.
+     *
+     * @param check The function which returns the result of the check of an
+     *              index
+     * @return The result of the check which stops the evaluation, or the
+     *         opposite result if none stops it
+     */
+    template<typename Check>
+    bool evaluate(const Check& check) const
+    {
+        const bool stopResult = (stop == STOP_ON_ACCEPT);
+        const Order currentOrder = order();
+
+        if (!startEvaluation()) {
+            for (unsigned int rank = 0; rank < size; rank++) {
+                if (check(at(currentOrder, rank)) == stopResult)
+                    return stopResult;
+            }
+
+            return !stopResult;
+        }
+
+        bool result = !stopResult;
+
+        for (unsigned int rank = 0; rank < size; rank++) {
+            const unsigned int index = at(currentOrder, rank);
+            const long long startTicks = CallTimer::now();
+            const bool checkResult = check(index);
+
+            record(index, checkResult, startTicks);
+
+            if (checkResult == stopResult) {
+                result = stopResult;
+                break;
+            }
+        }
+
+        endSample();
+
+        return result;
+    }
+
+    /**
+     * Returns the current order.
+     *
+     * @return The current order, to read with @ref at
+     */
+    Order order() const
+    {
+        return packedOrder.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the index of the check at a rank of an order.
+     *
+     * @param currentOrder The order
+     * @param rank The rank of the check
+     * @return The index of the check
+     */
+    static unsigned int at(Order currentOrder, unsigned int rank)
+    {
+        return rank < MAX_ADAPTIVE_SIZE ? static_cast<unsigned int>((currentOrder >> (4 * rank)) & 0xF) : rank;
+    }
+
+private:
+    /**
+     * Statistics of a check, over the sampled evaluations
+     */
+    struct Statistics
+    {
+        std::atomic<std::uint64_t> evaluated;
+        std::atomic<std::uint64_t> stopped;
+        std::atomic<std::uint64_t> ticks;
+    };
+
+    unsigned int size;
+    Stop stop;
+    mutable std::atomic<Order> packedOrder;
+    mutable std::atomic<unsigned int> evaluationCount;
+    mutable std::atomic<unsigned int> sampleCount;
+    mutable std::atomic<bool> reordering;
+    std::unique_ptr<Statistics[]> statisticsPtr;
+
+    /**
+     * Starts an evaluation, and returns whether it is sampled: then each check
+     * must be given to @ref record, and the evaluation ended by
+     * @ref endSample.
+     *
+     * @return Whether the evaluation is sampled
+     */
+    bool startEvaluation() const
+    {
+        if (size < 2)
+            return false;
+
+        /* Lost increments between threads only shift the samples */
+        const unsigned int count = evaluationCount.load(std::memory_order_relaxed) + 1;
+
+        evaluationCount.store(count, std::memory_order_relaxed);
+
+        return count % SAMPLE_PERIOD == 0;
+    }
+
+    /**
+     * Records a check of a sampled evaluation.
+     *
+     * @param index The index of the check
+     * @param result The result of the check
+     * @param startTicks The time before the check (see @ref CallTimer::now)
+     */
+    void record(unsigned int index, bool result, long long startTicks) const
+    {
+        if (index >= MAX_ADAPTIVE_SIZE)
+            return;
+
+        Statistics& statistics = statisticsPtr[index];
+
+        statistics.evaluated.fetch_add(1, std::memory_order_relaxed);
+        statistics.ticks.fetch_add(static_cast<std::uint64_t>(CallTimer::now() - startTicks), std::memory_order_relaxed);
+
+        if (result == (stop == STOP_ON_ACCEPT))
+            statistics.stopped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Ends a sampled evaluation, and reorders the checks every
+     * @ref REORDER_PERIOD samples.
+     */
+    void endSample() const
+    {
+        if (sampleCount.fetch_add(1, std::memory_order_relaxed) % REORDER_PERIOD == REORDER_PERIOD - 1)
+            reorder();
+    }
+
+    /**
+     * Sorts the checks by expected cost to stop the evaluation, and halves
+     * the statistics so that the order follows the changes of the arguments.
+     */
+    void reorder() const;
+
+    AdaptiveOrder(const AdaptiveOrder&);
+    AdaptiveOrder& operator=(const AdaptiveOrder&);
+};
+
+#endif /* ADAPTIVEORDER_HPP_ */
@@ -13,96 +13,118 @@
 #ifndef ARGUMENTMATCHERS_IMPL_HPP_
 #define ARGUMENTMATCHERS_IMPL_HPP_
 
-/**
- * Declaration of the ArgumentMatchers_impl
- */
-template<typename ... ArgumentTypes>
-class ArgumentMatchers_impl;
+#include <tuple>
+
+#include "ArgumentMatcher/AbstractArgumentMatcher.hpp"
+#include "ArgumentMatcher/AbstractCallMatcher.hpp"
+#include "internal/AdaptiveOrder.hpp"
+#include "internal/TupleMatcher.hpp"
 
 /**
- * Implementation of ArgumentMatchers_impl without any template parameters (a
- * matcher matching no argument). It always returns true.
+ * Implementation of ArgumentMatchers_impl. The pointers to the argument
+ * matchers are stored in a flat tuple, and the checking stops at the first
+ * argument not matched. With a single argument, it is checked by
+ * @ref TupleMatcher; with several ones, they are checked in an adaptive order
+ * (see @ref AdaptiveOrder), so that an expensive matcher of the first argument
+ * is only evaluated once the cheap and selective matchers of the other
+ * arguments have passed.
+ *
+ * An @ref AbstractCallMatcher may also be given, to check the arguments which
+ * go together once each argument is matched.
+ *
+ * The class is not polymorphic: matching an instance of arguments costs one
+ * virtual call per argument, the one of the argument matcher.
  */
-template<>
-class ArgumentMatchers_impl<>
+template<typename ... ArgumentTypes>
+class ArgumentMatchers_impl
 {
 public:
     /**
-     * Constructor of ArgumentMatchers_impl without template parameter
+     * Constructor of ArgumentMatchers_impl
+     *
+     * @param matchersPtr Pointers to the argument matchers, in the order of
+     *                    the arguments
      */
-    ArgumentMatchers_impl()
+    ArgumentMatchers_impl(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr)
+        : argumentMatchers(matchersPtr...),
+          order(sizeof...(ArgumentTypes), AdaptiveOrder::STOP_ON_REJECT),
+          callMatcherPtr(nullptr)
     {
     }
 
     /**
-     * Destructor of ArgumentMatchers_impl without template parameter
+     * Sets the matcher of the whole call, checked after the argument
+     * matchers. It is not owned.
+     *
+     * @param providedCallMatcherPtr The call matcher, or null
      */
-    virtual ~ArgumentMatchers_impl()
+    void setCallMatcher(const AbstractCallMatcher* providedCallMatcherPtr)
     {
+        callMatcherPtr = providedCallMatcherPtr;
     }
 
     /**
-     * Returns true
+     * Returns whether current object matches the instance of arguments.
      *
-     * @return true
+     * @param args The instance of arguments
+     * @return Whether current object matches the instance of arguments.
      */
-    virtual bool matchArguments() const
+    bool matchArguments(ArgumentTypes ... args) const
     {
-        return true;
+        return matchValues(std::forward_as_tuple(args...));
     }
-};
-
-/**
- * Implementation of ArgumentMatchers_impl with at least one template parameter.
- * The class is defined recursively. The parent class is either:
- *  - the class itself with one template parameter less;
- *  - the above class which takes no template parameter.
- *
- * It checks if it matches the current argument and if it is the case, forward
- * the remaining checks to the parent class.
- */
 
-template<typename CurrentArgType, typename ... OtherArgTypes>
-class ArgumentMatchers_impl<CurrentArgType, OtherArgTypes...> : ArgumentMatchers_impl<OtherArgTypes...>
-{
-public:
     /**
-     * Constructor of ArgumentMatchers_impl with template parameters
+     * Returns whether current object matches a tuple of arguments.
      *
-     * @param currentMatcher A pointer to the first ArgumentMatcher
-     * @param otherMatchers Pointers to the remaining ArgumentMatchers
+     * @param values The tuple of arguments
+     * @return Whether current object matches the tuple of arguments.
      */
-    ArgumentMatchers_impl(AbstractArgumentMatcher<CurrentArgType> *currentMatcher,
-                         AbstractArgumentMatcher<OtherArgTypes>*... otherMatchers)
-        : ArgumentMatchers_impl<OtherArgTypes...>(otherMatchers...), argumentMatcher(currentMatcher)
+    template<typename ValueTuple>
+    bool matchValues(const ValueTuple& values) const
     {
-    }
+        typedef std::tuple<AbstractArgumentMatcher<ArgumentTypes>*...> MatcherTuple;
+        bool argumentsMatched;
 
-    /**
-     * Destructor of ArgumentMatchers_impl with template parameters
-     */
-    virtual ~ArgumentMatchers_impl()
-    {
+        if (sizeof...(ArgumentTypes) < 2) {
+            argumentsMatched = TupleMatcher<0, sizeof...(ArgumentTypes)>::match(argumentMatchers, values);
+        } else {
+            argumentsMatched = order.evaluate([this, &values] (unsigned int position) {
+                return TuplePositionMatcher<MatcherTuple, ValueTuple>::match(position, argumentMatchers, values);
+            });
+        }
+
+        return argumentsMatched
+            && (callMatcherPtr == nullptr || TupleCallMatcher<ValueTuple>::match(*callMatcherPtr, values));
     }
 
     /**
-     * Returns whether current object matches the instance of arguments.
+     * Returns whether every matcher may be evaluated by several threads at
+     * once (see BaseArgumentMatcher::threadSafe).
      *
-     * @param currentArg The first argument
-     * @param otherArgs The other arguments
-     * @return Whether current object matches the instance of arguments.
+     * @return Whether the matchers are thread-safe
      */
-    virtual bool matchArguments(CurrentArgType currentArg, OtherArgTypes ... otherArgs) const
+    bool threadSafe() const
     {
-        return argumentMatcher->match(currentArg)
-            && ArgumentMatchers_impl<OtherArgTypes...>::matchArguments(otherArgs...);
+        return TupleMatcher<0, sizeof...(ArgumentTypes)>::threadSafe(argumentMatchers)
+            && (callMatcherPtr == nullptr || callMatcherPtr->threadSafe());
     }
 
 private:
     /**
-     * A pointer to the argument matcher of the current nesting argument.
+     * The pointers to the argument matchers, in the order of the arguments.
+     */
+    std::tuple<AbstractArgumentMatcher<ArgumentTypes>*...> argumentMatchers;
+
+    /**
+     * The order in which the arguments are checked.
+     */
+    AdaptiveOrder order;
+
+    /**
+     * The matcher of the whole call, or null.
      */
-    AbstractArgumentMatcher<CurrentArgType>* argumentMatcher;
+    const AbstractCallMatcher* callMatcherPtr;
 };
 
 #endif /* ARGUMENTMATCHERS_IMPL_HPP_ */
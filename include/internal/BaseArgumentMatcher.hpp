@@ -28,6 +28,20 @@ public:
     virtual ~BaseArgumentMatcher()
     {
     }
+
+    /**
+     * Returns whether the matcher may be evaluated by several threads at
+     * once, so that a query of a large history can be split between them
+     * (see BaseMock::setParallelQueryThreshold). A matcher which changes a
+     * state when it is evaluated must return false, which the matchers
+     * defined by the user do unless they override the method.
+     *
+     * @return Whether the matcher is thread-safe
+     */
+    virtual bool threadSafe() const
+    {
+        return false;
+    }
 };
 
 #endif /* BASEARGUMENTMATCHER_HPP_ */
@@ -0,0 +1,78 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file BaseCallHandler.hpp
+ * @brief Declaration of the private class BaseCallHandler
+ */
+
+#ifndef BASECALLHANDLER_HPP_
+#define BASECALLHANDLER_HPP_
+
+#include <atomic>
+
+class MockCore;
+
+/**
+ * Base class without template of every call handler, through which the
+ * @ref MockCore stores, publishes and deletes the handlers of any mock.
+ */
+class BaseCallHandler
+{
+public:
+    /**
+     * Constructor of BaseCallHandler
+     */
+    BaseCallHandler()
+        : pendingCorePtr(nullptr)
+    {
+    }
+
+    /**
+     * Destructor of BaseCallHandler
+     */
+    virtual ~BaseCallHandler()
+    {
+    }
+
+    /**
+     * Returns whether the behavior of the handler changes from one call to
+     * another, like with fault injection.
+     *
+     * @return Whether the handler has a state
+     */
+    virtual bool hasState() const
+    {
+        return false;
+    }
+
+    /**
+     * Brings the handler back to its state before its first call.
+     */
+    virtual void rewind()
+    {
+    }
+
+protected:
+    /**
+     * Publishes the handler to the calls, if it waits for its configuration
+     * (see MockCore::addPendingHandler). To be called once the handler is
+     * configured.
+     */
+    void configured();
+
+private:
+    friend class MockCore;
+
+    /* The core which publishes the handler once it is configured */
+    std::atomic<MockCore*> pendingCorePtr;
+
+    BaseCallHandler(const BaseCallHandler&);
+    BaseCallHandler& operator=(const BaseCallHandler&);
+};
+
+#endif /* BASECALLHANDLER_HPP_ */
@@ -0,0 +1,47 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallBehavior.hpp
+ * @brief Declaration and definition of private class CallBehavior
+ */
+
+#ifndef CALLBEHAVIOR_HPP_
+#define CALLBEHAVIOR_HPP_
+
+/**
+ * Behavior of a call handler whose answer changes from one call to another,
+ * like with fault injection. Its state is stored inline in the object, which
+ * the handler owns and calls directly, instead of going through a callback
+ * function. It is only allocated by the behaviors which need it.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class CallBehavior
+{
+public:
+    /**
+     * Destructor of CallBehavior
+     */
+    virtual ~CallBehavior()
+    {
+    }
+
+    /**
+     * Answers a call.
+     *
+     * @param args The arguments of the call
+     * @return The value of the call
+     */
+    virtual ReturnType value(ArgumentTypes ... args) = 0;
+
+    /**
+     * Brings the state back to the one before the first call.
+     */
+    virtual void rewind() = 0;
+};
+
+#endif /* CALLBEHAVIOR_HPP_ */
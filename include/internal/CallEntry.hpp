@@ -46,6 +46,21 @@ public:
     {
         return CallEntry_impl<ArgTypes...>::acceptedBy(matchersPtr...);
     }
+
+    bool acceptedBy(const ArgumentMatchers<ArgTypes...>& matchers) const
+    {
+        return CallEntry_impl<ArgTypes...>::acceptedBy(matchers);
+    }
+
+    const std::tuple<ArgTypes...>& arguments() const
+    {
+        return CallEntry_impl<ArgTypes...>::arguments();
+    }
+
+    bool sameArguments(ArgTypes ... args) const
+    {
+        return CallEntry_impl<ArgTypes...>::sameArguments(args...);
+    }
 };
 
 #endif /* CALLENTRY_HPP_ */
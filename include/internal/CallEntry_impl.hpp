@@ -13,53 +13,127 @@
 #ifndef CALLENTRY_IMPL_HPP_
 #define CALLENTRY_IMPL_HPP_
 
-template<typename ... ArgumentTypes>
-class CallEntry_impl;
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ArgumentMatcher/AbstractArgumentMatcher.hpp"
+#include "internal/ArgumentMatchers_impl.hpp"
+#include "internal/TupleMatcher.hpp"
 
-template<>
-class CallEntry_impl<>
+/**
+ * Whether the objects of a type can be compared with the "==" operator, as
+ * IsEqualityComparable<Type>::value.
+ */
+template<typename Type>
+struct IsEqualityComparable
 {
+private:
+    template<typename TestedType>
+    static auto test(int) -> decltype(std::declval<const TestedType&>() == std::declval<const TestedType&>(),
+                                      std::true_type());
+
+    template<typename TestedType>
+    static std::false_type test(...);
+
 public:
-    CallEntry_impl()
-    {
-    }
+    static const bool value = decltype(test<Type>(0))::value;
+};
 
-    virtual ~CallEntry_impl()
-    {
-    }
+/**
+ * Whether the objects of every type can be compared with the "==" operator,
+ * as AllEqualityComparable<Types...>::value.
+ */
+template<typename ... Types>
+struct AllEqualityComparable : std::true_type
+{
+};
 
-    virtual bool acceptedBy() const
-    {
-        return true;
-    }
+template<typename Type, typename ... Types>
+struct AllEqualityComparable<Type, Types...>
+    : std::integral_constant<bool, IsEqualityComparable<Type>::value && AllEqualityComparable<Types...>::value>
+{
 };
 
 /**
- * The structure is defined recursively.
+ * Storage of the arguments of a call, in a flat tuple. The class is not
+ * polymorphic: the arguments are checked by @ref TupleMatcher, from the first
+ * to the last one, or in the adaptive order of an @ref ArgumentMatchers_impl.
  */
-template<typename CurrentArgType, typename ... OtherArgTypes>
-class CallEntry_impl<CurrentArgType, OtherArgTypes...> : CallEntry_impl<OtherArgTypes...>
+template<typename ... ArgumentTypes>
+class CallEntry_impl
 {
 public:
-    CallEntry_impl(CurrentArgType currentEntry, OtherArgTypes ... otherEntries)
-        : CallEntry_impl<OtherArgTypes...>(otherEntries...), savedEntry(currentEntry)
+    /**
+     * Constructor of CallEntry_impl
+     *
+     * @param entries The arguments of the call
+     */
+    CallEntry_impl(ArgumentTypes ... entries)
+        : savedEntries(entries...)
+    {
+    }
+
+    /**
+     * Returns whether the stored arguments are matched by the instance of
+     * argument matchers.
+     *
+     * @param matchersPtr Pointers to argument matchers
+     * @return Whether the stored arguments are matched by the instance of
+     *         argument matchers.
+     */
+    bool acceptedBy(AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
+    {
+        return TupleMatcher<0, sizeof...(ArgumentTypes)>::match(std::make_tuple(matchersPtr...), savedEntries);
+    }
+
+    /**
+     * Returns whether the stored arguments are matched by the instance of
+     * argument matchers, checked in its adaptive order.
+     *
+     * @param matchers An instance of argument matchers
+     * @return Whether the stored arguments are matched by the instance of
+     *         argument matchers.
+     */
+    bool acceptedBy(const ArgumentMatchers_impl<ArgumentTypes...>& matchers) const
     {
+        return matchers.matchValues(savedEntries);
     }
 
-    virtual ~CallEntry_impl()
+    /**
+     * Returns the stored arguments.
+     *
+     * @return The stored arguments
+     */
+    const std::tuple<ArgumentTypes...>& arguments() const
     {
+        return savedEntries;
     }
 
-    virtual bool acceptedBy(AbstractArgumentMatcher<CurrentArgType>* currentMatcher,
-                    AbstractArgumentMatcher<OtherArgTypes>* ... otherMatchers) const
+    /**
+     * Returns whether the stored arguments equal the provided ones (always
+     * false when they cannot be compared).
+     *
+     * @param args The instance of arguments
+     * @return Whether the stored arguments equal the provided ones
+     */
+    bool sameArguments(ArgumentTypes ... args) const
     {
-        return currentMatcher->match(savedEntry)
-               && CallEntry_impl<OtherArgTypes...>::acceptedBy(otherMatchers...);
+        return sameArguments(AllEqualityComparable<ArgumentTypes...>(), args...);
     }
 
 private:
-    CurrentArgType savedEntry;
-};
+    std::tuple<ArgumentTypes...> savedEntries;
+
+    bool sameArguments(std::true_type, ArgumentTypes ... args) const
+    {
+        return savedEntries == std::forward_as_tuple(args...);
+    }
 
+    bool sameArguments(std::false_type, ArgumentTypes ...) const
+    {
+        return false;
+    }
+};
 
 #endif /* CALLENTRY_IMPL_HPP_ */
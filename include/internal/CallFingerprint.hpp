@@ -0,0 +1,286 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallFingerprint.hpp
+ * @brief Declaration and definition of the private classes ArgumentFingerprint
+ *        and CallFingerprinter
+ */
+
+#ifndef CALLFINGERPRINT_HPP_
+#define CALLFINGERPRINT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ArgumentMatcher/AbstractArgumentMatcher.hpp"
+#include "ArgumentMatcher/AbstractCallMatcher.hpp"
+#include "ArgumentMatcher/ArgumentView.hpp"
+#include "ArgumentMatcher/BytesCallMatcher.hpp"
+#include "internal/TupleMatcher.hpp"
+
+/**
+ * Value of an argument in a fingerprint: two equal arguments (with the "=="
+ * operator) have the same value. Only the scalar types are supported: the
+ * integers and the enumerations by value, the pointers by address, and the
+ * floating-point numbers by their value as a double.
+ */
+template<typename Type,
+         typename BareType = typename std::remove_cv<typename std::remove_reference<Type>::type>::type,
+         bool Supported = std::is_arithmetic<BareType>::value || std::is_enum<BareType>::value
+                          || std::is_pointer<BareType>::value>
+struct ArgumentFingerprint
+{
+    static const bool SUPPORTED = false;
+
+    static std::uint64_t value(const BareType&)
+    {
+        return 0;
+    }
+};
+
+template<typename Type, typename BareType>
+struct ArgumentFingerprint<Type, BareType, true>
+{
+    static const bool SUPPORTED = true;
+
+    /**
+     * Returns the value of an argument in a fingerprint.
+     *
+     * @param arg The argument
+     * @return The value of the argument
+     */
+    static std::uint64_t value(const BareType& arg)
+    {
+        return valueOf(arg, std::is_pointer<BareType>(), std::is_floating_point<BareType>());
+    }
+
+private:
+    static std::uint64_t valueOf(const BareType& arg, std::true_type, std::false_type)
+    {
+        return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(arg));
+    }
+
+    static std::uint64_t valueOf(const BareType& arg, std::false_type, std::true_type)
+    {
+        /* 0.0 == -0.0 */
+        const double number = arg == 0 ? 0.0 : static_cast<double>(arg);
+        std::uint64_t bits;
+
+        std::memcpy(&bits, &number, sizeof(bits));
+        return bits;
+    }
+
+    static std::uint64_t valueOf(const BareType& arg, std::false_type, std::false_type)
+    {
+        return static_cast<std::uint64_t>(arg);
+    }
+};
+
+/**
+ * Whether every type is supported by @ref ArgumentFingerprint, as
+ * AllFingerprinted<Types...>::value.
+ */
+template<typename ... Types>
+struct AllFingerprinted : std::true_type
+{
+};
+
+template<typename Type, typename ... Types>
+struct AllFingerprinted<Type, Types...>
+    : std::integral_constant<bool, ArgumentFingerprint<Type>::SUPPORTED && AllFingerprinted<Types...>::value>
+{
+};
+
+/**
+ * Computes the values of the elements of a tuple of arguments in a
+ * fingerprint.
+ */
+template<typename ValueTuple,
+         typename Indexes = typename MakeIndexSequence<std::tuple_size<ValueTuple>::value>::Type>
+struct TupleFingerprint;
+
+template<typename ValueTuple, std::size_t ... Indexes>
+struct TupleFingerprint<ValueTuple, IndexSequence<Indexes...> >
+{
+    /**
+     * Computes the values of the arguments. The pointers of the content pairs
+     * are replaced by the hash of their content, and their lengths by the
+     * length which is hashed.
+     *
+     * @param values The tuple of arguments
+     * @param contentPairs The positions of the (pointer, length) pairs
+     * @param fingerprintValues The values of the arguments, in the order of
+     *                          the arguments
+     */
+    static void compute(const ValueTuple& values, const std::vector<std::pair<std::size_t, std::size_t> >& contentPairs,
+                        std::uint64_t* fingerprintValues)
+    {
+        const std::uint64_t argumentValues[] = {
+            ArgumentFingerprint<typename std::tuple_element<Indexes, ValueTuple>::type>::value(std::get<Indexes>(values))...,
+            0 };
+
+        std::memcpy(fingerprintValues, argumentValues, sizeof...(Indexes) * sizeof(std::uint64_t));
+
+        if (contentPairs.empty())
+            return;
+
+        const void* const addresses[] = { static_cast<const void*>(std::addressof(std::get<Indexes>(values)))...,
+                                          nullptr };
+        const ArgumentView view(addresses,
+                                ArgumentTypeList<typename std::tuple_element<Indexes, ValueTuple>::type...>::types,
+                                sizeof...(Indexes));
+
+        for (const std::pair<std::size_t, std::size_t>& contentPair : contentPairs) {
+            const void* dataPtr = view.pointer(contentPair.first);
+            const std::size_t length = dataPtr != nullptr ? view.length(contentPair.second) : 0;
+
+            fingerprintValues[contentPair.first] = BytesCallMatcher::hash(dataPtr, length);
+            fingerprintValues[contentPair.second] = length;
+        }
+    }
+};
+
+/**
+ * Computes the 64-bit fingerprints of the calls of a mock: a hash of their
+ * arguments, so that two calls with equal arguments have the same
+ * fingerprint. The arguments registered as the pointer of a (pointer, length)
+ * pair are hashed by content instead of by address.
+ */
+template<typename ... ArgumentTypes>
+class CallFingerprinter
+{
+public:
+    /**
+     * Whether the types of the arguments can be fingerprinted
+     */
+    static const bool SUPPORTED = AllFingerprinted<ArgumentTypes...>::value;
+
+    CallFingerprinter()
+        : contentPairs()
+    {
+    }
+
+    /**
+     * Hashes a buffer passed as a pointer and a length by content. It throws
+     * a std::runtime_error if the arguments are not a pointer and an integer.
+     *
+     * @param pointerPosition The position of the pointer argument
+     * @param lengthPosition The position of the length argument
+     */
+    void addContent(std::size_t pointerPosition, std::size_t lengthPosition)
+    {
+        BytesCallMatcher(pointerPosition, lengthPosition, BytesCallMatcher::EQUAL, std::string()).checkTypes(
+            ArgumentTypeList<ArgumentTypes...>::types, sizeof...(ArgumentTypes));
+
+        contentPairs.push_back(std::make_pair(pointerPosition, lengthPosition));
+    }
+
+    /**
+     * Returns the fingerprint of a tuple of arguments.
+     *
+     * @param values The arguments
+     * @return The fingerprint of the arguments
+     */
+    template<typename ValueTuple>
+    std::uint64_t of(const ValueTuple& values) const
+    {
+        std::uint64_t fingerprintValues[sizeof...(ArgumentTypes) + 1];
+
+        TupleFingerprint<ValueTuple>::compute(values, contentPairs, fingerprintValues);
+
+        return combine(fingerprintValues);
+    }
+
+    /**
+     * Computes the fingerprint of the calls matched by an instance of
+     * argument matchers, when each of them matches a single value.
+     *
+     * @param fingerprint The fingerprint of the matched calls
+     * @param matchersPtr Pointers to argument matchers
+     * @return Whether the matched calls have a single fingerprint
+     */
+    bool ofFixedValues(std::uint64_t& fingerprint, AbstractArgumentMatcher<ArgumentTypes>* ... matchersPtr) const
+    {
+        bool fixed = true;
+        /* A matcher of a pointer compares addresses, not contents */
+        std::uint64_t fingerprintValues[] = { fixedValue(matchersPtr, fixed)..., 0 };
+
+        if (!fixed || !contentPairs.empty())
+            return false;
+
+        fingerprint = combine(fingerprintValues);
+        return true;
+    }
+
+    /**
+     * Computes the fingerprint of the calls matched by a matcher of the whole
+     * call, when it matches every argument with a single value: the
+     * arguments must be a content pair matched with ArgumentMatcher::bytesEq.
+     *
+     * @param fingerprint The fingerprint of the matched calls
+     * @param callMatcher The call matcher
+     * @return Whether the matched calls have a single fingerprint
+     */
+    bool ofFixedCall(std::uint64_t& fingerprint, const AbstractCallMatcher& callMatcher) const
+    {
+        if (sizeof...(ArgumentTypes) != 2 || contentPairs.size() != 1)
+            return false;
+
+        const std::string* bytesPtr = callMatcher.fixedBytes(contentPairs[0].first, contentPairs[0].second);
+
+        if (bytesPtr == nullptr)
+            return false;
+
+        std::uint64_t fingerprintValues[sizeof...(ArgumentTypes) + 1];
+
+        fingerprintValues[contentPairs[0].first] = BytesCallMatcher::hash(bytesPtr->data(), bytesPtr->size());
+        fingerprintValues[contentPairs[0].second] = bytesPtr->size();
+
+        fingerprint = combine(fingerprintValues);
+        return true;
+    }
+
+private:
+    std::vector<std::pair<std::size_t, std::size_t> > contentPairs;
+
+    template<typename Type>
+    static std::uint64_t fixedValue(AbstractArgumentMatcher<Type>* matcherPtr, bool& fixed)
+    {
+        const typename std::remove_reference<Type>::type* valuePtr = matcherPtr->fixedValue();
+
+        if (valuePtr == nullptr) {
+            fixed = false;
+            return 0;
+        }
+
+        return ArgumentFingerprint<Type>::value(*valuePtr);
+    }
+
+    static std::uint64_t combine(const std::uint64_t* fingerprintValues)
+    {
+        std::uint64_t fingerprint = 0x9E3779B97F4A7C15ULL;
+
+        for (std::size_t position = 0; position < sizeof...(ArgumentTypes); position++) {
+            fingerprint ^= fingerprintValues[position] + 0x9E3779B97F4A7C15ULL + (fingerprint << 6) + (fingerprint >> 2);
+            fingerprint *= 0xBF58476D1CE4E5B9ULL;
+            fingerprint ^= fingerprint >> 31;
+        }
+
+        return fingerprint;
+    }
+};
+
+#endif /* CALLFINGERPRINT_HPP_ */
@@ -0,0 +1,226 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallRecord.hpp
+ * @brief Declaration and definition of the private class CallRecord
+ */
+
+#ifndef CALLRECORD_HPP_
+#define CALLRECORD_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "CallSequence.hpp"
+
+/**
+ * Part of a call entry which does not depend on the signature of the mock:
+ * the sequence numbers of the call, or of the repeated calls it stands for.
+ * The history of every mock is handled over call records by the
+ * @ref MockCore.
+ *
+ * The repeated calls are kept as a run of evenly spaced sequence numbers,
+ * like the calls of a polling loop which only calls this mock. From the
+ * first call breaking the spacing, like a loop which calls another mock a
+ * variable number of times, the differences between the sequence numbers
+ * are stored as varints of a byte or two, with the position of every
+ * CHECKPOINT_INTERVAL-th call to find a call without decoding the whole
+ * run.
+ */
+class CallRecord
+{
+public:
+    /**
+     * Constructor of CallRecord
+     */
+    CallRecord()
+        : sequence(CallSequence::NONE), stride(0), repeats(1), unevenCallsPtr()
+    {
+    }
+
+    /**
+     * Copy constructor of CallRecord
+     *
+     * @param other The call record to copy
+     */
+    CallRecord(const CallRecord& other)
+        : sequence(other.sequence), stride(other.stride), repeats(other.repeats),
+          unevenCallsPtr(other.unevenCallsPtr ? new UnevenCalls(*other.unevenCallsPtr) : nullptr)
+    {
+    }
+
+    /**
+     * Assignment operator of CallRecord
+     *
+     * @param other The call record to copy
+     * @return The call record
+     */
+    CallRecord& operator=(const CallRecord& other)
+    {
+        sequence = other.sequence;
+        stride = other.stride;
+        repeats = other.repeats;
+        unevenCallsPtr.reset(other.unevenCallsPtr ? new UnevenCalls(*other.unevenCallsPtr) : nullptr);
+
+        return *this;
+    }
+
+    /**
+     * Destructor of CallRecord
+     */
+    virtual ~CallRecord()
+    {
+    }
+
+    /**
+     * Returns the sequence number of the call (see @ref CallSequence), or of
+     * the first call when the entry stands for repeated calls.
+     *
+     * @return The sequence number of the call
+     */
+    CallSequence::Number sequenceNumber() const
+    {
+        return sequence;
+    }
+
+    /**
+     * Returns the number of calls the entry stands for: consecutive calls
+     * with the same arguments may be recorded as a single entry (see
+     * Mock::compressRepeatedCalls).
+     *
+     * @return The number of calls
+     */
+    unsigned int repeatCount() const
+    {
+        return repeats;
+    }
+
+    /**
+     * Returns the sequence number of the last call of the entry.
+     *
+     * @return The sequence number of the last call
+     */
+    CallSequence::Number lastSequenceNumber() const
+    {
+        return unevenCallsPtr ? unevenCallsPtr->last : lastEvenSequenceNumber();
+    }
+
+    /**
+     * Returns the sequence number of the first call of the entry which
+     * happened after the provided sequence number, which must be lower than
+     * the sequence number of the last call.
+     *
+     * @param after A sequence number
+     * @return The sequence number of the first call after it
+     */
+    CallSequence::Number sequenceNumberAfter(CallSequence::Number after) const;
+
+    /**
+     * Returns the number of calls of the entry which happened strictly
+     * between two sequence numbers.
+     *
+     * @param after The sequence number after which the calls are counted
+     * @param before The sequence number before which the calls are counted
+     * @return The number of calls between the sequence numbers
+     */
+    unsigned int repeatsBetween(CallSequence::Number after, CallSequence::Number before) const
+    {
+        if (before <= after + 1)
+            return 0;
+
+        return callsUntil(before - 1) - callsUntil(after);
+    }
+
+    /**
+     * Adds a call to the entry.
+     *
+     * @param number The sequence number of the call, greater than the one of
+     *               the last call of the entry
+     */
+    void repeat(CallSequence::Number number);
+
+    /**
+     * Sets the sequence number of the call (see @ref CallSequence).
+     *
+     * @param number The sequence number of the call
+     */
+    void setSequenceNumber(CallSequence::Number number)
+    {
+        sequence = number;
+    }
+
+private:
+    /**
+     * Calls of the entry after the evenly spaced ones
+     */
+    struct UnevenCalls
+    {
+        /**
+         * Position of a call in the varints
+         */
+        struct Checkpoint
+        {
+            CallSequence::Number number; /**< The sequence number of the call */
+            std::size_t offset;          /**< The offset of the varint of the next call */
+        };
+
+        std::vector<unsigned char> deltas;
+        std::vector<Checkpoint> checkpoints;
+        CallSequence::Number last;
+        unsigned int count;
+    };
+
+    static const unsigned int CHECKPOINT_INTERVAL = 64;
+
+    CallSequence::Number sequence;
+    CallSequence::Number stride;
+    unsigned int repeats;
+    std::unique_ptr<UnevenCalls> unevenCallsPtr;
+
+    /**
+     * Returns the number of evenly spaced calls.
+     *
+     * @return The number of evenly spaced calls
+     */
+    unsigned int evenRepeats() const
+    {
+        return unevenCallsPtr ? repeats - unevenCallsPtr->count : repeats;
+    }
+
+    /**
+     * Returns the sequence number of the last evenly spaced call.
+     *
+     * @return The sequence number of the last evenly spaced call
+     */
+    CallSequence::Number lastEvenSequenceNumber() const
+    {
+        return sequence + stride * (evenRepeats() - 1);
+    }
+
+    /**
+     * Returns the number of calls of the entry up to a sequence number.
+     *
+     * @param until The sequence number, included
+     * @return The number of calls up to the sequence number
+     */
+    unsigned int callsUntil(CallSequence::Number until) const;
+
+    /**
+     * Finds the first uneven call after a sequence number.
+     *
+     * @param after The sequence number, not lower than the one of the last
+     *              evenly spaced call
+     * @param number The sequence number of the call, unchanged if none
+     * @return The index of the call among the uneven calls, their count if
+     *         none
+     */
+    unsigned int unevenCallAfter(CallSequence::Number after, CallSequence::Number& number) const;
+};
+
+#endif /* CALLRECORD_HPP_ */
@@ -0,0 +1,91 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallSiteTable.hpp
+ * @brief Declaration and definition of private class CallSiteTable
+ */
+
+#ifndef CALLSITETABLE_HPP_
+#define CALLSITETABLE_HPP_
+
+#include <unordered_map>
+
+#if defined(__GNUC__)
+/**
+ * Forces the inlining of a function, so that MOCKEUR_RETURN_ADDRESS evaluated
+ * in it refers to the function it is inlined into.
+ */
+#define MOCKEUR_ALWAYS_INLINE inline __attribute__((always_inline))
+
+/**
+ * Returns the address the current function returns to.
+ */
+#define MOCKEUR_RETURN_ADDRESS() __builtin_return_address(0)
+#else
+#define MOCKEUR_ALWAYS_INLINE inline
+#define MOCKEUR_RETURN_ADDRESS() nullptr
+#endif
+
+/**
+ * Counts the calls per call site, a call site being identified by a return
+ * address. The last call site is cached, so that consecutive calls from the
+ * same site, like in a polling loop, do not even hash the address.
+ */
+class CallSiteTable
+{
+public:
+    typedef std::unordered_map<const void*, unsigned long long> CountMap;
+
+    CallSiteTable()
+        : counts(), lastAddress(nullptr), lastCountPtr(nullptr)
+    {
+    }
+
+    /**
+     * Counts a call from the provided call site.
+     *
+     * @param address The return address of the call
+     */
+    void record(const void* address)
+    {
+        if (address != lastAddress || lastCountPtr == nullptr) {
+            lastAddress = address;
+            /* References to the elements stay valid when the map grows */
+            lastCountPtr = &(counts[address]);
+        }
+
+        (*lastCountPtr)++;
+    }
+
+    /**
+     * Forgets every call.
+     */
+    void clear()
+    {
+        counts.clear();
+        lastAddress = nullptr;
+        lastCountPtr = nullptr;
+    }
+
+    /**
+     * Returns the number of calls per call site.
+     *
+     * @return The number of calls per call site
+     */
+    const CountMap& countsPerSite() const
+    {
+        return counts;
+    }
+
+private:
+    CountMap counts;
+    const void* lastAddress;
+    unsigned long long* lastCountPtr;
+};
+
+#endif /* CALLSITETABLE_HPP_ */
@@ -0,0 +1,111 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallTimer.hpp
+ * @brief Declaration and definition of private class CallTimer
+ */
+
+#ifndef CALLTIMER_HPP_
+#define CALLTIMER_HPP_
+
+#include <atomic>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MOCKEUR_HAS_TSC 1
+#else
+#define MOCKEUR_HAS_TSC 0
+#endif
+
+/**
+ * Source of the timestamps of the calls. Reading it must be as cheap as
+ * possible, so the timestamps are counted in ticks:
+ *  - of the time-stamp counter of the processor when it is invariant (x86);
+ *  - of std::chrono::steady_clock (nanoseconds) otherwise.
+ *
+ * The ticks are converted into nanoseconds afterwards, with a @ref Scale.
+ */
+class CallTimer
+{
+public:
+    /**
+     * Conversion of ticks into nanoseconds of std::chrono::steady_clock
+     */
+    class Scale
+    {
+    public:
+        /**
+         * Constructor of Scale
+         *
+         * @param providedTickOrigin A number of ticks
+         * @param providedNanosecondOrigin The time, in nanoseconds, of
+         *                                 providedTickOrigin
+         * @param providedNanosecondsPerTick The duration of a tick, in
+         *                                   nanoseconds
+         */
+        Scale(long long providedTickOrigin, long long providedNanosecondOrigin, double providedNanosecondsPerTick)
+            : tickOrigin(providedTickOrigin),
+              nanosecondOrigin(providedNanosecondOrigin),
+              nanosecondsPerTick(providedNanosecondsPerTick)
+        {
+        }
+
+        /**
+         * Converts ticks into nanoseconds of std::chrono::steady_clock.
+         *
+         * @param ticks The ticks to convert
+         * @return The time of the ticks, in nanoseconds
+         */
+        long long toNanoseconds(long long ticks) const
+        {
+            return nanosecondOrigin + static_cast<long long>(static_cast<double>(ticks - tickOrigin) * nanosecondsPerTick);
+        }
+
+    private:
+        long long tickOrigin;
+        long long nanosecondOrigin;
+        double nanosecondsPerTick;
+    };
+
+    /**
+     * Chooses the source of the ticks. It must be called before the first
+     * call to @ref now; the following calls do nothing.
+     */
+    static void start();
+
+    /**
+     * Returns the current time, in ticks.
+     *
+     * @return The current time, in ticks
+     */
+    static long long now()
+    {
+#if MOCKEUR_HAS_TSC
+        if (tscUsed.load(std::memory_order_relaxed))
+            return static_cast<long long>(__rdtsc());
+#endif
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Returns the conversion of the ticks returned so far by @ref now into
+     * nanoseconds. The longer the time since @ref start, the more accurate
+     * the conversion.
+     *
+     * @return The conversion of ticks into nanoseconds
+     */
+    static Scale scale();
+
+private:
+    static std::atomic<bool> tscUsed;
+};
+
+#endif /* CALLTIMER_HPP_ */
@@ -0,0 +1,148 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file ControlRegion.hpp
+ * @brief Declaration and definition of the private structures of the
+ *        shared-memory region of the @ref ControlPlane
+ */
+
+#ifndef CONTROLREGION_HPP_
+#define CONTROLREGION_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "The control region needs lock-free atomics between processes");
+
+/**
+ * Ring of items between one producer and one consumer, which may be in
+ * different processes. Neither side ever waits for the other: a push fails
+ * when the ring is full, and a pop when it is empty.
+ */
+template<typename Item, unsigned int Capacity>
+struct ControlRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "The capacity of a ring must be a power of 2");
+
+    /* Indexes of the next item to pop and to push, each written by one side */
+    alignas(64) std::atomic<std::uint32_t> head;
+    alignas(64) std::atomic<std::uint32_t> tail;
+    alignas(64) Item items[Capacity];
+
+    /**
+     * Empties the ring, before the other side uses it.
+     */
+    void reset()
+    {
+        head.store(0);
+        tail.store(0);
+    }
+
+    /**
+     * Adds an item at the end of the ring (producer side).
+     *
+     * @param item The item
+     * @return Whether the item has been added, false if the ring is full
+     */
+    bool push(const Item& item)
+    {
+        const std::uint32_t currentTail = tail.load(std::memory_order_relaxed);
+
+        if (currentTail - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        items[currentTail % Capacity] = item;
+        tail.store(currentTail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Removes the item at the start of the ring (consumer side).
+     *
+     * @param item The item removed
+     * @return Whether an item has been removed, false if the ring is empty
+     */
+    bool pop(Item& item)
+    {
+        const std::uint32_t currentHead = head.load(std::memory_order_relaxed);
+
+        if (tail.load(std::memory_order_acquire) == currentHead)
+            return false;
+
+        item = items[currentHead % Capacity];
+        head.store(currentHead + 1, std::memory_order_release);
+
+        return true;
+    }
+};
+
+/**
+ * Command sent by a @ref ControlClient
+ */
+struct ControlCommand
+{
+    enum Type
+    {
+        LIST,            /**< Lists the named mocks and their call counts */
+        CALL_COUNT,      /**< Reads the call count of a mock */
+        SWITCH_BEHAVIOR, /**< Switches a mock to one of its behaviors */
+        SET_RETURN       /**< Makes a mock return a value */
+    };
+
+    std::uint32_t id;
+    std::uint32_t type;
+    char mockName[64];
+    char argument[64];
+};
+
+/**
+ * Response of the @ref ControlPlane to a command. A command gets a single
+ * response, but LIST which gets a response with the status MORE per mock.
+ */
+struct ControlResponse
+{
+    enum Status
+    {
+        DONE,
+        MORE,
+        UNKNOWN_MOCK,
+        UNKNOWN_BEHAVIOR,
+        INVALID_VALUE,
+        UNKNOWN_COMMAND
+    };
+
+    std::uint32_t id;
+    std::int32_t status;
+    std::uint64_t value;
+    char text[64];
+};
+
+/**
+ * Layout of the shared-memory region of a @ref ControlPlane. The magic
+ * number is written last, once the region is ready for the clients. The
+ * texts of the commands and of the responses may not be terminated, when
+ * the other side wrote a whole buffer.
+ */
+struct ControlRegion
+{
+    static const std::uint32_t MAGIC = 0x4d4f434b;
+    static const std::uint32_t VERSION = 2;
+
+    std::atomic<std::uint32_t> magic;
+    std::uint32_t version;
+    /* Process of the control plane serving the region, 0 if none */
+    std::atomic<std::int32_t> serverPid;
+    /* Process of the client attached to the region, 0 if none */
+    std::atomic<std::int32_t> clientPid;
+    std::atomic<std::uint32_t> nextCommandId;
+    ControlRing<ControlCommand, 16> commands;
+    ControlRing<ControlResponse, 64> responses;
+};
+
+#endif /* CONTROLREGION_HPP_ */
@@ -20,8 +20,15 @@
 #include "internal/AbstractCallHandler.hpp"
 
 #include <list>
-#include <stdexcept>
 
+/**
+ * Throws a @ref std::runtime_error telling that the @ref Mock object has not
+ * been configured for the arguments of the call. It is not inlined in every
+ * instance of @ref DefaultCallHandler.
+ *
+ * @throws A @ref std::runtime_error
+ */
+[[noreturn]] void throwMockNotConfigured();
 
 /**
  * DefaultCallHandler matches any arguments and always throws an exception
@@ -58,7 +65,7 @@ public:
      */
     ReturnType value(ArgumentTypes ...)
     {
-        throw std::runtime_error("Mock object is not configured for these values.");
+        throwMockNotConfigured();
     }
 
     /**
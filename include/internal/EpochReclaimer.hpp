@@ -0,0 +1,101 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file EpochReclaimer.hpp
+ * @brief Declaration of the private classes EpochReclaimer and EpochGuard
+ */
+
+#ifndef EPOCHRECLAIMER_HPP_
+#define EPOCHRECLAIMER_HPP_
+
+/**
+ * Epoch-based reclamation of the objects which may still be read by other
+ * threads, like the call handlers of a mock replaced while it is called.
+ *
+ * A reader announces the current epoch while it reads (see @ref EpochGuard),
+ * which only costs stores to memory owned by its thread: it never blocks. A
+ * writer first unpublishes an object, then retires it: the object is deleted
+ * once every reader which could have read it has left its read section.
+ */
+class EpochReclaimer
+{
+public:
+    /**
+     * Function deleting a retired object
+     */
+    typedef void (*Deleter)(void* objectPtr);
+
+    /**
+     * Enters a read section of the current thread. The read sections may be
+     * nested.
+     */
+    static void enter();
+
+    /**
+     * Leaves a read section of the current thread.
+     */
+    static void leave();
+
+    /**
+     * Deletes an object which is no longer published, once no reader can read
+     * it anymore. It may be deleted before the method returns.
+     *
+     * @param objectPtr The object
+     * @param deleter The function deleting the object
+     */
+    static void retire(void* objectPtr, Deleter deleter);
+
+    /**
+     * Deletes an object which is no longer published, once no reader can read
+     * it anymore.
+     *
+     * @param objectPtr The object
+     */
+    template<typename Type>
+    static void retire(Type* objectPtr)
+    {
+        retire(objectPtr, &deleteObject<Type>);
+    }
+
+    /**
+     * Deletes the retired objects which no reader can read anymore.
+     *
+     * @return The number of objects which are still retired
+     */
+    static unsigned long collect();
+
+private:
+    template<typename Type>
+    static void deleteObject(void* objectPtr)
+    {
+        delete static_cast<Type*>(objectPtr);
+    }
+};
+
+/**
+ * Read section of the current thread, for its scope.
+ */
+class EpochGuard
+{
+public:
+    EpochGuard()
+    {
+        EpochReclaimer::enter();
+    }
+
+    ~EpochGuard()
+    {
+        EpochReclaimer::leave();
+    }
+
+private:
+    EpochGuard(const EpochGuard&);
+    EpochGuard& operator=(const EpochGuard&);
+};
+
+#endif /* EPOCHRECLAIMER_HPP_ */
@@ -0,0 +1,294 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file FaultInjector.hpp
+ * @brief Declaration and definition of private classes FaultInjector and
+ *        FaultBehavior
+ */
+
+#ifndef FAULTINJECTOR_HPP_
+#define FAULTINJECTOR_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+#include "internal/CallBehavior.hpp"
+
+/**
+ * FaultInjector decides, call after call, whether a call must fail. Its whole
+ * state is stored inline, so that it can be embedded in a @ref FaultBehavior.
+ *
+ * The random decisions are drawn from a splitmix64 generator: a run is fully
+ * determined by the seed.
+ *
+ * The injector is configured before the handler is published. Then, the
+ * calls from several threads advance its state with relaxed atomic
+ * operations, without any lock: each call draws its own random number, and
+ * exactly the configured number of calls succeed before failAfter fails. Only
+ * the bursts of concurrent calls may overlap.
+ */
+class FaultInjector
+{
+public:
+    /**
+     * Default seed of the random generator
+     */
+    static const std::uint64_t DEFAULT_SEED = 0x5eed5eed5eed5eedULL;
+
+    /**
+     * Constructor of FaultInjector. No call fails.
+     */
+    FaultInjector()
+        : mode(NONE), randomState(0), threshold(0), remaining(0), length(0),
+          initialRandomState(0), initialRemaining(0)
+    {
+    }
+
+    /**
+     * Returns whether some calls may fail.
+     *
+     * @return Whether some calls may fail
+     */
+    bool enabled() const
+    {
+        return mode != NONE;
+    }
+
+    /**
+     * No call fails.
+     */
+    void disable()
+    {
+        mode = NONE;
+    }
+
+    /**
+     * Goes back to the state before the first call, so that the same calls
+     * fail again.
+     */
+    void rewind()
+    {
+        randomState.store(initialRandomState, std::memory_order_relaxed);
+        remaining.store(initialRemaining, std::memory_order_relaxed);
+    }
+
+    /**
+     * Each call fails with the provided probability.
+     *
+     * @param probability The probability for a call to fail (between 0 and 1)
+     * @param seed The seed of the random generator
+     */
+    void failWithProbability(double probability, std::uint64_t seed)
+    {
+        mode = PROBABILITY;
+        threshold = toThreshold(probability);
+        setInitialState(seed, 0);
+    }
+
+    /**
+     * The calls fail in bursts: when no burst is ongoing, a burst starts with
+     * the provided probability, and then the burstLength next calls fail
+     * (including the current one).
+     *
+     * @param probability The probability for a burst to start
+     * @param burstLength The number of consecutive calls which fail
+     * @param seed The seed of the random generator
+     */
+    void failInBursts(double probability, std::uint64_t burstLength, std::uint64_t seed)
+    {
+        mode = BURST;
+        threshold = toThreshold(probability);
+        length = burstLength;
+        setInitialState(seed, 0);
+    }
+
+    /**
+     * The calls succeed a given number of times, then they always fail.
+     *
+     * @param successfulCalls The number of calls which succeed
+     */
+    void failAfter(std::uint64_t successfulCalls)
+    {
+        mode = AFTER;
+        setInitialState(0, successfulCalls);
+    }
+
+    /**
+     * Returns whether the current call fails.
+     *
+     * @return Whether the current call fails
+     */
+    bool nextCallFails()
+    {
+        switch (mode) {
+        case PROBABILITY:
+            return nextRandom() < threshold;
+
+        case BURST:
+            /* The current call is the first one of its burst */
+            if (takeRemaining())
+                return true;
+
+            if (length == 0 || nextRandom() >= threshold)
+                return false;
+
+            remaining.fetch_add(length - 1, std::memory_order_relaxed);
+            return true;
+
+        case AFTER:
+            return !takeRemaining();
+
+        case NONE:
+        default:
+            return false;
+        }
+    }
+
+private:
+    enum Mode
+    {
+        NONE,
+        PROBABILITY,
+        BURST,
+        AFTER
+    };
+
+    /* Increment of the splitmix64 state */
+    static const std::uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+    Mode mode;
+    std::atomic<std::uint64_t> randomState;
+    std::uint64_t threshold; /* A random number below it means a failure */
+    std::atomic<std::uint64_t> remaining;
+    std::uint64_t length;
+    std::uint64_t initialRandomState;
+    std::uint64_t initialRemaining;
+
+    /**
+     * Sets the state before the first call, and saves it for rewind.
+     *
+     * @param seed The seed of the random generator
+     * @param remainingCalls The number of calls counted down
+     */
+    void setInitialState(std::uint64_t seed, std::uint64_t remainingCalls)
+    {
+        initialRandomState = seed;
+        initialRemaining = remainingCalls;
+        rewind();
+    }
+
+    /**
+     * Counts down one of the remaining calls, if any.
+     *
+     * @return Whether a remaining call has been counted down
+     */
+    bool takeRemaining()
+    {
+        std::uint64_t current = remaining.load(std::memory_order_relaxed);
+
+        while (current != 0) {
+            if (remaining.compare_exchange_weak(current, current - 1, std::memory_order_relaxed))
+                return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Returns the next number of the splitmix64 generator. Its state only
+     * advances by a constant, so that concurrent calls draw distinct numbers.
+     *
+     * @return The next random number
+     */
+    std::uint64_t nextRandom()
+    {
+        std::uint64_t z = randomState.fetch_add(GOLDEN_GAMMA, std::memory_order_relaxed) + GOLDEN_GAMMA;
+
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+        return z ^ (z >> 31);
+    }
+
+    /**
+     * Converts a probability into the threshold to compare random numbers
+     * with.
+     *
+     * @param probability The probability
+     * @return The threshold
+     */
+    static std::uint64_t toThreshold(double probability)
+    {
+        if (probability <= 0.0)
+            return 0;
+
+        if (probability >= 1.0)
+            return UINT64_MAX;
+
+        /* 2^64 * probability */
+        return static_cast<std::uint64_t>(probability * 18446744073709551616.0);
+    }
+
+    FaultInjector(const FaultInjector&);
+    FaultInjector& operator=(const FaultInjector&);
+};
+
+/**
+ * Behavior of a call handler injecting faults: the injector, and the values a
+ * call returns when it fails or succeeds, stored inline. Only the handlers
+ * which inject faults allocate it, so that the return type needs no default
+ * constructor, and each call advances the injector directly.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class FaultBehavior : public CallBehavior<ReturnType, ArgumentTypes...>
+{
+public:
+    /**
+     * Constructor of FaultBehavior. No call fails until the injector is
+     * configured.
+     *
+     * @param providedErrorValue The value returned by a failing call
+     * @param providedOkValue The value returned by a successful call
+     */
+    FaultBehavior(ReturnType providedErrorValue, ReturnType providedOkValue)
+        : faultInjector(), errorValue(providedErrorValue), okValue(providedOkValue)
+    {
+    }
+
+    /**
+     * Returns the injector, to configure it before the handler is published.
+     *
+     * @return The injector
+     */
+    FaultInjector& injector()
+    {
+        return faultInjector;
+    }
+
+    /**
+     * Returns the value of the current call.
+     *
+     * @return The error value if the call fails, the ok value otherwise
+     */
+    ReturnType value(ArgumentTypes...)
+    {
+        return faultInjector.nextCallFails() ? errorValue : okValue;
+    }
+
+    void rewind()
+    {
+        faultInjector.rewind();
+    }
+
+private:
+    FaultInjector faultInjector;
+    const ReturnType errorValue;
+    const ReturnType okValue;
+};
+
+#endif /* FAULTINJECTOR_HPP_ */
@@ -0,0 +1,175 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file HandlerSnapshot.hpp
+ * @brief Declaration of private classes HandlerSnapshot, MockSnapshot and
+ *        HandlerVersion
+ */
+
+#ifndef HANDLERSNAPSHOT_HPP_
+#define HANDLERSNAPSHOT_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "internal/BaseCallHandler.hpp"
+
+class HandlerSnapshot;
+
+/**
+ * Immutable list of the call handlers of a mock, published to the threads
+ * calling the mock: a change of the handlers publishes a new version instead
+ * of modifying the list being read.
+ *
+ * Each snapshot has its own version, built once, which the mock publishes as
+ * it is while no handler is added since the snapshot. Otherwise, the mock
+ * publishes a version of its own, which keeps its baseline alive, but not the
+ * handlers added since the baseline, which the mock retires itself when they
+ * are removed.
+ */
+class HandlerVersion
+{
+public:
+    /**
+     * Constructor of HandlerVersion
+     *
+     * @param providedBaselinePtr The baseline, whose handlers are tried first
+     *                            (may be null)
+     * @param addedHandlers The handlers added since the baseline
+     */
+    HandlerVersion(const std::shared_ptr<const HandlerSnapshot>& providedBaselinePtr,
+                   const std::vector<BaseCallHandler*>& addedHandlers);
+
+    /**
+     * Constructor of HandlerVersion, for the version of a snapshot
+     *
+     * @param providedHandlers The handlers, in the order they are tried
+     */
+    explicit HandlerVersion(const std::vector<BaseCallHandler*>& providedHandlers)
+        : baselinePtr(), handlerList(providedHandlers)
+    {
+    }
+
+    /**
+     * Returns the handlers, in the order they are tried.
+     *
+     * @return The handlers
+     */
+    const std::vector<BaseCallHandler*>& handlers() const
+    {
+        return handlerList;
+    }
+
+private:
+    std::shared_ptr<const HandlerSnapshot> baselinePtr;
+    std::vector<BaseCallHandler*> handlerList;
+
+    HandlerVersion(const HandlerVersion&);
+    HandlerVersion& operator=(const HandlerVersion&);
+};
+
+/**
+ * Immutable configuration of a mock: its call handlers, in the order they
+ * are tried. A snapshot owns the handlers added since its parent snapshot and
+ * shares the handlers of its parent, so that taking a snapshot of a mock
+ * configured from a snapshot only copies the pointers of the new handlers.
+ *
+ * @see Mock::snapshot
+ */
+class HandlerSnapshot
+{
+public:
+    /**
+     * Constructor of HandlerSnapshot. It takes the ownership of the provided
+     * handlers.
+     *
+     * @param providedParentPtr The previous snapshot, whose handlers are tried
+     *                          first (may be null)
+     * @param providedHandlers The handlers added since the previous snapshot
+     */
+    HandlerSnapshot(const std::shared_ptr<const HandlerSnapshot>& providedParentPtr,
+                    const std::vector<BaseCallHandler*>& providedHandlers);
+
+    /**
+     * Destructor of HandlerSnapshot. It deletes the owned handlers.
+     */
+    ~HandlerSnapshot();
+
+    /**
+     * Returns every handler of the snapshot, in the order they are tried.
+     *
+     * @return The handlers of the snapshot
+     */
+    const std::vector<BaseCallHandler*>& handlers() const
+    {
+        return ownVersion.handlers();
+    }
+
+    /**
+     * Returns the version of the handlers of the snapshot, published while no
+     * handler is added to it.
+     *
+     * @return The version of the snapshot
+     */
+    const HandlerVersion& version() const
+    {
+        return ownVersion;
+    }
+
+    /**
+     * Brings the handlers which have a state (like fault injection) back to
+     * their state as configured, before their first call.
+     */
+    void rewind() const;
+
+private:
+    std::shared_ptr<const HandlerSnapshot> parentPtr;
+    std::vector<BaseCallHandler*> ownedHandlers;
+    HandlerVersion ownVersion;
+    std::vector<BaseCallHandler*> statefulHandlers;
+
+    HandlerSnapshot(const HandlerSnapshot&);
+    HandlerSnapshot& operator=(const HandlerSnapshot&);
+};
+
+/**
+ * Snapshot of a mock of a given type, so that a snapshot can only be
+ * restored in a mock of the same type. It adds nothing to
+ * @ref HandlerSnapshot.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class MockSnapshot : public HandlerSnapshot
+{
+public:
+    /**
+     * Constructor of MockSnapshot
+     *
+     * @param providedParentPtr The previous snapshot (may be null)
+     * @param providedHandlers The handlers added since the previous snapshot
+     */
+    MockSnapshot(const std::shared_ptr<const HandlerSnapshot>& providedParentPtr,
+                 const std::vector<BaseCallHandler*>& providedHandlers)
+        : HandlerSnapshot(providedParentPtr, providedHandlers)
+    {
+    }
+
+    /**
+     * Creates a snapshot of the type, for the @ref MockCore.
+     *
+     * @param providedParentPtr The previous snapshot (may be null)
+     * @param providedHandlers The handlers added since the previous snapshot
+     * @return The snapshot
+     */
+    static std::shared_ptr<const HandlerSnapshot> create(const std::shared_ptr<const HandlerSnapshot>& providedParentPtr,
+                                                         const std::vector<BaseCallHandler*>& providedHandlers)
+    {
+        return std::make_shared<const MockSnapshot>(providedParentPtr, providedHandlers);
+    }
+};
+
+#endif /* HANDLERSNAPSHOT_HPP_ */
@@ -0,0 +1,378 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockCore.hpp
+ * @brief Declaration of the private class MockCore
+ */
+
+#ifndef MOCKCORE_HPP_
+#define MOCKCORE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "CallSequence.hpp"
+#include "internal/BaseCallHandler.hpp"
+#include "internal/CallRecord.hpp"
+#include "internal/HandlerSnapshot.hpp"
+
+/**
+ * Part of a mock which does not depend on its signature, compiled once in the
+ * library: the storage and the publication of the call handlers, and the
+ * history of the calls. The handlers and the calls are stored without their
+ * type; the Mock template only adds what reads the arguments (the matching of
+ * the handlers and of the queries, the policy and the fingerprints), so that
+ * each signature only instantiates a thin layer.
+ *
+ * The methods on the handlers lock them. The methods on the history do not:
+ * the lock of the history (see @ref historyMutex) must be held.
+ */
+class MockCore
+{
+public:
+    /**
+     * Function telling whether a call is matched by a query of the mock
+     */
+    typedef bool (*RecordFilter)(const void* queryPtr, const CallRecord& record);
+
+    /**
+     * Function computing the fingerprint of the arguments of a call
+     */
+    typedef std::uint64_t (*RecordFingerprint)(const void* fingerprinterPtr, const CallRecord& record);
+
+    /**
+     * Function creating a snapshot of the type of the mock
+     */
+    typedef std::shared_ptr<const HandlerSnapshot> (*SnapshotFactory)(
+        const std::shared_ptr<const HandlerSnapshot>& parentPtr, const std::vector<BaseCallHandler*>& handlers);
+
+    /**
+     * Calls with the same fingerprint, see @ref topRecords
+     */
+    struct RecordFrequency
+    {
+        const CallRecord* recordPtr; /**< The first of the calls */
+        unsigned int count;
+    };
+
+    /**
+     * Constructor of MockCore
+     */
+    MockCore();
+
+    /**
+     * Destructor of MockCore. It deletes the handlers.
+     */
+    ~MockCore();
+
+    /**
+     * Returns the handlers read by the calls. The caller must hold an
+     * EpochGuard while it uses them.
+     *
+     * @return The published handlers, or nullptr if none has been added
+     */
+    const HandlerVersion* publishedHandlers() const
+    {
+        return publishedVersionPtr.load();
+    }
+
+    /**
+     * Adds a handler, tried after the others, and publishes it.
+     *
+     * @param handlerPtr The handler, deleted by the core
+     */
+    void addHandler(BaseCallHandler* handlerPtr);
+
+    /**
+     * Adds a handler, tried after the others, which is not configured yet.
+     * It is published once configured (see BaseCallHandler::configured), so
+     * that the calls never see it before.
+     *
+     * @param handlerPtr The handler, deleted by the core
+     */
+    void addPendingHandler(BaseCallHandler* handlerPtr);
+
+    /**
+     * Publishes the handlers, including those which have been configured
+     * since they were added.
+     */
+    void publishConfiguredHandlers();
+
+    /**
+     * Removes every handler, then adds one.
+     *
+     * @param handlerPtr The handler, deleted by the core
+     */
+    void replaceHandlers(BaseCallHandler* handlerPtr);
+
+    /**
+     * Removes every handler.
+     */
+    void clearHandlers();
+
+    /**
+     * Moves the handlers to a new snapshot, unless none has been added since
+     * the previous one.
+     *
+     * @param factory The function creating the snapshot
+     * @return The current snapshot
+     */
+    std::shared_ptr<const HandlerSnapshot> snapshot(SnapshotFactory factory);
+
+    /**
+     * Replaces the handlers by those of a snapshot, and publishes them.
+     *
+     * @param providedSnapshot The snapshot (may be null)
+     */
+    void useSnapshot(const std::shared_ptr<const HandlerSnapshot>& providedSnapshot);
+
+    /**
+     * See Mock::beginUpdate. The updates may be nested: the changes are
+     * published by the commit of the outermost one.
+     */
+    void beginUpdate();
+
+    /**
+     * See Mock::commitUpdate
+     */
+    void commitUpdate();
+
+    /**
+     * Returns the lock of the history.
+     *
+     * @return The lock of the history
+     */
+    std::mutex& historyMutex() const
+    {
+        return historyLock;
+    }
+
+    /**
+     * Returns the last call, if a new call with the same arguments may be
+     * added to it (see Mock::compressRepeatedCalls).
+     *
+     * @return The last call, or nullptr
+     */
+    CallRecord* repeatableRecord() const
+    {
+        return compressionEnabled && !callHistoryList.empty() ? callHistoryList.back() : nullptr;
+    }
+
+    /**
+     * Returns whether the fingerprints of the calls are recorded.
+     *
+     * @return Whether the fingerprints are recorded
+     */
+    bool fingerprintsRecorded() const
+    {
+        return fingerprintsEnabled;
+    }
+
+    /**
+     * Returns the calls, sorted by sequence number.
+     *
+     * @return The history
+     */
+    const std::vector<CallRecord*>& records() const
+    {
+        return callHistoryList;
+    }
+
+    /**
+     * Appends a call to the history.
+     *
+     * @param recordPtr The call, owned by the policy of the mock
+     * @param fingerprint The fingerprint of the call, kept if they are
+     *                    recorded
+     */
+    void append(CallRecord* recordPtr, std::uint64_t fingerprint)
+    {
+        callHistoryList.push_back(recordPtr);
+
+        if (fingerprintsEnabled)
+            callFingerprints.push_back(fingerprint);
+    }
+
+    /**
+     * Wakes the threads waiting for calls, if any.
+     */
+    void notifyRecorded()
+    {
+        if (waiterCount != 0)
+            callRecordedPtr->notify_all();
+    }
+
+    /**
+     * Returns the number of calls matched by a query.
+     *
+     * @param filter The function matching the calls
+     * @param queryPtr The query
+     * @param fingerprintPtr The fingerprint of every matched call, or nullptr
+     * @param threadSafe Whether the filter may be called by several threads
+     *                   at once, so that a large history is scanned by the
+     *                   @ref QueryPool
+     * @return The number of matched calls
+     */
+    unsigned int countCalls(RecordFilter filter, const void* queryPtr, const std::uint64_t* fingerprintPtr,
+                            bool threadSafe) const;
+
+    /**
+     * See Mock::lastCallIndex
+     */
+    CallSequence::Number lastCall(RecordFilter filter, const void* queryPtr) const;
+
+    /**
+     * See Mock::nextCallIndex
+     */
+    CallSequence::Number nextCall(CallSequence::Number after, RecordFilter filter, const void* queryPtr) const;
+
+    /**
+     * See Mock::callsBetween
+     */
+    unsigned int callsBetween(CallSequence::Number after, CallSequence::Number before,
+                              RecordFilter filter, const void* queryPtr) const;
+
+    /**
+     * See Mock::waitForCalls
+     *
+     * @param lock The held lock of the history
+     */
+    bool waitForCalls(std::unique_lock<std::mutex>& lock, unsigned int count, RecordFilter filter,
+                      const void* queryPtr, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * See Mock::distinctCalls
+     */
+    unsigned int distinctCalls() const;
+
+    /**
+     * Returns the most frequent fingerprints among the calls, the most
+     * frequent first (see Mock::topCalls).
+     *
+     * @param maximumCount The maximum number of fingerprints to return
+     * @return The most frequent fingerprints, with their first call
+     */
+    std::vector<RecordFrequency> topRecords(unsigned int maximumCount) const;
+
+    /**
+     * Removes the calls.
+     */
+    void clearHistory();
+
+    /**
+     * See Mock::compressRepeatedCalls
+     */
+    void setCompression(bool enabled)
+    {
+        compressionEnabled = enabled;
+    }
+
+    /**
+     * Enables or disables the fingerprints, and computes those of the
+     * recorded calls.
+     *
+     * @param enabled Whether the fingerprints are recorded
+     * @param fingerprint The function computing the fingerprints
+     * @param fingerprinterPtr The argument of the function
+     */
+    void setFingerprints(bool enabled, RecordFingerprint fingerprint, const void* fingerprinterPtr);
+
+    /**
+     * Computes the fingerprints of the recorded calls again.
+     *
+     * @param fingerprint The function computing the fingerprints
+     * @param fingerprinterPtr The argument of the function
+     */
+    void computeFingerprints(RecordFingerprint fingerprint, const void* fingerprinterPtr);
+
+private:
+    typedef std::vector<CallRecord*>::const_iterator HistoryIterator;
+
+    /* The handlers read by the calls, built from the baseline and the list */
+    std::atomic<const HandlerVersion*> publishedVersionPtr;
+    /* The snapshot whose own version is published, if any */
+    std::shared_ptr<const HandlerSnapshot> publishedSnapshotPtr;
+    /* The handlers of the baseline are tried before the ones of the list */
+    std::shared_ptr<const HandlerSnapshot> baselinePtr;
+    /* The handlers waiting for their configuration are not published */
+    std::vector<BaseCallHandler*> callHandlerList;
+    /* Removed handlers, retired when the version which uses them is replaced */
+    std::vector<BaseCallHandler*> removedHandlerList;
+    /* Serializes the changes of the handlers */
+    std::mutex handlersMutex;
+    unsigned int updateDepth;
+    /* Sorted by sequence number, as the calls are appended in order */
+    std::vector<CallRecord*> callHistoryList;
+    /* Protects the history, so that calls can be recorded from any thread */
+    mutable std::mutex historyLock;
+    bool compressionEnabled;
+    /* Fingerprint of each entry of the history, when they are recorded */
+    bool fingerprintsEnabled;
+    std::vector<std::uint64_t> callFingerprints;
+    /* Created by the first call to waitForCalls */
+    std::unique_ptr<std::condition_variable> callRecordedPtr;
+    unsigned int waiterCount;
+
+    /**
+     * Removes the handlers which are not in the baseline. They are deleted
+     * once no call uses them. The lock of the handlers must be held.
+     */
+    void removeHandlers();
+
+    /**
+     * Publishes the handlers to the calls, unless an update is ongoing. The
+     * lock of the handlers must be held.
+     */
+    void publishHandlers();
+
+    /**
+     * Returns whether a handler waits for its configuration.
+     *
+     * @param handlerPtr The handler
+     * @return Whether the handler waits for its configuration
+     */
+    static bool pending(const BaseCallHandler* handlerPtr)
+    {
+        return handlerPtr->pendingCorePtr.load() != nullptr;
+    }
+
+    /**
+     * Returns the number of calls matched by a query, among a range of the
+     * history.
+     *
+     * @param filter The function matching the calls
+     * @param queryPtr The query
+     * @param fingerprintPtr The fingerprint of every matched call, or nullptr
+     * @param begin The index of the first call of the range
+     * @param end The index following the last call of the range
+     * @return The number of matched calls in the range
+     */
+    unsigned int countRange(RecordFilter filter, const void* queryPtr, const std::uint64_t* fingerprintPtr,
+                            std::size_t begin, std::size_t end) const;
+
+    /**
+     * Returns the first call of the history which happened after the provided
+     * sequence number.
+     *
+     * @param after A sequence number
+     * @return An iterator on the first call which happened after the sequence
+     *         number
+     */
+    HistoryIterator firstCallAfter(CallSequence::Number after) const;
+
+    MockCore(const MockCore&);
+    MockCore& operator=(const MockCore&);
+};
+
+#endif /* MOCKCORE_HPP_ */
@@ -0,0 +1,75 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file QueryPool.hpp
+ * @brief Declaration of the private class QueryPool
+ */
+
+#ifndef QUERYPOOL_HPP_
+#define QUERYPOOL_HPP_
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * Worker threads sharing the scans of the large histories between the cores
+ * (see BaseMock::setParallelQueryThreshold). A task is split into chunks,
+ * which the workers and the calling thread take in turn. Unless their number
+ * is set, the workers are started by the first parallel task, one per core
+ * but the calling one.
+ *
+ * The pool runs one task at a time: a task submitted while another one runs
+ * is run by its calling thread alone.
+ */
+class QueryPool
+{
+public:
+    /**
+     * Runs a task on each chunk, and returns once every chunk is done. The
+     * first exception thrown by the task is thrown again by the method.
+     *
+     * @param chunkCount The number of chunks
+     * @param task The function running a chunk, called from several threads
+     *             at once
+     */
+    static void run(std::size_t chunkCount, const std::function<void(std::size_t chunk)>& task);
+
+    /**
+     * Returns the number of threads sharing a task: the workers and the
+     * calling thread.
+     *
+     * @return The number of threads
+     */
+    static unsigned int threadCount();
+
+    /**
+     * Sets the number of threads sharing a task. The missing workers are
+     * started; the extra ones stay idle.
+     *
+     * @param providedThreadCount The number of threads, including the calling
+     *                            one (1 runs every task on its calling thread)
+     */
+    static void setThreadCount(unsigned int providedThreadCount);
+
+    /**
+     * Returns the number of calls from which a history is scanned by the
+     * pool.
+     *
+     * @return The minimum size of a parallel scan
+     */
+    static std::size_t threshold();
+
+    /**
+     * Sets the number of calls from which a history is scanned by the pool.
+     *
+     * @param providedThreshold The minimum size of a parallel scan
+     */
+    static void setThreshold(std::size_t providedThreshold);
+};
+
+#endif /* QUERYPOOL_HPP_ */
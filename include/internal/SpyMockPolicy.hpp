@@ -0,0 +1,160 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file SpyMockPolicy.hpp
+ * @brief Implementation of the @ref MockPolicy used by @ref Spy
+ */
+
+#ifndef SPYMOCKPOLICY_HPP_
+#define SPYMOCKPOLICY_HPP_
+
+#include "internal/AbstractCallHandler.hpp"
+#include "internal/DefaultMockPolicy.hpp"
+
+#include <dlfcn.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/**
+ * RealFunctionCallHandler matches any arguments and forwards the call to the
+ * real implementation of the mocked function.
+ *
+ * The real implementation is the next definition of the symbol in the lookup
+ * order of the dynamic linker (dlsym with RTLD_NEXT), that is to say the one
+ * hidden by the definition which calls the @ref Spy.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class RealFunctionCallHandler: public AbstractCallHandler<ReturnType, ArgumentTypes...>
+{
+public:
+    typedef ReturnType (*FunctionPtr)(ArgumentTypes...);
+
+    /**
+     * Constructor of RealFunctionCallHandler. The symbol is resolved once,
+     * here.
+     *
+     * @param symbolName The name of the real function
+     */
+    RealFunctionCallHandler(const char* symbolName)
+        : AbstractCallHandler<ReturnType, ArgumentTypes...>(),
+          name(symbolName),
+          realFunctionPtr(nullptr)
+    {
+        void* symbol = dlsym(RTLD_NEXT, symbolName);
+
+        /* ISO C++ does not allow to cast an object pointer to a function
+         * pointer, hence the copy. */
+        std::memcpy(&realFunctionPtr, &symbol, sizeof(symbol));
+    }
+
+    /**
+     * Destructor of RealFunctionCallHandler
+     */
+    virtual ~RealFunctionCallHandler()
+    {
+    }
+
+    /**
+     * Calls the real implementation of the function.
+     *
+     * @param args The instance of arguments
+     * @return The value returned by the real implementation
+     *
+     * @throws A @ref std::runtime_error if the real implementation could not
+     *         be found
+     */
+    ReturnType value(ArgumentTypes ... args)
+    {
+        if (realFunctionPtr == nullptr)
+            throw std::runtime_error("Unable to find the real implementation of " + name + ".");
+
+        return realFunctionPtr(args...);
+    }
+
+    /**
+     * Returns true.
+     *
+     * @param args The instance of arguments.
+     * @return true
+     */
+    bool matchArguments(ArgumentTypes ...)
+    {
+        return true;
+    }
+
+    /**
+     * Returns the pointer to the real implementation of the function, or
+     * nullptr if it could not be found.
+     *
+     * @return The pointer to the real implementation of the function
+     */
+    FunctionPtr function() const
+    {
+        return realFunctionPtr;
+    }
+
+private:
+    std::string name;
+    FunctionPtr realFunctionPtr;
+};
+
+/**
+ * SpyMockPolicy stores the calls as the @ref DefaultMockPolicy does, but it
+ * forwards the calls which are not matched by any call handler to the real
+ * implementation of the function.
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class SpyMockPolicy: public DefaultMockPolicy<ReturnType, ArgumentTypes...>
+{
+public:
+    /**
+     * Constructor of SpyMockPolicy
+     *
+     * @param symbolName The name of the real function
+     */
+    SpyMockPolicy(const char* symbolName)
+        : DefaultMockPolicy<ReturnType, ArgumentTypes...>(), realHandler(symbolName)
+    {
+    }
+
+    virtual ~SpyMockPolicy()
+    {
+    }
+
+    virtual AbstractCallHandler<ReturnType, ArgumentTypes...>* getHandler(ArgumentTypes ...)
+    {
+        return &realHandler;
+    }
+
+    /**
+     * Returns the handler forwarding the calls to the real implementation.
+     *
+     * @return The handler forwarding the calls to the real implementation
+     */
+    RealFunctionCallHandler<ReturnType, ArgumentTypes...>& realFunctionHandler()
+    {
+        return realHandler;
+    }
+
+    /**
+     * Returns the handler forwarding the calls to the real implementation.
+     *
+     * @return The handler forwarding the calls to the real implementation
+     */
+    const RealFunctionCallHandler<ReturnType, ArgumentTypes...>& realFunctionHandler() const
+    {
+        return realHandler;
+    }
+
+private:
+    RealFunctionCallHandler<ReturnType, ArgumentTypes...> realHandler;
+};
+
+#endif /* SPYMOCKPOLICY_HPP_ */
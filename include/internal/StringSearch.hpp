@@ -0,0 +1,73 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file StringSearch.hpp
+ * @brief Declaration of the private classes StringSearch and CompiledRegex
+ */
+
+#ifndef STRINGSEARCH_HPP_
+#define STRINGSEARCH_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * Search of a substring in a null-terminated string. On x86, the candidate
+ * positions are found 16 at a time with SSE2, by comparing the first and the
+ * last characters of the substring; the other characters are only compared
+ * at those positions.
+ */
+class StringSearch
+{
+public:
+    /**
+     * Returns whether a string contains a substring.
+     *
+     * @param text The null-terminated string
+     * @param pattern The substring
+     * @param patternLength The length of the substring
+     * @return Whether the string contains the substring
+     */
+    static bool contains(const char* text, const char* pattern, std::size_t patternLength);
+};
+
+/**
+ * POSIX extended regular expression, compiled once.
+ */
+class CompiledRegex
+{
+public:
+    /**
+     * Compiles a regular expression. It throws a std::runtime_error if the
+     * expression is not valid.
+     *
+     * @param pattern The extended regular expression
+     */
+    explicit CompiledRegex(const std::string& pattern);
+
+    ~CompiledRegex();
+
+    /**
+     * Returns whether the regular expression matches a part of a string.
+     *
+     * @param text The null-terminated string
+     * @return Whether the regular expression matches the string
+     */
+    bool search(const char* text) const;
+
+private:
+    struct Compiled;
+
+    std::unique_ptr<Compiled> compiledPtr;
+
+    CompiledRegex(const CompiledRegex&);
+    CompiledRegex& operator=(const CompiledRegex&);
+};
+
+#endif /* STRINGSEARCH_HPP_ */
@@ -0,0 +1,84 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file TableCallHandler.hpp
+ * @brief Declaration and definition of private class TableCallHandler
+ */
+
+#ifndef TABLECALLHANDLER_HPP_
+#define TABLECALLHANDLER_HPP_
+
+#include <memory>
+
+#include "ArgumentMatcher/ArgumentMatcher.hpp"
+#include "CallHandler.hpp"
+#include "LookupTable.hpp"
+
+/**
+ * Call handler which matches the calls whose arguments are in a
+ * @ref LookupTable, and returns the value of the table. The value found by
+ * matchArguments is kept for the value method, which follows it in the same
+ * thread, so that the table is searched once per call.
+ *
+ * @see Mock::whenInTable
+ */
+template<typename ReturnType, typename ... ArgumentTypes>
+class TableCallHandler : public CallHandler<ReturnType, ArgumentTypes...>
+{
+public:
+    /**
+     * Constructor of TableCallHandler
+     *
+     * @param providedTablePtr The lookup table
+     */
+    TableCallHandler(const std::shared_ptr<const LookupTable<ReturnType, ArgumentTypes...> >& providedTablePtr)
+        : CallHandler<ReturnType, ArgumentTypes...>(ArgumentMatcher::any<ArgumentTypes>()...),
+          tablePtr(providedTablePtr)
+    {
+    }
+
+    /**
+     * Returns whether the arguments are in the table.
+     *
+     * @param args The instance of arguments
+     * @return Whether the arguments are in the table
+     */
+    bool matchArguments(ArgumentTypes ... args)
+    {
+        return tablePtr->find(foundValue(), args...);
+    }
+
+    /**
+     * Returns the value of the arguments in the table.
+     *
+     * @return The value found by the last call to matchArguments
+     */
+    ReturnType value(ArgumentTypes ...)
+    {
+        return foundValue();
+    }
+
+private:
+    std::shared_ptr<const LookupTable<ReturnType, ArgumentTypes...> > tablePtr;
+
+    /**
+     * Returns the value found by the last search of the current thread in a
+     * table of this type. When several tables are tried, the last one searched
+     * is the one which handles the call.
+     *
+     * @return The value found by the last search of the current thread
+     */
+    static ReturnType& foundValue()
+    {
+        static thread_local ReturnType value = ReturnType();
+
+        return value;
+    }
+};
+
+#endif /* TABLECALLHANDLER_HPP_ */
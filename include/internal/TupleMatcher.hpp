@@ -0,0 +1,174 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file TupleMatcher.hpp
+ * @brief Declaration and definition of the private structure TupleMatcher
+ */
+
+#ifndef TUPLEMATCHER_HPP_
+#define TUPLEMATCHER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <tuple>
+
+#include "ArgumentMatcher/AbstractCallMatcher.hpp"
+
+/**
+ * Matches a tuple of values against a tuple of argument matchers, element
+ * after element, from the Index-th element to the last one. The loop is
+ * unrolled at compile time: there is no virtual call but the ones of the
+ * matchers themselves, and the matching stops at the first element which is
+ * not matched.
+ */
+template<std::size_t Index, std::size_t Size>
+struct TupleMatcher
+{
+    /**
+     * Returns whether each value is matched by the matcher at the same
+     * position.
+     *
+     * @param matchers A tuple of pointers to argument matchers
+     * @param values A tuple of values
+     * @return Whether each value is matched by the matcher at the same
+     *         position.
+     */
+    template<typename MatcherTuple, typename ValueTuple>
+    static bool match(const MatcherTuple& matchers, const ValueTuple& values)
+    {
+        return std::get<Index>(matchers)->match(std::get<Index>(values))
+            && TupleMatcher<Index + 1, Size>::match(matchers, values);
+    }
+
+    /**
+     * Returns whether each matcher is thread-safe (see
+     * BaseArgumentMatcher::threadSafe).
+     *
+     * @param matchers A tuple of pointers to argument matchers
+     * @return Whether each matcher is thread-safe
+     */
+    template<typename MatcherTuple>
+    static bool threadSafe(const MatcherTuple& matchers)
+    {
+        return std::get<Index>(matchers)->threadSafe() && TupleMatcher<Index + 1, Size>::threadSafe(matchers);
+    }
+};
+
+/**
+ * End of the loop: an empty range of values is always matched.
+ */
+template<std::size_t Size>
+struct TupleMatcher<Size, Size>
+{
+    template<typename MatcherTuple, typename ValueTuple>
+    static bool match(const MatcherTuple&, const ValueTuple&)
+    {
+        return true;
+    }
+
+    template<typename MatcherTuple>
+    static bool threadSafe(const MatcherTuple&)
+    {
+        return true;
+    }
+};
+
+/**
+ * Compile-time sequence of indexes (std::index_sequence is C++14).
+ */
+template<std::size_t ... Indexes>
+struct IndexSequence
+{
+};
+
+/**
+ * Builds the sequence of the indexes from 0 to Size - 1, as the type
+ * MakeIndexSequence<Size>::Type.
+ */
+template<std::size_t Size, std::size_t ... Indexes>
+struct MakeIndexSequence : MakeIndexSequence<Size - 1, Size - 1, Indexes...>
+{
+};
+
+template<std::size_t ... Indexes>
+struct MakeIndexSequence<0, Indexes...>
+{
+    typedef IndexSequence<Indexes...> Type;
+};
+
+/**
+ * Matches one element of a tuple of values, chosen at run time, against the
+ * matcher at the same position: the element is reached through a table of
+ * functions, one per position, so that the elements can be checked in any
+ * order.
+ */
+template<typename MatcherTuple, typename ValueTuple,
+         typename Indexes = typename MakeIndexSequence<std::tuple_size<ValueTuple>::value>::Type>
+struct TuplePositionMatcher;
+
+template<typename MatcherTuple, typename ValueTuple, std::size_t ... Indexes>
+struct TuplePositionMatcher<MatcherTuple, ValueTuple, IndexSequence<Indexes...> >
+{
+    /**
+     * Returns whether the value at a position is matched by the matcher at
+     * the same position.
+     *
+     * @param position The position, lower than the size of the tuples
+     * @param matchers A tuple of pointers to argument matchers
+     * @param values A tuple of values
+     * @return Whether the value is matched
+     */
+    static bool match(std::size_t position, const MatcherTuple& matchers, const ValueTuple& values)
+    {
+        typedef bool (*PositionMatch)(const MatcherTuple&, const ValueTuple&);
+        /* The last entry keeps the table from being empty */
+        static const PositionMatch positionMatches[] = { &matchAt<Indexes>..., nullptr };
+
+        return positionMatches[position](matchers, values);
+    }
+
+private:
+    template<std::size_t Index>
+    static bool matchAt(const MatcherTuple& matchers, const ValueTuple& values)
+    {
+        return std::get<Index>(matchers)->match(std::get<Index>(values));
+    }
+};
+
+/**
+ * Matches a tuple of values against an @ref AbstractCallMatcher, through an
+ * @ref ArgumentView of the values.
+ */
+template<typename ValueTuple,
+         typename Indexes = typename MakeIndexSequence<std::tuple_size<ValueTuple>::value>::Type>
+struct TupleCallMatcher;
+
+template<typename ValueTuple, std::size_t ... Indexes>
+struct TupleCallMatcher<ValueTuple, IndexSequence<Indexes...> >
+{
+    /**
+     * Returns whether the values are matched by the call matcher.
+     *
+     * @param callMatcher The call matcher
+     * @param values A tuple of values
+     * @return Whether the values are matched
+     */
+    static bool match(const AbstractCallMatcher& callMatcher, const ValueTuple& values)
+    {
+        /* The last entry keeps the array from being empty */
+        const void* const addresses[] = { static_cast<const void*>(std::addressof(std::get<Indexes>(values)))...,
+                                          nullptr };
+        const ArgumentView view(addresses,
+                                ArgumentTypeList<typename std::tuple_element<Indexes, ValueTuple>::type...>::types,
+                                sizeof...(Indexes));
+
+        return callMatcher.match(view);
+    }
+};
+
+#endif /* TUPLEMATCHER_HPP_ */
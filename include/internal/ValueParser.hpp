@@ -0,0 +1,91 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file ValueParser.hpp
+ * @brief Declaration and definition of the private class ValueParser
+ */
+
+#ifndef VALUEPARSER_HPP_
+#define VALUEPARSER_HPP_
+
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+/**
+ * Reading of a value of a type from a text, like a value sent by the
+ * @ref ControlPlane. ValueParser<Type>::SUPPORTED tells whether the type can
+ * be read: numbers and enumerations only.
+ */
+template<typename Type, typename Enable = void>
+struct ValueParser
+{
+    static const bool SUPPORTED = false;
+};
+
+/* Integers are read as the widest integer of their signedness, then checked
+ * against the range of their type */
+template<typename Type>
+struct ValueParser<Type, typename std::enable_if<std::is_integral<Type>::value>::type>
+{
+    static const bool SUPPORTED = true;
+
+    static bool parse(const std::string& text, Type& value)
+    {
+        typedef typename std::conditional<std::is_signed<Type>::value, long long, unsigned long long>::type WideType;
+        std::istringstream in(text);
+        WideType wideValue = 0;
+
+        if (!std::is_signed<Type>::value && text.find('-') != std::string::npos)
+            return false;
+
+        if (!(in >> wideValue) || !(in >> std::ws).eof())
+            return false;
+
+        if (wideValue > static_cast<WideType>(std::numeric_limits<Type>::max())
+            || (std::is_signed<Type>::value && wideValue < static_cast<WideType>(std::numeric_limits<Type>::min())))
+            return false;
+
+        value = static_cast<Type>(wideValue);
+        return true;
+    }
+};
+
+template<typename Type>
+struct ValueParser<Type, typename std::enable_if<std::is_floating_point<Type>::value>::type>
+{
+    static const bool SUPPORTED = true;
+
+    static bool parse(const std::string& text, Type& value)
+    {
+        std::istringstream in(text);
+
+        return (in >> value) && (in >> std::ws).eof();
+    }
+};
+
+/* Enumerations are read as their integer value */
+template<typename Type>
+struct ValueParser<Type, typename std::enable_if<std::is_enum<Type>::value>::type>
+{
+    static const bool SUPPORTED = true;
+
+    static bool parse(const std::string& text, Type& value)
+    {
+        typename std::underlying_type<Type>::type integerValue;
+
+        if (!ValueParser<typename std::underlying_type<Type>::type>::parse(text, integerValue))
+            return false;
+
+        value = static_cast<Type>(integerValue);
+        return true;
+    }
+};
+
+#endif /* VALUEPARSER_HPP_ */
@@ -0,0 +1,89 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file AdaptiveOrder.cpp
+ * @brief Implementation of AdaptiveOrder.hpp
+ */
+
+#include "internal/AdaptiveOrder.hpp"
+
+#include <algorithm>
+
+const unsigned int AdaptiveOrder::MAX_ADAPTIVE_SIZE;
+const unsigned int AdaptiveOrder::SAMPLE_PERIOD;
+const unsigned int AdaptiveOrder::REORDER_PERIOD;
+
+AdaptiveOrder::AdaptiveOrder(unsigned int providedSize, Stop providedStop)
+    : size(providedSize),
+      stop(providedStop),
+      packedOrder(0),
+      evaluationCount(0),
+      sampleCount(0),
+      reordering(false),
+      statisticsPtr()
+{
+    /* A single check has a single order: nothing to measure */
+    const unsigned int adaptiveSize = size >= 2 ? std::min(size, MAX_ADAPTIVE_SIZE) : 0;
+
+    if (adaptiveSize != 0)
+        statisticsPtr.reset(new Statistics[adaptiveSize]);
+
+    Order initialOrder = 0;
+
+    for (unsigned int index = 0; index < adaptiveSize; index++) {
+        statisticsPtr[index].evaluated.store(0);
+        statisticsPtr[index].stopped.store(0);
+        statisticsPtr[index].ticks.store(0);
+        initialOrder |= static_cast<Order>(index) << (4 * index);
+    }
+
+    packedOrder.store(initialOrder);
+}
+
+void AdaptiveOrder::reorder() const
+{
+    /* Another thread is already reordering */
+    if (reordering.exchange(true, std::memory_order_acquire))
+        return;
+
+    const unsigned int adaptiveSize = std::min(size, MAX_ADAPTIVE_SIZE);
+    double expectedCost[MAX_ADAPTIVE_SIZE];
+    unsigned int indexes[MAX_ADAPTIVE_SIZE];
+
+    for (unsigned int index = 0; index < adaptiveSize; index++) {
+        Statistics& statistics = statisticsPtr[index];
+        const std::uint64_t evaluated = statistics.evaluated.load(std::memory_order_relaxed);
+        const std::uint64_t stopped = statistics.stopped.load(std::memory_order_relaxed);
+        const std::uint64_t ticks = statistics.ticks.load(std::memory_order_relaxed);
+
+        /* A check never evaluated gets an even chance and no cost, so that it
+         * is tried early and measured */
+        const double cost = evaluated != 0 ? static_cast<double>(ticks) / static_cast<double>(evaluated) : 0.0;
+        const double stopProbability = (static_cast<double>(stopped) + 1.0) / (static_cast<double>(evaluated) + 2.0);
+
+        /* Cost paid per stopped evaluation: the lower, the earlier */
+        expectedCost[index] = (cost + 1.0) / stopProbability;
+        indexes[index] = index;
+
+        statistics.evaluated.store(evaluated / 2, std::memory_order_relaxed);
+        statistics.stopped.store(stopped / 2, std::memory_order_relaxed);
+        statistics.ticks.store(ticks / 2, std::memory_order_relaxed);
+    }
+
+    std::stable_sort(indexes, indexes + adaptiveSize, [&expectedCost] (unsigned int first, unsigned int second) {
+        return expectedCost[first] < expectedCost[second];
+    });
+
+    Order newOrder = 0;
+
+    for (unsigned int rank = 0; rank < adaptiveSize; rank++)
+        newOrder |= static_cast<Order>(indexes[rank]) << (4 * rank);
+
+    packedOrder.store(newOrder, std::memory_order_relaxed);
+    reordering.store(false, std::memory_order_release);
+}
@@ -12,7 +12,20 @@
 
 #include "ArgumentMatcher/ArgumentMatcher.hpp"
 
-std::list<BaseArgumentMatcher*> ArgumentMatcher::fixedValueMatcher = std::list<BaseArgumentMatcher*>();
+#include <list>
+
+/**
+ * Returns the list of the dynamically created matchers. It is created on first
+ * use, so that matchers can be created during static initialization.
+ *
+ * @return The list of the dynamically created matchers
+ */
+static std::list<BaseArgumentMatcher*>& createdMatchers()
+{
+    static std::list<BaseArgumentMatcher*> matchers;
+
+    return matchers;
+}
 
 TypeArgumentMatcher<int> ArgumentMatcher::anyIntMatcher = TypeArgumentMatcher<int>();
 TypeArgumentMatcher<char> ArgumentMatcher::anyCharMatcher = TypeArgumentMatcher<char>();
@@ -22,11 +35,55 @@ TypeArgumentMatcher<void*> ArgumentMatcher::anyVoidPointerMatcher = TypeArgument
 
 void ArgumentMatcher::clear()
 {
-    for (auto it = ArgumentMatcher::fixedValueMatcher.begin(); it != ArgumentMatcher::fixedValueMatcher.end(); ++it) {
+    std::list<BaseArgumentMatcher*>& matchers = createdMatchers();
+
+    for (auto it = matchers.begin(); it != matchers.end(); ++it) {
         delete *it;
     }
 
-    ArgumentMatcher::fixedValueMatcher.clear();
+    matchers.clear();
+}
+
+void ArgumentMatcher::registerMatcher(BaseArgumentMatcher* matcher)
+{
+    createdMatchers().push_back(matcher);
+}
+
+BytesCallMatcher* ArgumentMatcher::bytesEq(std::size_t pointerPosition, std::size_t lengthPosition,
+                                          const std::string& expected)
+{
+    BytesCallMatcher* matcher = new BytesCallMatcher(pointerPosition, lengthPosition, BytesCallMatcher::EQUAL,
+                                                     expected);
+
+    registerMatcher(matcher);
+
+    return matcher;
+}
+
+BytesCallMatcher* ArgumentMatcher::bytesPrefix(std::size_t pointerPosition, std::size_t lengthPosition,
+                                              const std::string& prefix)
+{
+    BytesCallMatcher* matcher = new BytesCallMatcher(pointerPosition, lengthPosition, BytesCallMatcher::PREFIX,
+                                                     prefix);
+
+    registerMatcher(matcher);
+
+    return matcher;
+}
+
+BytesCallMatcher* ArgumentMatcher::bytesHash(std::size_t pointerPosition, std::size_t lengthPosition,
+                                            std::uint64_t hash)
+{
+    BytesCallMatcher* matcher = new BytesCallMatcher(pointerPosition, lengthPosition, hash);
+
+    registerMatcher(matcher);
+
+    return matcher;
+}
+
+std::uint64_t ArgumentMatcher::hashBytes(const void* dataPtr, std::size_t length)
+{
+    return BytesCallMatcher::hash(dataPtr, length);
 }
 
 TypeArgumentMatcher<int>* ArgumentMatcher::anyInt()
@@ -0,0 +1,147 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file BytesCallMatcher.cpp
+ * @brief Implementation of BytesCallMatcher.hpp
+ */
+
+#include "ArgumentMatcher/BytesCallMatcher.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+static const std::uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const std::uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static const std::uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+
+/**
+ * Reads 8 bytes of a buffer, whatever their alignment.
+ *
+ * @param dataPtr The bytes
+ * @return The bytes, in the byte order of the machine
+ */
+static std::uint64_t read64(const unsigned char* dataPtr)
+{
+    std::uint64_t value;
+
+    std::memcpy(&value, dataPtr, sizeof(value));
+    return value;
+}
+
+/**
+ * Mixes 8 bytes into a lane of the hash.
+ *
+ * @param lane The lane
+ * @param value The bytes
+ * @return The new lane
+ */
+static std::uint64_t mix(std::uint64_t lane, std::uint64_t value)
+{
+    lane += value * PRIME_2;
+    lane = (lane << 31) | (lane >> 33);
+    return lane * PRIME_1;
+}
+
+BytesCallMatcher::BytesCallMatcher(std::size_t providedPointerPosition, std::size_t providedLengthPosition,
+                                   Comparison providedComparison, const std::string& providedBytes)
+    : AbstractCallMatcher(),
+      pointerPosition(providedPointerPosition),
+      lengthPosition(providedLengthPosition),
+      comparison(providedComparison),
+      bytes(providedBytes),
+      expectedHash(0)
+{
+}
+
+BytesCallMatcher::BytesCallMatcher(std::size_t providedPointerPosition, std::size_t providedLengthPosition,
+                                   std::uint64_t providedHash)
+    : AbstractCallMatcher(),
+      pointerPosition(providedPointerPosition),
+      lengthPosition(providedLengthPosition),
+      comparison(HASH),
+      bytes(),
+      expectedHash(providedHash)
+{
+}
+
+void BytesCallMatcher::checkTypes(const ArgumentType* types, std::size_t count) const
+{
+    if (pointerPosition >= count || types[pointerPosition].kind != ArgumentType::POINTER)
+        throw std::runtime_error("The buffer of a bytes matcher is not a pointer argument");
+
+    if (lengthPosition >= count || !types[lengthPosition].isInteger())
+        throw std::runtime_error("The length of a bytes matcher is not an integral argument");
+}
+
+bool BytesCallMatcher::match(const ArgumentView& arguments) const
+{
+    const void* dataPtr = arguments.pointer(pointerPosition);
+    const std::size_t length = arguments.length(lengthPosition);
+
+    if (dataPtr == nullptr && length != 0)
+        return false;
+
+    switch (comparison) {
+    case EQUAL:
+        return length == bytes.size() && (length == 0 || std::memcmp(dataPtr, bytes.data(), length) == 0);
+    case PREFIX:
+        return length >= bytes.size() && (bytes.empty() || std::memcmp(dataPtr, bytes.data(), bytes.size()) == 0);
+    default:
+        return hash(dataPtr, length) == expectedHash;
+    }
+}
+
+const std::string* BytesCallMatcher::fixedBytes(std::size_t providedPointerPosition,
+                                                std::size_t providedLengthPosition) const
+{
+    if (comparison != EQUAL || providedPointerPosition != pointerPosition || providedLengthPosition != lengthPosition)
+        return nullptr;
+
+    return &bytes;
+}
+
+bool BytesCallMatcher::threadSafe() const
+{
+    return true;
+}
+
+std::uint64_t BytesCallMatcher::hash(const void* dataPtr, std::size_t length)
+{
+    const unsigned char* bytePtr = static_cast<const unsigned char*>(dataPtr);
+    const unsigned char* endPtr = bytePtr + length;
+    /* Four independent lanes, so that the multiplications overlap */
+    std::uint64_t lanes[4] = { PRIME_1 + PRIME_2, PRIME_2, 0, PRIME_3 };
+
+    for (; endPtr - bytePtr >= 32; bytePtr += 32) {
+        lanes[0] = mix(lanes[0], read64(bytePtr));
+        lanes[1] = mix(lanes[1], read64(bytePtr + 8));
+        lanes[2] = mix(lanes[2], read64(bytePtr + 16));
+        lanes[3] = mix(lanes[3], read64(bytePtr + 24));
+    }
+
+    std::uint64_t result = ((lanes[0] << 1) | (lanes[0] >> 63)) ^ ((lanes[1] << 7) | (lanes[1] >> 57))
+        ^ ((lanes[2] << 12) | (lanes[2] >> 52)) ^ ((lanes[3] << 18) | (lanes[3] >> 46));
+
+    result = mix(result, static_cast<std::uint64_t>(length));
+
+    for (; endPtr - bytePtr >= 8; bytePtr += 8)
+        result = mix(result, read64(bytePtr));
+
+    if (bytePtr != endPtr) {
+        std::uint64_t tail = 0;
+
+        std::memcpy(&tail, bytePtr, static_cast<std::size_t>(endPtr - bytePtr));
+        result = mix(result ^ PRIME_3, tail);
+    }
+
+    result ^= result >> 33;
+    result *= PRIME_2;
+    result ^= result >> 29;
+    result *= PRIME_3;
+    return result ^ (result >> 32);
+}
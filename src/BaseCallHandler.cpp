@@ -0,0 +1,22 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file BaseCallHandler.cpp
+ * @brief Implementation of BaseCallHandler.hpp
+ */
+
+#include "internal/BaseCallHandler.hpp"
+#include "internal/MockCore.hpp"
+
+void BaseCallHandler::configured()
+{
+    MockCore* corePtr = pendingCorePtr.exchange(nullptr);
+
+    if (corePtr != nullptr)
+        corePtr->publishConfiguredHandlers();
+}
@@ -0,0 +1,143 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file BaseMock.cpp
+ * @brief Implementation of BaseMock.hpp
+ */
+
+#include "BaseMock.hpp"
+#include "MockRegistry.hpp"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+BaseMock::~BaseMock()
+{
+    unregister();
+
+    delete baseStatePtr.load();
+}
+
+void BaseMock::setName(const std::string& providedName)
+{
+    baseState().mockName = providedName;
+
+    if (providedName.empty())
+        MockRegistry::remove(this);
+    else
+        MockRegistry::add(this);
+}
+
+void BaseMock::unregister()
+{
+    BaseState* statePtr = baseStatePtr.load(std::memory_order_acquire);
+
+    if (statePtr != nullptr && !statePtr->mockName.empty())
+        setName(std::string());
+}
+
+bool BaseMock::switchBehavior(const std::string& behaviorName)
+{
+    std::function<void()> apply;
+
+    {
+        BaseState& state = baseState();
+        std::lock_guard<std::mutex> lock(state.behaviorsMutex);
+        const std::map<std::string, std::function<void()> >::const_iterator it = state.behaviorMap.find(behaviorName);
+
+        if (it == state.behaviorMap.end())
+            return false;
+
+        apply = it->second;
+    }
+
+    apply();
+
+    return true;
+}
+
+std::vector<std::string> BaseMock::behaviors() const
+{
+    BaseState& state = baseState();
+    std::lock_guard<std::mutex> lock(state.behaviorsMutex);
+    std::vector<std::string> names;
+
+    for (const std::map<std::string, std::function<void()> >::value_type& behavior : state.behaviorMap)
+        names.push_back(behavior.first);
+
+    return names;
+}
+
+bool BaseMock::setReturnValue(const std::string&)
+{
+    return false;
+}
+
+void BaseMock::defineBehavior(const std::string& behaviorName, const std::function<void()>& apply)
+{
+    BaseState& state = baseState();
+    std::lock_guard<std::mutex> lock(state.behaviorsMutex);
+
+    state.behaviorMap[behaviorName] = apply;
+}
+
+BaseMock::BaseState& BaseMock::createBaseState() const
+{
+    BaseState* newStatePtr = new BaseState();
+    BaseState* statePtr = nullptr;
+
+    if (!baseStatePtr.compare_exchange_strong(statePtr, newStatePtr)) {
+        delete newStatePtr;
+        return *statePtr;
+    }
+
+    return *newStatePtr;
+}
+
+const std::string& BaseMock::noName()
+{
+    static const std::string* emptyNamePtr = new std::string();
+
+    return *emptyNamePtr;
+}
+
+std::vector<BaseMock::CallSite> BaseMock::callSites() const
+{
+    std::vector<CallSite> sites;
+
+    for (const CallSiteTable::CountMap::value_type& siteCount : baseState().callSiteTable.countsPerSite()) {
+        CallSite site = { siteCount.first, siteCount.second, std::string(), 0, std::string() };
+        Dl_info info;
+
+        if (siteCount.first != nullptr && dladdr(siteCount.first, &info) != 0) {
+            if (info.dli_fname != nullptr)
+                site.object = info.dli_fname;
+
+            if (info.dli_sname != nullptr) {
+                int status = 0;
+                char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+
+                site.function = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+                site.offset = static_cast<unsigned long>(static_cast<const char*>(siteCount.first)
+                                                         - static_cast<const char*>(info.dli_saddr));
+                std::free(demangled);
+            }
+        }
+
+        sites.push_back(site);
+    }
+
+    std::sort(sites.begin(), sites.end(), [] (const CallSite& first, const CallSite& second) {
+        return first.count > second.count;
+    });
+
+    return sites;
+}
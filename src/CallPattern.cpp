@@ -0,0 +1,519 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallPattern.cpp
+ * @brief Implementation of CallPattern.hpp
+ */
+
+#include "CallPattern.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+/**
+ * Instruction of the automaton compiled from a pattern
+ */
+struct PatternInstruction
+{
+    enum Operation
+    {
+        MATCH, /* Consumes a call matched by the step, then goes to the next instruction */
+        SPLIT, /* Goes to both targets */
+        JUMP, /* Goes to the first target */
+        ACCEPT
+    };
+
+    Operation operation;
+    const void* stepPtr;
+    std::size_t firstTarget;
+    std::size_t secondTarget;
+};
+
+/**
+ * Call read by the automaton: a repetition of a compressed entry of the
+ * history is a call of its own
+ */
+struct PatternEvent
+{
+    std::size_t ordinal; /* Position in the merged histories */
+    CallSequence::Number sequenceNumber;
+    const MockCore* corePtr;
+    const CallRecord* recordPtr;
+};
+
+/**
+ * Automaton running a compiled pattern over the merged histories, in the
+ * manner of a Pike virtual machine: every attempt, one per starting call, is
+ * run at once, the attempts reaching the same instruction being merged into
+ * the one which started first.
+ */
+class PatternMachine
+{
+public:
+    /**
+     * Function telling whether a step of the pattern matches a call
+     */
+    typedef bool (*StepFilter)(const void* stepPtr, const PatternEvent& event);
+
+    /**
+     * Constructor of PatternMachine
+     *
+     * @param providedProgram The compiled pattern
+     * @param providedFilter The function matching the steps
+     */
+    PatternMachine(const std::vector<PatternInstruction>& providedProgram, StepFilter providedFilter)
+        : program(providedProgram), filter(providedFilter), visitedStamps(providedProgram.size(), 0), stamp(1),
+          threads(), nextThreads(), window(), hasCandidate(false), candidate(), results()
+    {
+    }
+
+    /**
+     * Reads the next call.
+     *
+     * @param event The call
+     */
+    void feed(const PatternEvent& event)
+    {
+        window.push_back(event);
+
+        if (step(event))
+            replay();
+
+        /* The calls preceding every ongoing attempt are no longer needed */
+        const std::size_t firstNeeded = threads.empty() ? event.ordinal + 1 : threads.front().startOrdinal;
+
+        while (!window.empty() && window.front().ordinal < firstNeeded)
+            window.pop_front();
+    }
+
+    /**
+     * Reads the end of the calls, and returns the matches.
+     *
+     * @return The matches
+     */
+    std::vector<CallPattern::Match>& finish()
+    {
+        /* The ongoing attempts cannot succeed anymore */
+        while (hasCandidate) {
+            emit();
+            replay();
+        }
+
+        return results;
+    }
+
+private:
+    /**
+     * Attempt to match the pattern
+     */
+    struct Thread
+    {
+        std::size_t pc;
+        std::size_t startOrdinal;
+        CallSequence::Number firstCall;
+    };
+
+    /**
+     * Best match found by the ongoing attempts
+     */
+    struct Candidate
+    {
+        std::size_t startOrdinal;
+        std::size_t endOrdinal;
+        CallSequence::Number firstCall;
+        CallSequence::Number lastCall;
+    };
+
+    const std::vector<PatternInstruction>& program;
+    StepFilter filter;
+    /* Stamp of the list of threads where each instruction was last added */
+    std::vector<unsigned long long> visitedStamps;
+    unsigned long long stamp;
+    /* Sorted by starting call, as the attempts are started in order */
+    std::vector<Thread> threads;
+    std::vector<Thread> nextThreads;
+    /* Calls read since the start of the earliest ongoing attempt */
+    std::deque<PatternEvent> window;
+    bool hasCandidate;
+    Candidate candidate;
+    std::vector<CallPattern::Match> results;
+
+    /**
+     * Adds a thread to a list, following the instructions which do not read
+     * a call.
+     *
+     * @param list The list
+     * @param pc The instruction reached by the thread
+     * @param thread The thread
+     * @param lastEventPtr The call read by the thread, or nullptr for a new
+     *                     attempt
+     */
+    void addThread(std::vector<Thread>& list, std::size_t pc, const Thread& thread, const PatternEvent* lastEventPtr)
+    {
+        /* An earlier attempt already reached the instruction: it leads to
+         * the same matches, which start earlier */
+        if (visitedStamps[pc] == stamp)
+            return;
+
+        visitedStamps[pc] = stamp;
+
+        const PatternInstruction& instruction = program[pc];
+
+        switch (instruction.operation) {
+        case PatternInstruction::MATCH:
+            list.push_back(thread);
+            list.back().pc = pc;
+            break;
+        case PatternInstruction::SPLIT:
+            addThread(list, instruction.firstTarget, thread, lastEventPtr);
+            addThread(list, instruction.secondTarget, thread, lastEventPtr);
+            break;
+        case PatternInstruction::JUMP:
+            addThread(list, instruction.firstTarget, thread, lastEventPtr);
+            break;
+        case PatternInstruction::ACCEPT:
+            /* No empty match */
+            if (lastEventPtr != nullptr)
+                offer(thread, *lastEventPtr);
+            break;
+        }
+    }
+
+    /**
+     * Keeps a match if it is the leftmost and longest found so far.
+     *
+     * @param thread The thread which matched
+     * @param lastEvent The last call of the match
+     */
+    void offer(const Thread& thread, const PatternEvent& lastEvent)
+    {
+        if (hasCandidate && (thread.startOrdinal > candidate.startOrdinal
+                             || (thread.startOrdinal == candidate.startOrdinal
+                                 && lastEvent.ordinal <= candidate.endOrdinal)))
+            return;
+
+        const Candidate newCandidate = { thread.startOrdinal, lastEvent.ordinal, thread.firstCall,
+                                         lastEvent.sequenceNumber };
+
+        candidate = newCandidate;
+        hasCandidate = true;
+    }
+
+    /**
+     * Runs the threads on a call.
+     *
+     * @param event The call
+     * @return Whether a match has been emitted
+     */
+    bool step(PatternEvent event)
+    {
+        /* A new attempt starts at each call, unless an earlier match has been
+         * found */
+        if (!hasCandidate) {
+            const Thread thread = { 0, event.ordinal, event.sequenceNumber };
+
+            addThread(threads, 0, thread, nullptr);
+        }
+
+        nextThreads.clear();
+        stamp++;
+
+        for (const Thread& thread : threads) {
+            if (hasCandidate && thread.startOrdinal > candidate.startOrdinal)
+                continue;
+
+            if (filter(program[thread.pc].stepPtr, event))
+                addThread(nextThreads, thread.pc + 1, thread, &event);
+        }
+
+        threads.swap(nextThreads);
+
+        /* The attempts starting after the match can no longer replace it */
+        if (hasCandidate) {
+            threads.erase(std::remove_if(threads.begin(), threads.end(), [this] (const Thread& thread) {
+                return thread.startOrdinal > candidate.startOrdinal;
+            }), threads.end());
+
+            if (threads.empty()) {
+                emit();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Reports the match, and restarts the automaton after it.
+     */
+    void emit()
+    {
+        const CallPattern::Match match = {
+            candidate.firstCall, candidate.lastCall,
+            static_cast<unsigned int>(candidate.endOrdinal - candidate.startOrdinal + 1)
+        };
+
+        results.push_back(match);
+
+        while (!window.empty() && window.front().ordinal <= candidate.endOrdinal)
+            window.pop_front();
+
+        hasCandidate = false;
+        threads.clear();
+        stamp++;
+    }
+
+    /**
+     * Reads again the calls which follow the last match, as the attempts
+     * which started among them may have been merged into the ones which
+     * started before. The window reaches back to the end of the match, so
+     * that a long match may be followed by as many calls to read again.
+     */
+    void replay()
+    {
+        std::size_t i = 0;
+
+        while (i < window.size()) {
+            if (step(window[i]))
+                i = 0; /* The window now starts after the new match */
+            else
+                i++;
+        }
+    }
+
+    PatternMachine(const PatternMachine&);
+    PatternMachine& operator=(const PatternMachine&);
+};
+
+/**
+ * Compiles a syntax tree into instructions.
+ *
+ * @param node The syntax tree
+ * @param program The instructions, to which those of the tree are appended
+ */
+template<typename Node>
+static void compile(const Node& node, std::vector<PatternInstruction>& program)
+{
+    const std::size_t start = program.size();
+    const PatternInstruction split = { PatternInstruction::SPLIT, nullptr, 0, 0 };
+    const PatternInstruction jump = { PatternInstruction::JUMP, nullptr, 0, 0 };
+
+    switch (node.kind) {
+    case Node::STEP: {
+        const PatternInstruction match = { PatternInstruction::MATCH, &node.step, 0, 0 };
+
+        program.push_back(match);
+        break;
+    }
+    case Node::SEQUENCE:
+        compile(*node.firstPtr, program);
+        compile(*node.secondPtr, program);
+        break;
+    case Node::ALTERNATIVE: {
+        program.push_back(split);
+        compile(*node.firstPtr, program);
+
+        const std::size_t jumpIndex = program.size();
+
+        program.push_back(jump);
+        compile(*node.secondPtr, program);
+
+        program[start].firstTarget = start + 1;
+        program[start].secondTarget = jumpIndex + 1;
+        program[jumpIndex].firstTarget = program.size();
+        break;
+    }
+    case Node::ONE_OR_MORE:
+        compile(*node.firstPtr, program);
+        program.push_back(split);
+        program.back().firstTarget = start;
+        program.back().secondTarget = program.size();
+        break;
+    case Node::ZERO_OR_MORE:
+        program.push_back(split);
+        compile(*node.firstPtr, program);
+        program.push_back(jump);
+        program.back().firstTarget = start;
+        program[start].firstTarget = start + 1;
+        program[start].secondTarget = program.size();
+        break;
+    case Node::OPTIONAL:
+        program.push_back(split);
+        compile(*node.firstPtr, program);
+        program[start].firstTarget = start + 1;
+        program[start].secondTarget = program.size();
+        break;
+    }
+}
+
+/**
+ * Collects the mocks named by a syntax tree.
+ *
+ * @param node The syntax tree
+ * @param cores The cores of the mocks, to which those of the tree are added
+ */
+template<typename Node>
+static void collectCores(const Node& node, std::vector<const MockCore*>& cores)
+{
+    if (node.kind == Node::STEP) {
+        if (node.step.corePtr != nullptr)
+            cores.push_back(node.step.corePtr);
+
+        return;
+    }
+
+    collectCores(*node.firstPtr, cores);
+
+    if (node.secondPtr)
+        collectCores(*node.secondPtr, cores);
+}
+
+/**
+ * Position in the history of a mock, while the histories are merged
+ */
+struct HistoryCursor
+{
+    const MockCore* corePtr;
+    std::size_t index;
+    CallSequence::Number sequenceNumber; /* Of the current repetition of the entry */
+};
+
+CallPattern::CallPattern(const MockCore& core, MockCore::RecordFilter filter,
+                         const std::shared_ptr<const void>& queryPtr)
+    : rootPtr()
+{
+    std::shared_ptr<Node> nodePtr = std::make_shared<Node>();
+
+    nodePtr->kind = Node::STEP;
+    nodePtr->step.corePtr = &core;
+    nodePtr->step.filter = filter;
+    nodePtr->step.queryPtr = queryPtr;
+    rootPtr = nodePtr;
+}
+
+CallPattern::CallPattern(const std::shared_ptr<const Node>& providedRootPtr)
+    : rootPtr(providedRootPtr)
+{
+}
+
+CallPattern CallPattern::anyCall()
+{
+    std::shared_ptr<Node> nodePtr = std::make_shared<Node>();
+
+    nodePtr->kind = Node::STEP;
+    nodePtr->step.corePtr = nullptr;
+    nodePtr->step.filter = nullptr;
+
+    return CallPattern(nodePtr);
+}
+
+CallPattern CallPattern::then(const CallPattern& next) const
+{
+    return combine(Node::SEQUENCE, next.rootPtr);
+}
+
+CallPattern CallPattern::or_(const CallPattern& other) const
+{
+    return combine(Node::ALTERNATIVE, other.rootPtr);
+}
+
+CallPattern CallPattern::oneOrMore() const
+{
+    return combine(Node::ONE_OR_MORE, nullptr);
+}
+
+CallPattern CallPattern::zeroOrMore() const
+{
+    return combine(Node::ZERO_OR_MORE, nullptr);
+}
+
+CallPattern CallPattern::optional() const
+{
+    return combine(Node::OPTIONAL, nullptr);
+}
+
+CallPattern CallPattern::combine(Node::Kind kind, const std::shared_ptr<const Node>& otherPtr) const
+{
+    std::shared_ptr<Node> nodePtr = std::make_shared<Node>();
+
+    nodePtr->kind = kind;
+    nodePtr->step.corePtr = nullptr;
+    nodePtr->step.filter = nullptr;
+    nodePtr->firstPtr = rootPtr;
+    nodePtr->secondPtr = otherPtr;
+
+    return CallPattern(nodePtr);
+}
+
+std::vector<CallPattern::Match> CallPattern::matches() const
+{
+    std::vector<PatternInstruction> program;
+    std::vector<const MockCore*> cores;
+
+    compile(*rootPtr, program);
+
+    const PatternInstruction accept = { PatternInstruction::ACCEPT, nullptr, 0, 0 };
+
+    program.push_back(accept);
+
+    collectCores(*rootPtr, cores);
+    std::sort(cores.begin(), cores.end());
+    cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+
+    if (cores.empty())
+        throw std::runtime_error("The call pattern does not name any mock");
+
+    /* Locked in the order of their addresses, so that two patterns naming
+     * the same mocks cannot deadlock */
+    std::vector<std::unique_lock<std::mutex>> locks;
+    std::vector<HistoryCursor> cursors;
+
+    for (const MockCore* corePtr : cores) {
+        locks.push_back(std::unique_lock<std::mutex>(corePtr->historyMutex()));
+
+        if (!corePtr->records().empty()) {
+            const HistoryCursor cursor = { corePtr, 0, corePtr->records().front()->sequenceNumber() };
+
+            cursors.push_back(cursor);
+        }
+    }
+
+    PatternMachine machine(program, [] (const void* stepPtr, const PatternEvent& event) {
+        const Step& patternStep = *static_cast<const Step*>(stepPtr);
+
+        if (patternStep.corePtr == nullptr)
+            return true;
+
+        return patternStep.corePtr == event.corePtr
+               && patternStep.filter(patternStep.queryPtr.get(), *event.recordPtr);
+    });
+
+    /* The histories, each sorted by sequence number, are merged in a single
+     * pass */
+    for (std::size_t ordinal = 0; !cursors.empty(); ordinal++) {
+        std::vector<HistoryCursor>::iterator cursorIt = std::min_element(cursors.begin(), cursors.end(),
+            [] (const HistoryCursor& first, const HistoryCursor& second) {
+                return first.sequenceNumber < second.sequenceNumber;
+            });
+        const std::vector<CallRecord*>& records = cursorIt->corePtr->records();
+        const CallRecord* recordPtr = records[cursorIt->index];
+        const PatternEvent event = { ordinal, cursorIt->sequenceNumber, cursorIt->corePtr, recordPtr };
+
+        machine.feed(event);
+
+        if (cursorIt->sequenceNumber < recordPtr->lastSequenceNumber())
+            cursorIt->sequenceNumber = recordPtr->sequenceNumberAfter(cursorIt->sequenceNumber);
+        else if (++cursorIt->index < records.size())
+            cursorIt->sequenceNumber = records[cursorIt->index]->sequenceNumber();
+        else
+            cursors.erase(cursorIt);
+    }
+
+    return machine.finish();
+}
@@ -0,0 +1,129 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallRecord.cpp
+ * @brief Implementation of CallRecord.hpp
+ */
+
+#include "internal/CallRecord.hpp"
+
+#include <algorithm>
+
+const unsigned int CallRecord::CHECKPOINT_INTERVAL;
+
+CallSequence::Number CallRecord::sequenceNumberAfter(CallSequence::Number after) const
+{
+    if (after < sequence)
+        return sequence;
+
+    if (after < lastEvenSequenceNumber())
+        return sequence + stride * ((after - sequence) / stride + 1);
+
+    CallSequence::Number number = CallSequence::NONE;
+
+    unevenCallAfter(after, number);
+    return number;
+}
+
+void CallRecord::repeat(CallSequence::Number number)
+{
+    if (!unevenCallsPtr) {
+        if (repeats == 1)
+            stride = number - sequence;
+
+        if (number == sequence + stride * repeats) {
+            repeats++;
+            return;
+        }
+
+        unevenCallsPtr.reset(new UnevenCalls());
+        unevenCallsPtr->last = lastEvenSequenceNumber();
+        unevenCallsPtr->count = 0;
+    }
+
+    UnevenCalls& unevenCalls = *unevenCallsPtr;
+    CallSequence::Number delta = number - unevenCalls.last;
+
+    /* Varint: 7 bits per byte, the high bit telling that a byte follows */
+    do {
+        const unsigned char bits = static_cast<unsigned char>(delta & 0x7f);
+
+        delta >>= 7;
+        unevenCalls.deltas.push_back(delta != 0 ? (bits | 0x80) : bits);
+    } while (delta != 0);
+
+    if (unevenCalls.count % CHECKPOINT_INTERVAL == 0) {
+        const UnevenCalls::Checkpoint checkpoint = { number, unevenCalls.deltas.size() };
+
+        unevenCalls.checkpoints.push_back(checkpoint);
+    }
+
+    unevenCalls.last = number;
+    unevenCalls.count++;
+    repeats++;
+}
+
+unsigned int CallRecord::callsUntil(CallSequence::Number until) const
+{
+    if (until < sequence)
+        return 0;
+
+    if (until < lastEvenSequenceNumber())
+        return static_cast<unsigned int>((until - sequence) / stride + 1);
+
+    if (!unevenCallsPtr)
+        return repeats;
+
+    CallSequence::Number number;
+
+    return evenRepeats() + unevenCallAfter(until, number);
+}
+
+unsigned int CallRecord::unevenCallAfter(CallSequence::Number after, CallSequence::Number& number) const
+{
+    const UnevenCalls& unevenCalls = *unevenCallsPtr;
+    std::vector<UnevenCalls::Checkpoint>::const_iterator checkpointIt = std::upper_bound(
+        unevenCalls.checkpoints.begin(), unevenCalls.checkpoints.end(), after,
+        [] (CallSequence::Number value, const UnevenCalls::Checkpoint& checkpoint) {
+            return value < checkpoint.number;
+        });
+
+    if (checkpointIt == unevenCalls.checkpoints.begin()) {
+        number = checkpointIt->number;
+        return 0;
+    }
+
+    --checkpointIt;
+
+    /* The calls are decoded from the last checkpoint not after the number */
+    unsigned int index = static_cast<unsigned int>(checkpointIt - unevenCalls.checkpoints.begin())
+                         * CHECKPOINT_INTERVAL;
+    CallSequence::Number current = checkpointIt->number;
+    std::size_t offset = checkpointIt->offset;
+
+    while (++index < unevenCalls.count) {
+        CallSequence::Number delta = 0;
+        unsigned int shift = 0;
+        unsigned char byte;
+
+        do {
+            byte = unevenCalls.deltas[offset++];
+            delta |= static_cast<CallSequence::Number>(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        current += delta;
+
+        if (current > after) {
+            number = current;
+            return index;
+        }
+    }
+
+    return unevenCalls.count;
+}
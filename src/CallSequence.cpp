@@ -0,0 +1,25 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallSequence.cpp
+ * @brief Implementation of CallSequence.hpp
+ */
+
+#include "CallSequence.hpp"
+
+#include <atomic>
+
+const CallSequence::Number CallSequence::NONE;
+
+/* The last sequence number given to a call */
+static std::atomic<CallSequence::Number> lastNumber(0);
+
+CallSequence::Number CallSequence::next()
+{
+    return lastNumber.fetch_add(1, std::memory_order_relaxed) + 1;
+}
@@ -0,0 +1,96 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CallTimer.cpp
+ * @brief Implementation of CallTimer.hpp
+ */
+
+#include "internal/CallTimer.hpp"
+
+#if MOCKEUR_HAS_TSC
+#include <cpuid.h>
+#endif
+
+std::atomic<bool> CallTimer::tscUsed(false);
+
+/* Time of the start, in ticks and in nanoseconds of the steady clock */
+static long long tickOrigin = 0;
+static long long nanosecondOrigin = 0;
+
+/**
+ * Returns the current time of the steady clock, in nanoseconds.
+ *
+ * @return The current time of the steady clock, in nanoseconds
+ */
+static long long steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Returns whether the time-stamp counter of the processor runs at a constant
+ * rate, whatever the power state of the processor.
+ *
+ * @return Whether the time-stamp counter is invariant
+ */
+static bool invariantTsc()
+{
+#if MOCKEUR_HAS_TSC
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return (edx & (1u << 8)) != 0;
+#endif
+
+    return false;
+}
+
+/**
+ * Chooses the source of the ticks and records the time of the start.
+ *
+ * @return true
+ */
+static bool initialize()
+{
+    const bool useTsc = invariantTsc();
+
+    nanosecondOrigin = steadyNanoseconds();
+    tickOrigin = nanosecondOrigin;
+
+#if MOCKEUR_HAS_TSC
+    if (useTsc)
+        tickOrigin = static_cast<long long>(__rdtsc());
+#endif
+
+    return useTsc;
+}
+
+void CallTimer::start()
+{
+    /* The initialization of a local static variable is done once, even if
+     * several threads start the timer at the same time. */
+    static const bool useTsc = initialize();
+
+    tscUsed.store(useTsc, std::memory_order_relaxed);
+}
+
+CallTimer::Scale CallTimer::scale()
+{
+    if (!tscUsed.load(std::memory_order_relaxed))
+        return Scale(0, 0, 1.0);
+
+    const long long nanosecondNow = steadyNanoseconds();
+    const long long tickNow = now();
+
+    if (tickNow == tickOrigin)
+        return Scale(tickOrigin, nanosecondOrigin, 1.0);
+
+    return Scale(tickOrigin, nanosecondOrigin,
+                 static_cast<double>(nanosecondNow - nanosecondOrigin) / static_cast<double>(tickNow - tickOrigin));
+}
@@ -0,0 +1,321 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file ControlPlane.cpp
+ * @brief Implementation of ControlPlane.hpp
+ */
+
+#include "ControlPlane.hpp"
+#include "BaseMock.hpp"
+#include "MockRegistry.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Copies a text in a fixed-size buffer of the region.
+ *
+ * @param buffer The buffer, of 64 chars
+ * @param text The text
+ */
+static void copyText(char (&buffer)[64], const std::string& text)
+{
+    std::strncpy(buffer, text.c_str(), sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+}
+
+/**
+ * Reads a text of a fixed-size buffer of the region, which the other
+ * process may have left without a terminating null char.
+ *
+ * @param buffer The buffer, of 64 chars
+ * @return The text
+ */
+static std::string readText(const char (&buffer)[64])
+{
+    return std::string(buffer, strnlen(buffer, sizeof(buffer)));
+}
+
+/**
+ * Tells whether a process attached to a region is still alive.
+ *
+ * @param pid The process, 0 if none
+ * @return Whether the process is alive, or is the current process
+ */
+static bool isAttached(std::int32_t pid)
+{
+    return pid != 0 && (pid == static_cast<std::int32_t>(getpid()) || kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+/**
+ * Maps a shared-memory region.
+ *
+ * @param regionName The name of the region
+ * @param create Whether the region must be created if it does not exist
+ * @return The region
+ */
+static ControlRegion* mapRegion(const std::string& regionName, bool create)
+{
+    const int fd = shm_open(regionName.c_str(), create ? (O_RDWR | O_CREAT) : O_RDWR, 0600);
+
+    if (fd < 0)
+        throw std::runtime_error("Cannot open the control region " + regionName + ": " + std::strerror(errno));
+
+    if (create && ftruncate(fd, sizeof(ControlRegion)) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot size the control region " + regionName);
+    }
+
+    void* addressPtr = mmap(nullptr, sizeof(ControlRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (addressPtr == MAP_FAILED)
+        throw std::runtime_error("Cannot map the control region " + regionName);
+
+    return static_cast<ControlRegion*>(addressPtr);
+}
+
+ControlPlane::ControlPlane(const std::string& providedRegionName, std::chrono::milliseconds providedPollInterval)
+    : name(providedRegionName), pollInterval(providedPollInterval), regionPtr(nullptr), stopping(false),
+      controlThread()
+{
+    regionPtr = mapRegion(name, true);
+
+    const std::int32_t pid = static_cast<std::int32_t>(getpid());
+    std::int32_t serverPid = regionPtr->serverPid.load();
+
+    /* A new region is filled with zeros. The region is taken over from a
+     * control plane which has exited */
+    do {
+        if (isAttached(serverPid)) {
+            munmap(regionPtr, sizeof(ControlRegion));
+            throw std::runtime_error("Another control plane is serving " + name);
+        }
+    } while (!regionPtr->serverPid.compare_exchange_strong(serverPid, pid));
+
+    regionPtr->magic.store(0);
+    regionPtr->version = ControlRegion::VERSION;
+    regionPtr->clientPid.store(0);
+    regionPtr->nextCommandId.store(1);
+    regionPtr->commands.reset();
+    regionPtr->responses.reset();
+    regionPtr->magic.store(ControlRegion::MAGIC, std::memory_order_release);
+
+    controlThread = std::thread(&ControlPlane::run, this);
+}
+
+ControlPlane::~ControlPlane()
+{
+    stopping.store(true);
+    controlThread.join();
+
+    regionPtr->magic.store(0);
+    regionPtr->serverPid.store(0);
+    munmap(regionPtr, sizeof(ControlRegion));
+    shm_unlink(name.c_str());
+}
+
+void ControlPlane::run()
+{
+    while (!stopping.load(std::memory_order_relaxed)) {
+        ControlCommand command;
+
+        if (regionPtr->commands.pop(command))
+            execute(command);
+        else
+            std::this_thread::sleep_for(pollInterval);
+    }
+}
+
+void ControlPlane::execute(const ControlCommand& command)
+{
+    ControlResponse response = { command.id, ControlResponse::DONE, 0, { '\0' } };
+    const std::string mockName = readText(command.mockName);
+    const std::string argument = readText(command.argument);
+    bool found = true;
+
+    switch (command.type) {
+    case ControlCommand::LIST: {
+        std::vector<ControlResponse> items;
+
+        /* The responses are sent once the registry is unlocked */
+        MockRegistry::forEach([&items, &command] (BaseMock& mock) {
+            ControlResponse item = { command.id, ControlResponse::MORE, mock.callCount(), { '\0' } };
+
+            copyText(item.text, mock.name());
+            items.push_back(item);
+        });
+
+        for (const ControlResponse& item : items)
+            respond(item);
+        break;
+    }
+    case ControlCommand::CALL_COUNT:
+        found = MockRegistry::withMock(mockName, [&response] (BaseMock& mock) {
+            response.value = mock.callCount();
+        });
+        break;
+    case ControlCommand::SWITCH_BEHAVIOR:
+        found = MockRegistry::withMock(mockName, [&response, &argument] (BaseMock& mock) {
+            if (!mock.switchBehavior(argument))
+                response.status = ControlResponse::UNKNOWN_BEHAVIOR;
+        });
+        break;
+    case ControlCommand::SET_RETURN:
+        found = MockRegistry::withMock(mockName, [&response, &argument] (BaseMock& mock) {
+            if (!mock.setReturnValue(argument))
+                response.status = ControlResponse::INVALID_VALUE;
+        });
+        break;
+    default:
+        response.status = ControlResponse::UNKNOWN_COMMAND;
+        break;
+    }
+
+    if (!found)
+        response.status = ControlResponse::UNKNOWN_MOCK;
+
+    respond(response);
+}
+
+void ControlPlane::respond(const ControlResponse& response)
+{
+    /* A client which stopped reading is replaced by the next one, which
+     * skips the responses to the previous commands */
+    while (!regionPtr->responses.push(response)) {
+        if (stopping.load(std::memory_order_relaxed))
+            return;
+
+        std::this_thread::sleep_for(pollInterval);
+    }
+}
+
+ControlClient::ControlClient(const std::string& regionName, std::chrono::milliseconds providedTimeout)
+    : regionPtr(mapRegion(regionName, false)), timeout(providedTimeout)
+{
+    if (regionPtr->magic.load(std::memory_order_acquire) != ControlRegion::MAGIC
+        || regionPtr->version != ControlRegion::VERSION) {
+        munmap(regionPtr, sizeof(ControlRegion));
+        throw std::runtime_error("No control plane is running for " + regionName);
+    }
+
+    const std::int32_t pid = static_cast<std::int32_t>(getpid());
+    std::int32_t clientPid = regionPtr->clientPid.load();
+
+    /* The region is taken over from a client which has exited */
+    do {
+        if (isAttached(clientPid)) {
+            munmap(regionPtr, sizeof(ControlRegion));
+            throw std::runtime_error("Another client is attached to " + regionName);
+        }
+    } while (!regionPtr->clientPid.compare_exchange_strong(clientPid, pid));
+}
+
+ControlClient::~ControlClient()
+{
+    regionPtr->clientPid.store(0);
+    munmap(regionPtr, sizeof(ControlRegion));
+}
+
+std::vector<ControlClient::MockStatus> ControlClient::mocks()
+{
+    const std::uint32_t id = send(ControlCommand::LIST, std::string(), std::string());
+    std::vector<MockStatus> statuses;
+
+    for (;;) {
+        const ControlResponse response = receive(id);
+
+        if (response.status != ControlResponse::MORE)
+            break;
+
+        const MockStatus status = { response.text, response.value };
+
+        statuses.push_back(status);
+    }
+
+    return statuses;
+}
+
+unsigned long long ControlClient::callCount(const std::string& mockName)
+{
+    return receive(send(ControlCommand::CALL_COUNT, mockName, std::string())).value;
+}
+
+void ControlClient::switchBehavior(const std::string& mockName, const std::string& behaviorName)
+{
+    receive(send(ControlCommand::SWITCH_BEHAVIOR, mockName, behaviorName));
+}
+
+void ControlClient::setReturnValue(const std::string& mockName, const std::string& value)
+{
+    receive(send(ControlCommand::SET_RETURN, mockName, value));
+}
+
+std::uint32_t ControlClient::send(ControlCommand::Type type, const std::string& mockName, const std::string& argument)
+{
+    ControlCommand command;
+
+    if (mockName.size() >= sizeof(command.mockName) || argument.size() >= sizeof(command.argument))
+        throw std::runtime_error("The name or the argument of the command is too long");
+
+    command.id = regionPtr->nextCommandId.fetch_add(1);
+    command.type = type;
+    copyText(command.mockName, mockName);
+    copyText(command.argument, argument);
+
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (!regionPtr->commands.push(command)) {
+        if (std::chrono::steady_clock::now() >= deadline)
+            throw std::runtime_error("The control plane does not read the commands");
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    return command.id;
+}
+
+ControlResponse ControlClient::receive(std::uint32_t id)
+{
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    ControlResponse response;
+
+    for (;;) {
+        if (regionPtr->responses.pop(response)) {
+            if (response.id == id)
+                break;
+
+            continue;
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline)
+            throw std::runtime_error("The control plane does not respond");
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    switch (response.status) {
+    case ControlResponse::UNKNOWN_MOCK:
+        throw std::runtime_error("Unknown mock");
+    case ControlResponse::UNKNOWN_BEHAVIOR:
+        throw std::runtime_error("Unknown behavior");
+    case ControlResponse::INVALID_VALUE:
+        throw std::runtime_error("Invalid return value");
+    case ControlResponse::UNKNOWN_COMMAND:
+        throw std::runtime_error("Unknown command");
+    default:
+        return response;
+    }
+}
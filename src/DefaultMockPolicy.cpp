@@ -0,0 +1,20 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file DefaultMockPolicy.cpp
+ * @brief Implementation of the non template part of DefaultMockPolicy.hpp
+ */
+
+#include "internal/DefaultMockPolicy.hpp"
+
+#include <stdexcept>
+
+void throwMockNotConfigured()
+{
+    throw std::runtime_error("Mock object is not configured for these values.");
+}
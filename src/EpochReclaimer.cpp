@@ -0,0 +1,190 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file EpochReclaimer.cpp
+ * @brief Implementation of EpochReclaimer.hpp
+ */
+
+#include "internal/EpochReclaimer.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/**
+ * Epoch announced by a thread: 0 when it is not reading. A record is reused
+ * by the next thread once its thread has exited.
+ */
+struct ThreadRecord
+{
+    std::atomic<unsigned long long> epoch;
+    std::atomic<bool> used;
+    unsigned int nesting;
+};
+
+/**
+ * Object waiting for the readers of its epoch
+ */
+struct RetiredObject
+{
+    void* objectPtr;
+    EpochReclaimer::Deleter deleter;
+    unsigned long long epoch;
+};
+
+/**
+ * Shared state of the reclaimer. It is created on first use and never
+ * destroyed, so that mocks can be destroyed during static destruction.
+ */
+struct ReclaimerState
+{
+    std::atomic<unsigned long long> globalEpoch;
+    std::mutex mutex; /* Protects the lists */
+    std::vector<ThreadRecord*> records;
+    std::vector<RetiredObject> retiredObjects;
+
+    ReclaimerState()
+        : globalEpoch(1), mutex(), records(), retiredObjects()
+    {
+    }
+};
+
+static ReclaimerState& reclaimerState()
+{
+    static ReclaimerState* statePtr = new ReclaimerState();
+
+    return *statePtr;
+}
+
+/**
+ * Record of the current thread, taken on its first read section and given
+ * back when it exits.
+ */
+class ThreadRecordOwner
+{
+public:
+    ThreadRecordOwner()
+        : recordPtr(nullptr)
+    {
+        ReclaimerState& state = reclaimerState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        for (ThreadRecord* freeRecordPtr : state.records) {
+            bool expected = false;
+
+            if (freeRecordPtr->used.compare_exchange_strong(expected, true)) {
+                recordPtr = freeRecordPtr;
+                break;
+            }
+        }
+
+        if (recordPtr == nullptr) {
+            recordPtr = new ThreadRecord();
+            recordPtr->epoch.store(0);
+            recordPtr->used.store(true);
+            state.records.push_back(recordPtr);
+        }
+
+        recordPtr->nesting = 0;
+    }
+
+    ~ThreadRecordOwner()
+    {
+        recordPtr->epoch.store(0);
+        recordPtr->used.store(false);
+    }
+
+    ThreadRecord* record() const
+    {
+        return recordPtr;
+    }
+
+private:
+    ThreadRecord* recordPtr;
+
+    ThreadRecordOwner(const ThreadRecordOwner&);
+    ThreadRecordOwner& operator=(const ThreadRecordOwner&);
+};
+
+static ThreadRecord* currentRecord()
+{
+    static thread_local ThreadRecordOwner owner;
+
+    return owner.record();
+}
+
+void EpochReclaimer::enter()
+{
+    ThreadRecord* recordPtr = currentRecord();
+
+    if (recordPtr->nesting++ == 0) {
+        recordPtr->epoch.store(reclaimerState().globalEpoch.load(std::memory_order_relaxed));
+        /* The reads of the section cannot happen before the announce */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void EpochReclaimer::leave()
+{
+    ThreadRecord* recordPtr = currentRecord();
+
+    if (--recordPtr->nesting == 0)
+        recordPtr->epoch.store(0, std::memory_order_release);
+}
+
+void EpochReclaimer::retire(void* objectPtr, Deleter deleter)
+{
+    ReclaimerState& state = reclaimerState();
+    /* The readers entering after this point cannot read the object */
+    const RetiredObject retiredObject = { objectPtr, deleter, state.globalEpoch.fetch_add(1) };
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.retiredObjects.push_back(retiredObject);
+    }
+
+    collect();
+}
+
+unsigned long EpochReclaimer::collect()
+{
+    ReclaimerState& state = reclaimerState();
+    std::vector<RetiredObject> reclaimedObjects;
+    unsigned long remainingObjects = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        unsigned long long oldestEpoch = ~0ULL;
+
+        for (ThreadRecord* recordPtr : state.records) {
+            const unsigned long long epoch = recordPtr->epoch.load();
+
+            if (epoch != 0 && epoch < oldestEpoch)
+                oldestEpoch = epoch;
+        }
+
+        std::vector<RetiredObject> keptObjects;
+
+        /* A reader of the epoch of the retirement may still read the object */
+        for (const RetiredObject& retiredObject : state.retiredObjects) {
+            if (retiredObject.epoch < oldestEpoch)
+                reclaimedObjects.push_back(retiredObject);
+            else
+                keptObjects.push_back(retiredObject);
+        }
+
+        state.retiredObjects.swap(keptObjects);
+        remainingObjects = state.retiredObjects.size();
+    }
+
+    /* The deleters may retire objects themselves */
+    for (const RetiredObject& retiredObject : reclaimedObjects)
+        retiredObject.deleter(retiredObject.objectPtr);
+
+    return remainingObjects;
+}
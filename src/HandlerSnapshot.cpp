@@ -0,0 +1,68 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file HandlerSnapshot.cpp
+ * @brief Implementation of HandlerSnapshot.hpp
+ */
+
+#include "internal/HandlerSnapshot.hpp"
+
+/**
+ * Returns the handlers of a snapshot, in the order they are tried.
+ *
+ * @param parentPtr The previous snapshot (may be null)
+ * @param addedHandlers The handlers added since the previous snapshot
+ * @return The handlers of the snapshot
+ */
+static std::vector<BaseCallHandler*> concatenate(const std::shared_ptr<const HandlerSnapshot>& parentPtr,
+                                                 const std::vector<BaseCallHandler*>& addedHandlers)
+{
+    std::vector<BaseCallHandler*> handlers;
+
+    if (parentPtr)
+        handlers = parentPtr->handlers();
+
+    handlers.insert(handlers.end(), addedHandlers.begin(), addedHandlers.end());
+
+    return handlers;
+}
+
+HandlerSnapshot::HandlerSnapshot(const std::shared_ptr<const HandlerSnapshot>& providedParentPtr,
+                                 const std::vector<BaseCallHandler*>& providedHandlers)
+    : parentPtr(providedParentPtr), ownedHandlers(providedHandlers),
+      ownVersion(concatenate(providedParentPtr, providedHandlers)), statefulHandlers()
+{
+    if (parentPtr)
+        statefulHandlers = parentPtr->statefulHandlers;
+
+    for (BaseCallHandler* handlerPtr : ownedHandlers)
+        if (handlerPtr->hasState())
+            statefulHandlers.push_back(handlerPtr);
+}
+
+HandlerSnapshot::~HandlerSnapshot()
+{
+    for (BaseCallHandler* handlerPtr : ownedHandlers)
+        delete handlerPtr;
+}
+
+void HandlerSnapshot::rewind() const
+{
+    for (BaseCallHandler* handlerPtr : statefulHandlers)
+        handlerPtr->rewind();
+}
+
+HandlerVersion::HandlerVersion(const std::shared_ptr<const HandlerSnapshot>& providedBaselinePtr,
+                               const std::vector<BaseCallHandler*>& addedHandlers)
+    : baselinePtr(providedBaselinePtr), handlerList()
+{
+    if (baselinePtr)
+        handlerList = baselinePtr->handlers();
+
+    handlerList.insert(handlerList.end(), addedHandlers.begin(), addedHandlers.end());
+}
@@ -0,0 +1,393 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockCore.cpp
+ * @brief Implementation of MockCore.hpp
+ */
+
+#include "internal/MockCore.hpp"
+#include "internal/EpochReclaimer.hpp"
+#include "internal/QueryPool.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+MockCore::MockCore()
+    : publishedVersionPtr(nullptr), publishedSnapshotPtr(), baselinePtr(), callHandlerList(), removedHandlerList(), handlersMutex(),
+      updateDepth(0), callHistoryList(), historyLock(), compressionEnabled(false), fingerprintsEnabled(false),
+      callFingerprints(), callRecordedPtr(), waiterCount(0)
+{
+}
+
+MockCore::~MockCore()
+{
+    /* Nobody calls a mock being destroyed: everything is deleted now. The
+     * version of a snapshot is deleted with the snapshot. */
+    if (!publishedSnapshotPtr)
+        delete publishedVersionPtr.load();
+
+    for (BaseCallHandler* callHandlerPtr : callHandlerList)
+        delete callHandlerPtr;
+
+    for (BaseCallHandler* callHandlerPtr : removedHandlerList)
+        delete callHandlerPtr;
+}
+
+void MockCore::addHandler(BaseCallHandler* handlerPtr)
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    callHandlerList.push_back(handlerPtr);
+    publishHandlers();
+}
+
+void MockCore::addPendingHandler(BaseCallHandler* handlerPtr)
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    handlerPtr->pendingCorePtr.store(this);
+    callHandlerList.push_back(handlerPtr);
+}
+
+void MockCore::publishConfiguredHandlers()
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    publishHandlers();
+}
+
+void MockCore::replaceHandlers(BaseCallHandler* handlerPtr)
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    removeHandlers();
+    baselinePtr.reset();
+    callHandlerList.push_back(handlerPtr);
+    publishHandlers();
+}
+
+void MockCore::clearHandlers()
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    removeHandlers();
+    baselinePtr.reset();
+    publishHandlers();
+}
+
+std::shared_ptr<const HandlerSnapshot> MockCore::snapshot(SnapshotFactory factory)
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    /* The handlers waiting for their configuration stay apart */
+    std::vector<BaseCallHandler*> configuredHandlers;
+    std::vector<BaseCallHandler*> pendingHandlers;
+
+    for (BaseCallHandler* callHandlerPtr : callHandlerList)
+        (pending(callHandlerPtr) ? pendingHandlers : configuredHandlers).push_back(callHandlerPtr);
+
+    if (!configuredHandlers.empty()) {
+        baselinePtr = factory(baselinePtr, configuredHandlers);
+        callHandlerList.swap(pendingHandlers);
+        publishHandlers();
+    }
+
+    return baselinePtr;
+}
+
+void MockCore::useSnapshot(const std::shared_ptr<const HandlerSnapshot>& providedSnapshot)
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    removeHandlers();
+
+    baselinePtr = providedSnapshot;
+
+    if (baselinePtr)
+        baselinePtr->rewind();
+
+    publishHandlers();
+}
+
+void MockCore::beginUpdate()
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    updateDepth++;
+}
+
+void MockCore::commitUpdate()
+{
+    std::lock_guard<std::mutex> lock(handlersMutex);
+
+    if (updateDepth > 0)
+        updateDepth--;
+
+    publishHandlers();
+}
+
+void MockCore::removeHandlers()
+{
+    /* A removed handler is no longer published when it is configured */
+    for (BaseCallHandler* callHandlerPtr : callHandlerList)
+        callHandlerPtr->pendingCorePtr.store(nullptr);
+
+    removedHandlerList.insert(removedHandlerList.end(), callHandlerList.begin(), callHandlerList.end());
+
+    callHandlerList.clear();
+}
+
+void MockCore::publishHandlers()
+{
+    if (updateDepth > 0)
+        return;
+
+    std::vector<BaseCallHandler*> configuredHandlers;
+
+    configuredHandlers.reserve(callHandlerList.size());
+
+    for (BaseCallHandler* callHandlerPtr : callHandlerList)
+        if (!pending(callHandlerPtr))
+            configuredHandlers.push_back(callHandlerPtr);
+
+    /* Without any added handler, the version of the baseline is published as
+     * it is: restoring a snapshot does not copy its handlers */
+    const HandlerVersion* versionPtr = nullptr;
+
+    if (!configuredHandlers.empty())
+        versionPtr = new HandlerVersion(baselinePtr, configuredHandlers);
+    else if (baselinePtr)
+        versionPtr = &baselinePtr->version();
+
+    const HandlerVersion* previousVersionPtr = publishedVersionPtr.exchange(versionPtr);
+
+    /* The previous version, and the handlers it was the last to use, are
+     * deleted once the calls reading them have returned. The version of a
+     * snapshot is only kept alive, with its snapshot, meanwhile. */
+    if (previousVersionPtr != nullptr && previousVersionPtr != versionPtr) {
+        if (publishedSnapshotPtr)
+            EpochReclaimer::retire(new std::shared_ptr<const HandlerSnapshot>(publishedSnapshotPtr));
+        else
+            EpochReclaimer::retire(const_cast<HandlerVersion*>(previousVersionPtr));
+    }
+
+    if (configuredHandlers.empty())
+        publishedSnapshotPtr = baselinePtr;
+    else
+        publishedSnapshotPtr.reset();
+
+    for (BaseCallHandler* callHandlerPtr : removedHandlerList)
+        EpochReclaimer::retire(callHandlerPtr);
+
+    removedHandlerList.clear();
+}
+
+unsigned int MockCore::countCalls(RecordFilter filter, const void* queryPtr, const std::uint64_t* fingerprintPtr,
+                                  bool threadSafe) const
+{
+    const std::size_t size = callHistoryList.size();
+
+    if (!threadSafe || size == 0 || size < QueryPool::threshold())
+        return countRange(filter, queryPtr, fingerprintPtr, 0, size);
+
+    /* Several chunks per thread, so that a thread slowed down by others does
+     * not delay the result. The history cannot change meanwhile, as the
+     * caller holds its lock. */
+    const std::size_t chunkCount = std::min<std::size_t>(QueryPool::threadCount() * 4, size);
+    const std::size_t chunkSize = (size + chunkCount - 1) / chunkCount;
+    std::vector<unsigned int> chunkCounts(chunkCount, 0);
+
+    QueryPool::run(chunkCount, [&] (std::size_t chunk) {
+        chunkCounts[chunk] = countRange(filter, queryPtr, fingerprintPtr, chunk * chunkSize,
+                                        std::min(size, (chunk + 1) * chunkSize));
+    });
+
+    return std::accumulate(chunkCounts.begin(), chunkCounts.end(), 0u);
+}
+
+unsigned int MockCore::countRange(RecordFilter filter, const void* queryPtr, const std::uint64_t* fingerprintPtr,
+                                  std::size_t begin, std::size_t end) const
+{
+    unsigned int nbrCall = 0;
+
+    /* Only the calls with the same fingerprint may be matched */
+    if (fingerprintPtr != nullptr) {
+        for (size_t i = begin; i < end; i++) {
+            if (callFingerprints[i] == *fingerprintPtr && filter(queryPtr, *callHistoryList[i]))
+                nbrCall += callHistoryList[i]->repeatCount();
+        }
+
+        return nbrCall;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        if (filter(queryPtr, *callHistoryList[i]))
+            nbrCall += callHistoryList[i]->repeatCount();
+    }
+
+    return nbrCall;
+}
+
+CallSequence::Number MockCore::lastCall(RecordFilter filter, const void* queryPtr) const
+{
+    for (auto it = callHistoryList.rbegin(); it != callHistoryList.rend(); ++it) {
+        if (filter(queryPtr, **it))
+            return (*it)->lastSequenceNumber();
+    }
+
+    return CallSequence::NONE;
+}
+
+CallSequence::Number MockCore::nextCall(CallSequence::Number after, RecordFilter filter, const void* queryPtr) const
+{
+    for (auto it = firstCallAfter(after); it != callHistoryList.end(); ++it) {
+        if (filter(queryPtr, **it))
+            return (*it)->sequenceNumberAfter(after);
+    }
+
+    return CallSequence::NONE;
+}
+
+unsigned int MockCore::callsBetween(CallSequence::Number after, CallSequence::Number before,
+                                    RecordFilter filter, const void* queryPtr) const
+{
+    unsigned int nbrCall = 0;
+
+    if (before <= after)
+        return 0;
+
+    for (auto it = firstCallAfter(after); it != callHistoryList.end() && (*it)->sequenceNumber() < before; ++it) {
+        if (filter(queryPtr, **it))
+            nbrCall += (*it)->repeatsBetween(after, before);
+    }
+
+    return nbrCall;
+}
+
+bool MockCore::waitForCalls(std::unique_lock<std::mutex>& lock, unsigned int count, RecordFilter filter,
+                            const void* queryPtr, std::chrono::steady_clock::time_point deadline)
+{
+    unsigned int nbrCall = 0;
+    size_t checkedCalls = 0;
+
+    if (!callRecordedPtr)
+        callRecordedPtr.reset(new std::condition_variable());
+
+    waiterCount++;
+
+    for (;;) {
+        /* The history has been cleared meanwhile */
+        if (checkedCalls > callHistoryList.size()) {
+            checkedCalls = 0;
+            nbrCall = 0;
+        }
+
+        /* Only the calls recorded since the last check are checked. The last
+         * entry may still grow with repeated calls, so it is counted apart. */
+        for (; checkedCalls + 1 < callHistoryList.size(); checkedCalls++) {
+            if (filter(queryPtr, *callHistoryList[checkedCalls]))
+                nbrCall += callHistoryList[checkedCalls]->repeatCount();
+        }
+
+        unsigned int lastCalls = 0;
+
+        if (checkedCalls < callHistoryList.size() && filter(queryPtr, *callHistoryList[checkedCalls]))
+            lastCalls = callHistoryList[checkedCalls]->repeatCount();
+
+        if (nbrCall + lastCalls >= count || std::chrono::steady_clock::now() >= deadline) {
+            nbrCall += lastCalls;
+            break;
+        }
+
+        callRecordedPtr->wait_until(lock, deadline);
+    }
+
+    waiterCount--;
+
+    return nbrCall >= count;
+}
+
+unsigned int MockCore::distinctCalls() const
+{
+    if (!fingerprintsEnabled)
+        throw std::runtime_error("The fingerprints of the calls are not recorded");
+
+    std::vector<std::uint64_t> fingerprints(callFingerprints);
+
+    std::sort(fingerprints.begin(), fingerprints.end());
+
+    return static_cast<unsigned int>(std::unique(fingerprints.begin(), fingerprints.end()) - fingerprints.begin());
+}
+
+std::vector<MockCore::RecordFrequency> MockCore::topRecords(unsigned int maximumCount) const
+{
+    if (!fingerprintsEnabled)
+        throw std::runtime_error("The fingerprints of the calls are not recorded");
+
+    /* Index, in the frequencies, of each fingerprint */
+    std::unordered_map<std::uint64_t, size_t> frequencyIndexes;
+    std::vector<RecordFrequency> frequencies;
+
+    for (size_t i = 0; i < callFingerprints.size(); i++) {
+        auto inserted = frequencyIndexes.insert(std::make_pair(callFingerprints[i], frequencies.size()));
+
+        if (inserted.second) {
+            const RecordFrequency frequency = { callHistoryList[i], callHistoryList[i]->repeatCount() };
+
+            frequencies.push_back(frequency);
+        } else {
+            frequencies[inserted.first->second].count += callHistoryList[i]->repeatCount();
+        }
+    }
+
+    /* The earliest first among the equally frequent */
+    std::stable_sort(frequencies.begin(), frequencies.end(),
+        [] (const RecordFrequency& first, const RecordFrequency& second) {
+            return first.count > second.count;
+        });
+
+    if (frequencies.size() > maximumCount)
+        frequencies.erase(frequencies.begin() + maximumCount, frequencies.end());
+
+    return frequencies;
+}
+
+void MockCore::clearHistory()
+{
+    callHistoryList.clear();
+    callFingerprints.clear();
+}
+
+void MockCore::setFingerprints(bool enabled, RecordFingerprint fingerprint, const void* fingerprinterPtr)
+{
+    fingerprintsEnabled = enabled;
+    computeFingerprints(fingerprint, fingerprinterPtr);
+}
+
+void MockCore::computeFingerprints(RecordFingerprint fingerprint, const void* fingerprinterPtr)
+{
+    callFingerprints.clear();
+
+    if (!fingerprintsEnabled)
+        return;
+
+    callFingerprints.reserve(callHistoryList.size());
+
+    for (CallRecord* callRecordPtr : callHistoryList)
+        callFingerprints.push_back(fingerprint(fingerprinterPtr, *callRecordPtr));
+}
+
+MockCore::HistoryIterator MockCore::firstCallAfter(CallSequence::Number after) const
+{
+    return std::upper_bound(callHistoryList.begin(), callHistoryList.end(), after,
+        [] (CallSequence::Number number, const CallRecord* callRecordPtr) {
+            return number < callRecordPtr->lastSequenceNumber();
+        });
+}
@@ -0,0 +1,17 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockInstantiation.cpp
+ * @brief Instantiation of the mock templates for the common signatures
+ */
+
+#define MOCKEUR_NO_EXTERN_TEMPLATES
+
+#include "Mock.hpp"
+
+MOCKEUR_COMMON_SIGNATURES(MOCKEUR_INSTANTIATE_TEMPLATE)
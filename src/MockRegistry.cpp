@@ -0,0 +1,87 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockRegistry.cpp
+ * @brief Implementation of MockRegistry.hpp
+ */
+
+#include "MockRegistry.hpp"
+#include "BaseMock.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+/**
+ * Returns the list of the registered mocks. It is created on first use and
+ * never destroyed, so that global mocks can be registered and unregistered
+ * during static initialization and destruction.
+ *
+ * @return The list of the registered mocks
+ */
+static std::vector<BaseMock*>& registeredMocks()
+{
+    static std::vector<BaseMock*>* mocks = new std::vector<BaseMock*>();
+
+    return *mocks;
+}
+
+/**
+ * Returns the lock of the registry, never destroyed either.
+ *
+ * @return The lock of the registry
+ */
+static std::mutex& registryMutex()
+{
+    static std::mutex* mutex = new std::mutex();
+
+    return *mutex;
+}
+
+void MockRegistry::add(BaseMock* mockPtr)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    std::vector<BaseMock*>& mocks = registeredMocks();
+
+    if (std::find(mocks.begin(), mocks.end(), mockPtr) == mocks.end())
+        mocks.push_back(mockPtr);
+}
+
+void MockRegistry::remove(BaseMock* mockPtr)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    std::vector<BaseMock*>& mocks = registeredMocks();
+
+    mocks.erase(std::remove(mocks.begin(), mocks.end(), mockPtr), mocks.end());
+}
+
+const std::vector<BaseMock*>& MockRegistry::mocks()
+{
+    return registeredMocks();
+}
+
+bool MockRegistry::withMock(const std::string& mockName, const std::function<void(BaseMock&)>& function)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+
+    for (BaseMock* mockPtr : registeredMocks()) {
+        if (mockPtr->name() == mockName) {
+            function(*mockPtr);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MockRegistry::forEach(const std::function<void(BaseMock&)>& function)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+
+    for (BaseMock* mockPtr : registeredMocks())
+        function(*mockPtr);
+}
@@ -0,0 +1,210 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file QueryPool.cpp
+ * @brief Implementation of QueryPool.hpp
+ */
+
+#include "internal/QueryPool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+/**
+ * Shared state of the pool. It is created on first use and never destroyed,
+ * so that the workers, which are detached, never outlive it.
+ */
+struct PoolState
+{
+    std::atomic<std::size_t> threshold;
+    std::mutex runMutex; /* Held by the thread whose task the pool runs */
+    std::mutex mutex; /* Protects the workers and the task */
+    std::condition_variable taskReady;
+    std::condition_variable taskDone;
+    bool sized;
+    unsigned int workerCount;
+    unsigned int startedWorkers; /* The workers beyond the count stay idle */
+    unsigned long long generation; /* Incremented by each task */
+    const std::function<void(std::size_t)>* taskPtr;
+    std::size_t chunkCount;
+    std::atomic<std::size_t> nextChunk;
+    unsigned int activeWorkers;
+    std::exception_ptr error;
+
+    PoolState()
+        : threshold(1 << 20), runMutex(), mutex(), taskReady(), taskDone(), sized(false), workerCount(0),
+          startedWorkers(0), generation(0), taskPtr(nullptr), chunkCount(0), nextChunk(0), activeWorkers(0),
+          error()
+    {
+    }
+};
+
+static PoolState& poolState()
+{
+    static PoolState* statePtr = new PoolState();
+
+    return *statePtr;
+}
+
+/**
+ * Runs the chunks of the current task until none is left.
+ *
+ * @param state The state of the pool
+ * @param task The task
+ * @param chunkCount The number of chunks of the task
+ */
+static void runChunks(PoolState& state, const std::function<void(std::size_t)>& task, std::size_t chunkCount)
+{
+    for (std::size_t chunk = state.nextChunk.fetch_add(1); chunk < chunkCount; chunk = state.nextChunk.fetch_add(1)) {
+        try {
+            task(chunk);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            if (!state.error)
+                state.error = std::current_exception();
+        }
+    }
+}
+
+/**
+ * Loop of a worker: runs the chunks of each task, unless the number of
+ * workers has been reduced below its index.
+ *
+ * @param state The state of the pool
+ * @param index The index of the worker
+ * @param seenGeneration The generation of the last task when the worker was
+ *                       started
+ */
+static void runWorker(PoolState& state, unsigned int index, unsigned long long seenGeneration)
+{
+    std::unique_lock<std::mutex> lock(state.mutex);
+
+    for (;;) {
+        state.taskReady.wait(lock, [&state, seenGeneration] () {
+            return state.generation != seenGeneration;
+        });
+
+        seenGeneration = state.generation;
+
+        /* The task has already been done by the other threads, or the
+         * worker is no longer used */
+        if (state.taskPtr == nullptr || index >= state.workerCount)
+            continue;
+
+        const std::function<void(std::size_t)>& task = *state.taskPtr;
+        const std::size_t chunkCount = state.chunkCount;
+
+        state.activeWorkers++;
+        lock.unlock();
+
+        runChunks(state, task, chunkCount);
+
+        lock.lock();
+
+        if (--state.activeWorkers == 0)
+            state.taskDone.notify_all();
+    }
+}
+
+/**
+ * Sets the number of workers, and starts the missing ones. The lock of the
+ * pool must be held.
+ *
+ * @param state The state of the pool
+ * @param workerCount The number of workers
+ */
+static void resize(PoolState& state, unsigned int workerCount)
+{
+    state.sized = true;
+    state.workerCount = workerCount;
+
+    for (; state.startedWorkers < workerCount; state.startedWorkers++)
+        std::thread(runWorker, std::ref(state), state.startedWorkers, state.generation).detach();
+}
+
+void QueryPool::run(std::size_t chunkCount, const std::function<void(std::size_t chunk)>& task)
+{
+    PoolState& state = poolState();
+    std::unique_lock<std::mutex> runLock(state.runMutex, std::try_to_lock);
+
+    if (!runLock.owns_lock() || threadCount() < 2) {
+        for (std::size_t chunk = 0; chunk < chunkCount; chunk++)
+            task(chunk);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        state.taskPtr = &task;
+        state.chunkCount = chunkCount;
+        state.nextChunk.store(0);
+        state.error = std::exception_ptr();
+        state.generation++;
+    }
+
+    state.taskReady.notify_all();
+
+    runChunks(state, task, chunkCount);
+
+    std::exception_ptr error;
+
+    {
+        std::unique_lock<std::mutex> lock(state.mutex);
+
+        /* Every chunk has been taken: only the workers still running one are
+         * waited for, the others skip the task */
+        state.taskDone.wait(lock, [&state] () {
+            return state.activeWorkers == 0;
+        });
+
+        state.taskPtr = nullptr;
+        error = state.error;
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+unsigned int QueryPool::threadCount()
+{
+    PoolState& state = poolState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    /* One thread per core by default, including the calling one */
+    if (!state.sized) {
+        const unsigned int coreCount = std::thread::hardware_concurrency();
+
+        resize(state, coreCount > 1 ? coreCount - 1 : 0);
+    }
+
+    return state.workerCount + 1;
+}
+
+void QueryPool::setThreadCount(unsigned int providedThreadCount)
+{
+    PoolState& state = poolState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    resize(state, providedThreadCount > 1 ? providedThreadCount - 1 : 0);
+}
+
+std::size_t QueryPool::threshold()
+{
+    return poolState().threshold.load(std::memory_order_relaxed);
+}
+
+void QueryPool::setThreshold(std::size_t providedThreshold)
+{
+    poolState().threshold.store(providedThreshold, std::memory_order_relaxed);
+}
@@ -0,0 +1,114 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file StringSearch.cpp
+ * @brief Implementation of StringSearch.hpp
+ */
+
+#include "internal/StringSearch.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <regex.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Returns whether a substring starts at one of the positions of a string.
+ *
+ * @param text The string
+ * @param firstPosition The first position to check
+ * @param lastPosition The last position to check
+ * @param pattern The substring, of at least two characters
+ * @param patternLength The length of the substring
+ * @return Whether the substring starts at one of the positions
+ */
+static bool containsFrom(const char* text, std::size_t firstPosition, std::size_t lastPosition,
+                         const char* pattern, std::size_t patternLength)
+{
+    for (std::size_t position = firstPosition; position <= lastPosition; position++) {
+        if (text[position] == pattern[0] && std::memcmp(text + position + 1, pattern + 1, patternLength - 1) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool StringSearch::contains(const char* text, const char* pattern, std::size_t patternLength)
+{
+    if (patternLength == 0)
+        return true;
+
+    const std::size_t textLength = std::strlen(text);
+
+    if (textLength < patternLength)
+        return false;
+
+    if (patternLength == 1)
+        return std::memchr(text, pattern[0], textLength) != nullptr;
+
+    std::size_t position = 0;
+
+#if defined(__SSE2__)
+    const __m128i firstCharacters = _mm_set1_epi8(pattern[0]);
+    const __m128i lastCharacters = _mm_set1_epi8(pattern[patternLength - 1]);
+
+    /* Both loads stay within the string */
+    for (; position + patternLength + 15 <= textLength; position += 16) {
+        const __m128i firstBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position));
+        const __m128i lastBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position + patternLength - 1));
+        unsigned int candidates = static_cast<unsigned int>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(firstBlock, firstCharacters), _mm_cmpeq_epi8(lastBlock, lastCharacters))));
+
+        while (candidates != 0) {
+            const unsigned int offset = static_cast<unsigned int>(__builtin_ctz(candidates));
+
+            if (std::memcmp(text + position + offset + 1, pattern + 1, patternLength - 2) == 0)
+                return true;
+
+            candidates &= candidates - 1;
+        }
+    }
+#endif
+
+    return containsFrom(text, position, textLength - patternLength, pattern, patternLength);
+}
+
+/**
+ * Compiled form of the regular expression
+ */
+struct CompiledRegex::Compiled
+{
+    regex_t regex;
+};
+
+CompiledRegex::CompiledRegex(const std::string& pattern)
+    : compiledPtr(new Compiled())
+{
+    const int error = regcomp(&compiledPtr->regex, pattern.c_str(), REG_EXTENDED | REG_NOSUB);
+
+    if (error != 0) {
+        char message[256];
+
+        regerror(error, &compiledPtr->regex, message, sizeof(message));
+        throw std::runtime_error("Invalid regular expression \"" + pattern + "\": " + message);
+    }
+}
+
+CompiledRegex::~CompiledRegex()
+{
+    regfree(&compiledPtr->regex);
+}
+
+bool CompiledRegex::search(const char* text) const
+{
+    return regexec(&compiledPtr->regex, text, 0, nullptr, 0) == 0;
+}
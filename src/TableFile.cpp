@@ -0,0 +1,375 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file TableFile.cpp
+ * @brief Implementation of TableFile.hpp
+ */
+
+#include "TableFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+static const char tableMagic[8] = { 'M', 'O', 'C', 'K', 'T', 'B', 'L', '1' };
+
+/**
+ * Header of a table file
+ */
+struct TableHeader
+{
+    char magic[8];
+    std::uint32_t keySize;
+    std::uint32_t valueSize;
+    std::uint64_t rowCount;
+};
+
+/**
+ * Returns the size rounded up to a multiple of 8 bytes.
+ *
+ * @param size A size in bytes
+ * @return The size padded to 8 bytes
+ */
+static std::size_t padded(std::size_t size)
+{
+    return (size + 7) & ~static_cast<std::size_t>(7);
+}
+
+TableFile::TableFile(const std::string& path)
+    : mappingPtr(nullptr), mappingSize(0), keyBytes(0), valueBytes(0), rowCount(0),
+      keysPtr(nullptr), valuesPtr(nullptr)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        throw std::runtime_error("Cannot open the table file " + path);
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 || static_cast<std::size_t>(fileStat.st_size) < sizeof(TableHeader)) {
+        close(fd);
+        throw std::runtime_error("Invalid table file " + path);
+    }
+
+    mappingSize = static_cast<std::size_t>(fileStat.st_size);
+    mappingPtr = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mappingPtr == MAP_FAILED)
+        throw std::runtime_error("Cannot map the table file " + path);
+
+    TableHeader header;
+    std::memcpy(&header, mappingPtr, sizeof(header));
+
+    keyBytes = header.keySize;
+    valueBytes = header.valueSize;
+
+    /* The header is not trusted: the row count is bounded by the size of the
+     * file before the sizes of the keys and values are computed */
+    const std::uint64_t rowBytes = static_cast<std::uint64_t>(header.keySize) + header.valueSize;
+    bool valid = std::memcmp(header.magic, tableMagic, sizeof(tableMagic)) == 0 && keyBytes != 0
+                 && header.rowCount <= (mappingSize - sizeof(TableHeader)) / rowBytes;
+
+    if (valid) {
+        rowCount = static_cast<std::size_t>(header.rowCount);
+        valid = sizeof(TableHeader) + padded(keyBytes * rowCount) + valueBytes * rowCount <= mappingSize;
+    }
+
+    if (!valid) {
+        munmap(mappingPtr, mappingSize);
+        throw std::runtime_error("Invalid table file " + path);
+    }
+
+    keysPtr = static_cast<const unsigned char*>(mappingPtr) + sizeof(TableHeader);
+    valuesPtr = keysPtr + padded(keyBytes * rowCount);
+}
+
+TableFile::~TableFile()
+{
+    munmap(mappingPtr, mappingSize);
+}
+
+const void* TableFile::find(const void* keyPtr) const
+{
+    std::size_t low = 0;
+    std::size_t high = rowCount;
+
+    while (low < high) {
+        const std::size_t middle = low + (high - low) / 2;
+        const int comparison = std::memcmp(keysPtr + middle * keyBytes, keyPtr, keyBytes);
+
+        if (comparison == 0)
+            return valuesPtr + middle * valueBytes;
+
+        if (comparison < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return nullptr;
+}
+
+TableBuilder::TableBuilder(std::size_t providedKeySize, std::size_t providedValueSize)
+    : keyBytes(providedKeySize), valueBytes(providedValueSize), rows()
+{
+}
+
+void TableBuilder::add(const void* keyPtr, const void* valuePtr)
+{
+    const unsigned char* keyBytesPtr = static_cast<const unsigned char*>(keyPtr);
+    const unsigned char* valueBytesPtr = static_cast<const unsigned char*>(valuePtr);
+
+    rows.insert(rows.end(), keyBytesPtr, keyBytesPtr + keyBytes);
+    rows.insert(rows.end(), valueBytesPtr, valueBytesPtr + valueBytes);
+}
+
+/**
+ * Outcome of the parsing of a CSV field
+ */
+enum FieldStatus
+{
+    FIELD_PARSED,
+    FIELD_INVALID,
+    FIELD_OUT_OF_RANGE
+};
+
+/**
+ * Parses a CSV field and stores it in the byte order of the machine.
+ *
+ * @param field The text of the field
+ * @param fieldType The type of the field
+ * @param out Where to store the field
+ * @return Whether the field has been parsed, or why not
+ */
+static FieldStatus parseField(const std::string& field, TableBuilder::FieldType fieldType, unsigned char* out)
+{
+    const char* begin = field.c_str();
+    char* end = nullptr;
+    bool inRange = true;
+
+    errno = 0;
+
+    switch (fieldType) {
+    case TableBuilder::FLOAT: {
+        const float value = std::strtof(begin, &end);
+        std::memcpy(out, &value, sizeof(value));
+        break;
+    }
+    case TableBuilder::DOUBLE: {
+        const double value = std::strtod(begin, &end);
+        std::memcpy(out, &value, sizeof(value));
+        break;
+    }
+    case TableBuilder::INT8:
+    case TableBuilder::INT16:
+    case TableBuilder::INT32:
+    case TableBuilder::INT64: {
+        const long long value = std::strtoll(begin, &end, 0);
+
+        if (fieldType == TableBuilder::INT8)
+            inRange = value >= std::numeric_limits<std::int8_t>::min()
+                      && value <= std::numeric_limits<std::int8_t>::max();
+        else if (fieldType == TableBuilder::INT16)
+            inRange = value >= std::numeric_limits<std::int16_t>::min()
+                      && value <= std::numeric_limits<std::int16_t>::max();
+        else if (fieldType == TableBuilder::INT32)
+            inRange = value >= std::numeric_limits<std::int32_t>::min()
+                      && value <= std::numeric_limits<std::int32_t>::max();
+
+        const std::int8_t value8 = static_cast<std::int8_t>(value);
+        const std::int16_t value16 = static_cast<std::int16_t>(value);
+        const std::int32_t value32 = static_cast<std::int32_t>(value);
+        const std::int64_t value64 = static_cast<std::int64_t>(value);
+
+        if (fieldType == TableBuilder::INT8)
+            std::memcpy(out, &value8, sizeof(value8));
+        else if (fieldType == TableBuilder::INT16)
+            std::memcpy(out, &value16, sizeof(value16));
+        else if (fieldType == TableBuilder::INT32)
+            std::memcpy(out, &value32, sizeof(value32));
+        else
+            std::memcpy(out, &value64, sizeof(value64));
+        break;
+    }
+    default: {
+        const unsigned long long value = std::strtoull(begin, &end, 0);
+
+        /* strtoull negates a negative value instead of rejecting it */
+        if (field.find('-') != std::string::npos)
+            inRange = false;
+        else if (fieldType == TableBuilder::UINT8)
+            inRange = value <= std::numeric_limits<std::uint8_t>::max();
+        else if (fieldType == TableBuilder::UINT16)
+            inRange = value <= std::numeric_limits<std::uint16_t>::max();
+        else if (fieldType == TableBuilder::UINT32)
+            inRange = value <= std::numeric_limits<std::uint32_t>::max();
+
+        const std::uint8_t value8 = static_cast<std::uint8_t>(value);
+        const std::uint16_t value16 = static_cast<std::uint16_t>(value);
+        const std::uint32_t value32 = static_cast<std::uint32_t>(value);
+        const std::uint64_t value64 = static_cast<std::uint64_t>(value);
+
+        if (fieldType == TableBuilder::UINT8)
+            std::memcpy(out, &value8, sizeof(value8));
+        else if (fieldType == TableBuilder::UINT16)
+            std::memcpy(out, &value16, sizeof(value16));
+        else if (fieldType == TableBuilder::UINT32)
+            std::memcpy(out, &value32, sizeof(value32));
+        else
+            std::memcpy(out, &value64, sizeof(value64));
+        break;
+    }
+    }
+
+    while (end != nullptr && (*end == ' ' || *end == '\t' || *end == '\r'))
+        end++;
+
+    if (end == begin || end == nullptr || *end != '\0')
+        return FIELD_INVALID;
+
+    return errno == 0 && inRange ? FIELD_PARSED : FIELD_OUT_OF_RANGE;
+}
+
+void TableBuilder::addCsv(std::istream& in, const std::vector<FieldType>& keyFields, FieldType valueField)
+{
+    std::size_t fieldsKeySize = 0;
+
+    for (FieldType fieldType : keyFields)
+        fieldsKeySize += fieldSize(fieldType);
+
+    if (fieldsKeySize != keyBytes || fieldSize(valueField) != valueBytes)
+        throw std::runtime_error("The CSV fields do not match the sizes of the table");
+
+    std::vector<unsigned char> row(keyBytes + valueBytes);
+    std::string line;
+    unsigned long lineNumber = 0;
+
+    while (std::getline(in, line)) {
+        lineNumber++;
+
+        const std::size_t start = line.find_first_not_of(" \t\r");
+
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        std::string field;
+        std::size_t offset = 0;
+        std::size_t fieldIndex = 0;
+        FieldStatus status = FIELD_PARSED;
+
+        while (status == FIELD_PARSED && std::getline(fields, field, ',')) {
+            const FieldType fieldType = fieldIndex < keyFields.size() ? keyFields[fieldIndex] : valueField;
+
+            status = fieldIndex <= keyFields.size() ? parseField(field, fieldType, &row[offset]) : FIELD_INVALID;
+            offset += fieldSize(fieldType);
+            fieldIndex++;
+        }
+
+        if (status == FIELD_OUT_OF_RANGE) {
+            std::ostringstream message;
+            message << "Out of range value in CSV line " << lineNumber << ": " << line;
+            throw std::runtime_error(message.str());
+        }
+
+        if (status != FIELD_PARSED || fieldIndex != keyFields.size() + 1) {
+            std::ostringstream message;
+            message << "Invalid CSV line " << lineNumber << ": " << line;
+            throw std::runtime_error(message.str());
+        }
+
+        add(&row[0], &row[keyBytes]);
+    }
+}
+
+void TableBuilder::write(const std::string& path) const
+{
+    const std::size_t rowBytes = keyBytes + valueBytes;
+    const std::size_t rowCount = rowBytes == 0 ? 0 : rows.size() / rowBytes;
+    std::vector<std::size_t> order(rowCount);
+
+    for (std::size_t i = 0; i < rowCount; i++)
+        order[i] = i;
+
+    const unsigned char* rowsPtr = rows.data();
+    const std::size_t keySize = keyBytes;
+
+    std::sort(order.begin(), order.end(), [rowsPtr, rowBytes, keySize] (std::size_t first, std::size_t second) {
+        return std::memcmp(rowsPtr + first * rowBytes, rowsPtr + second * rowBytes, keySize) < 0;
+    });
+
+    for (std::size_t i = 1; i < rowCount; i++)
+        if (std::memcmp(rowsPtr + order[i - 1] * rowBytes, rowsPtr + order[i] * rowBytes, keySize) == 0)
+            throw std::runtime_error("Two rows of the table have the same key");
+
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    TableHeader header;
+
+    std::memcpy(header.magic, tableMagic, sizeof(tableMagic));
+    header.keySize = static_cast<std::uint32_t>(keyBytes);
+    header.valueSize = static_cast<std::uint32_t>(valueBytes);
+    header.rowCount = rowCount;
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (std::size_t i = 0; i < rowCount; i++)
+        out.write(reinterpret_cast<const char*>(rowsPtr + order[i] * rowBytes), keyBytes);
+
+    static const char padding[8] = { 0 };
+    out.write(padding, padded(keyBytes * rowCount) - keyBytes * rowCount);
+
+    for (std::size_t i = 0; i < rowCount; i++)
+        out.write(reinterpret_cast<const char*>(rowsPtr + order[i] * rowBytes + keyBytes), valueBytes);
+
+    if (!out.flush())
+        throw std::runtime_error("Cannot write the table file " + path);
+}
+
+bool TableBuilder::parseFieldType(const std::string& name, FieldType& fieldType)
+{
+    static const char* const names[] = { "i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32", "f64" };
+
+    for (std::size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (name == names[i]) {
+            fieldType = static_cast<FieldType>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::size_t TableBuilder::fieldSize(FieldType fieldType)
+{
+    switch (fieldType) {
+    case INT8:
+    case UINT8:
+        return 1;
+    case INT16:
+    case UINT16:
+        return 2;
+    case INT32:
+    case UINT32:
+    case FLOAT:
+        return 4;
+    default:
+        return 8;
+    }
+}
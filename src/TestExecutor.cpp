@@ -0,0 +1,450 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file TestExecutor.cpp
+ * @brief Implementation of TestExecutor.hpp
+ */
+
+#include "TestExecutor.hpp"
+#include "BaseMock.hpp"
+#include "MockRegistry.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+/**
+ * Shared-memory results area, mapped before the workers are forked so that
+ * they all see it at the same address.
+ */
+class ResultsArea
+{
+public:
+    /**
+     * State of a test in the shared-memory results area
+     */
+    enum SlotState
+    {
+        SLOT_PENDING,
+        SLOT_RUNNING,
+        SLOT_DONE
+    };
+
+    /**
+     * Result of a test in the shared-memory results area. The calls to the
+     * mocks are stored apart, in a matrix of a line per test.
+     */
+    struct TestSlot
+    {
+        std::atomic<int> state;
+        pid_t workerPid;
+        int status;
+        long long durationNs;
+        char message[256];
+    };
+
+    /**
+     * Header of the shared-memory results area
+     */
+    struct SharedArea
+    {
+        std::atomic<unsigned int> nextTest;
+    };
+
+    ResultsArea(size_t providedTestCount, size_t providedMockCount)
+        : testCount(providedTestCount), mockCount(providedMockCount), size(0), basePtr(nullptr)
+    {
+        size = sizeof(SharedArea) + testCount * sizeof(TestSlot)
+               + testCount * mockCount * sizeof(unsigned long long);
+        basePtr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+        if (basePtr == MAP_FAILED)
+            throw std::runtime_error("Cannot map the results area of the test executor");
+
+        new (header()) SharedArea();
+        header()->nextTest.store(0);
+
+        for (size_t i = 0; i < testCount; i++) {
+            TestSlot* slotPtr = new (slot(i)) TestSlot();
+            slotPtr->state.store(SLOT_PENDING);
+            slotPtr->workerPid = 0;
+            slotPtr->status = TestExecutor::NOT_RUN;
+            slotPtr->durationNs = 0;
+            slotPtr->message[0] = '\0';
+        }
+    }
+
+    ~ResultsArea()
+    {
+        munmap(basePtr, size);
+    }
+
+    SharedArea* header() const
+    {
+        return static_cast<SharedArea*>(basePtr);
+    }
+
+    TestSlot* slot(size_t testIndex) const
+    {
+        return reinterpret_cast<TestSlot*>(static_cast<char*>(basePtr) + sizeof(SharedArea))
+               + testIndex;
+    }
+
+    unsigned long long* mockCalls(size_t testIndex) const
+    {
+        return reinterpret_cast<unsigned long long*>(slot(testCount)) + testIndex * mockCount;
+    }
+
+    bool hasPendingTests() const
+    {
+        return header()->nextTest.load() < testCount;
+    }
+
+private:
+    size_t testCount;
+    size_t mockCount;
+    size_t size;
+    void* basePtr;
+
+    ResultsArea(const ResultsArea&);
+    ResultsArea& operator=(const ResultsArea&);
+};
+
+/**
+ * Copies a message in a fixed-size buffer of the results area.
+ *
+ * @param buffer The buffer, of 256 chars
+ * @param message The message
+ */
+static void copyMessage(char (&buffer)[256], const char* message)
+{
+    std::strncpy(buffer, message, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+}
+
+/**
+ * Marks the test of a slot as failed.
+ *
+ * @param slotPtr The slot of the test, or nullptr
+ * @param message The message of the failure
+ */
+static void failSlot(ResultsArea::TestSlot* slotPtr, const char* message)
+{
+    if (slotPtr == nullptr)
+        return;
+
+    copyMessage(slotPtr->message, message);
+    slotPtr->status = TestExecutor::FAILED;
+    slotPtr->state.store(ResultsArea::SLOT_DONE);
+}
+
+/**
+ * Runs the pending tests until there is none.
+ *
+ * @param slotPtr Set to the slot of the test being run, and reset once its
+ *                result is stored
+ */
+static void runTests(const std::vector<std::pair<std::string, TestExecutor::TestFunction> >& tests,
+                     const TestExecutor::TestFunction& tearDown, ResultsArea& area,
+                     ResultsArea::TestSlot*& slotPtr)
+{
+    const std::vector<BaseMock*>& mocks = MockRegistry::mocks();
+    std::vector<unsigned long long> callCountsBefore(mocks.size());
+
+    for (unsigned int testIndex = area.header()->nextTest.fetch_add(1); testIndex < tests.size();
+         testIndex = area.header()->nextTest.fetch_add(1)) {
+        slotPtr = area.slot(testIndex);
+        slotPtr->workerPid = getpid();
+        slotPtr->state.store(ResultsArea::SLOT_RUNNING);
+
+        for (size_t i = 0; i < mocks.size(); i++)
+            callCountsBefore[i] = mocks[i]->callCount();
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int status = TestExecutor::PASSED;
+
+        try {
+            tests[testIndex].second();
+        } catch (std::exception& e) {
+            status = TestExecutor::FAILED;
+            copyMessage(slotPtr->message, e.what());
+        } catch (...) {
+            status = TestExecutor::FAILED;
+            copyMessage(slotPtr->message, "Unknown exception");
+        }
+
+        slotPtr->durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        unsigned long long* callsPtr = area.mockCalls(testIndex);
+        for (size_t i = 0; i < mocks.size(); i++)
+            callsPtr[i] = mocks[i]->callCount() - callCountsBefore[i];
+
+        if (tearDown)
+            tearDown();
+
+        slotPtr->status = status;
+        slotPtr->state.store(ResultsArea::SLOT_DONE);
+        slotPtr = nullptr;
+    }
+}
+
+/**
+ * Body of a worker process: runs the pending tests, then exits the process
+ * without running the destructors of the global objects. The worker never
+ * returns, even when the tear down throws: the exception would otherwise
+ * unwind into the caller of TestExecutor::run, in the worker.
+ */
+static void runWorker(const std::vector<std::pair<std::string, TestExecutor::TestFunction> >& tests,
+                      const TestExecutor::TestFunction& tearDown, ResultsArea& area)
+{
+    ResultsArea::TestSlot* slotPtr = nullptr;
+
+    /* The state of a worker whose tear down failed cannot be trusted: it
+     * leaves the next tests to a new worker */
+    try {
+        runTests(tests, tearDown, area, slotPtr);
+    } catch (std::exception& e) {
+        failSlot(slotPtr, e.what());
+        _exit(1);
+    } catch (...) {
+        failSlot(slotPtr, "Unknown exception");
+        _exit(1);
+    }
+
+    _exit(0);
+}
+
+/**
+ * Worker process, seen from the calling process
+ */
+struct Worker
+{
+    pid_t pid;
+    /* Read end of a pipe whose write end only the worker holds: the end of
+     * the worker closes it, which wakes up the calling process */
+    int exitFd;
+};
+
+/**
+ * Forks a worker process.
+ *
+ * @return The worker
+ */
+static Worker forkWorker(const std::vector<std::pair<std::string, TestExecutor::TestFunction> >& tests,
+                         const TestExecutor::TestFunction& tearDown, ResultsArea& area)
+{
+    int exitPipe[2];
+
+    if (pipe(exitPipe) < 0)
+        throw std::runtime_error("Cannot create the pipe of a worker of the test executor");
+
+    /* The programs executed by the tests do not keep the worker alive */
+    fcntl(exitPipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(exitPipe[1], F_SETFD, FD_CLOEXEC);
+
+    /* The buffered output would otherwise be written by every worker */
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    const pid_t pid = fork();
+
+    if (pid < 0) {
+        close(exitPipe[0]);
+        close(exitPipe[1]);
+        throw std::runtime_error("Cannot fork a worker of the test executor");
+    }
+
+    if (pid == 0) {
+        close(exitPipe[0]);
+        runWorker(tests, tearDown, area);
+    }
+
+    close(exitPipe[1]);
+
+    const Worker worker = { pid, exitPipe[0] };
+
+    return worker;
+}
+
+/**
+ * Waits for the end of a worker, and fails the test it was running, if any.
+ *
+ * @param worker The worker, whose pipe has been closed
+ * @param area The results area
+ * @param testCount The number of tests
+ */
+static void reapWorker(const Worker& worker, ResultsArea& area, size_t testCount)
+{
+    int waitStatus = 0;
+    pid_t pid;
+
+    close(worker.exitFd);
+
+    /* Only the workers are waited for: the other children of the process are
+     * not the business of the executor, which must not reap them */
+    do {
+        pid = waitpid(worker.pid, &waitStatus, 0);
+    } while (pid < 0 && errno == EINTR);
+
+    if (pid < 0)
+        return;
+
+    /* The test the worker was running when it died did not pass */
+    for (size_t i = 0; i < testCount; i++) {
+        ResultsArea::TestSlot* slotPtr = area.slot(i);
+
+        if (slotPtr->state.load() == ResultsArea::SLOT_RUNNING && slotPtr->workerPid == pid) {
+            char message[256];
+
+            if (WIFSIGNALED(waitStatus))
+                std::snprintf(message, sizeof(message), "Killed by signal %d (%s)",
+                              WTERMSIG(waitStatus), strsignal(WTERMSIG(waitStatus)));
+            else
+                std::snprintf(message, sizeof(message), "Exited with status %d",
+                              WEXITSTATUS(waitStatus));
+
+            copyMessage(slotPtr->message, message);
+            slotPtr->durationNs = 0;
+            slotPtr->status = TestExecutor::CRASHED;
+            slotPtr->state.store(ResultsArea::SLOT_DONE);
+        }
+    }
+}
+
+TestExecutor::TestExecutor()
+    : testList(), tearDownFunction(), resultList()
+{
+}
+
+void TestExecutor::addTest(const std::string& name, const TestFunction& testFunction)
+{
+    testList.push_back(std::make_pair(name, testFunction));
+}
+
+void TestExecutor::setTearDown(const TestFunction& function)
+{
+    tearDownFunction = function;
+}
+
+unsigned int TestExecutor::run(unsigned int workerCount)
+{
+    const std::vector<BaseMock*> mocks = MockRegistry::mocks();
+    ResultsArea area(testList.size(), mocks.size());
+
+    if (workerCount == 0) {
+        const long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+        workerCount = processorCount > 0 ? static_cast<unsigned int>(processorCount) : 1;
+    }
+    if (workerCount > testList.size())
+        workerCount = static_cast<unsigned int>(testList.size());
+
+    std::vector<Worker> workers;
+    while (workers.size() < workerCount)
+        workers.push_back(forkWorker(testList, tearDownFunction, area));
+
+    std::vector<struct pollfd> exitPollFds;
+
+    while (!workers.empty()) {
+        /* Sleeps until a worker ends */
+        exitPollFds.resize(workers.size());
+        for (size_t i = 0; i < workers.size(); i++) {
+            exitPollFds[i].fd = workers[i].exitFd;
+            exitPollFds[i].events = POLLIN;
+            exitPollFds[i].revents = 0;
+        }
+
+        if (poll(&exitPollFds[0], exitPollFds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        size_t endedCount = 0;
+
+        for (size_t i = exitPollFds.size(); i-- > 0;) {
+            if (exitPollFds[i].revents != 0) {
+                reapWorker(workers[i], area, testList.size());
+                workers.erase(workers.begin() + i);
+                endedCount++;
+            }
+        }
+
+        for (; endedCount > 0 && area.hasPendingTests(); endedCount--)
+            workers.push_back(forkWorker(testList, tearDownFunction, area));
+    }
+
+    for (const Worker& worker : workers)
+        reapWorker(worker, area, testList.size());
+
+    unsigned int failureCount = 0;
+    resultList.clear();
+
+    for (size_t i = 0; i < testList.size(); i++) {
+        const ResultsArea::TestSlot* slotPtr = area.slot(i);
+        const unsigned long long* callsPtr = area.mockCalls(i);
+        Result result;
+
+        result.name = testList[i].first;
+        result.status = static_cast<Status>(slotPtr->status);
+        result.durationNs = slotPtr->durationNs;
+        result.message = slotPtr->message;
+
+        if (result.status == PASSED || result.status == FAILED)
+            for (size_t j = 0; j < mocks.size(); j++)
+                if (callsPtr[j] != 0)
+                    result.mockCalls.push_back(std::make_pair(mocks[j]->name(), callsPtr[j]));
+
+        if (result.status != PASSED)
+            failureCount++;
+
+        resultList.push_back(result);
+    }
+
+    return failureCount;
+}
+
+const std::vector<TestExecutor::Result>& TestExecutor::results() const
+{
+    return resultList;
+}
+
+void TestExecutor::writeReport(std::ostream& out) const
+{
+    static const char* const statusNames[] = { "NOT RUN", "PASSED", "FAILED", "CRASHED" };
+    unsigned int failureCount = 0;
+
+    for (const Result& result : resultList) {
+        out << "[" << statusNames[result.status] << "] " << result.name
+            << " (" << result.durationNs / 1000 << " us)";
+
+        if (!result.message.empty())
+            out << ": " << result.message;
+
+        out << "\n";
+
+        if (result.status != PASSED)
+            failureCount++;
+    }
+
+    out << failureCount << " of " << resultList.size() << " tests did not pass" << std::endl;
+}
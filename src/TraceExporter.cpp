@@ -0,0 +1,135 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file TraceExporter.cpp
+ * @brief Implementation of TraceExporter.hpp
+ */
+
+#include "TraceExporter.hpp"
+
+#include "BaseMock.hpp"
+#include "MockRegistry.hpp"
+
+#include <unistd.h>
+
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+
+/**
+ * Writes a string as a JSON string literal.
+ *
+ * @param out The stream to write to
+ * @param value The string to write
+ */
+static void writeJsonString(std::ostream& out, const std::string& value)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    out << '"';
+
+    for (std::string::const_iterator it = value.begin(); it != value.end(); ++it) {
+        const unsigned char character = static_cast<unsigned char>(*it);
+
+        if (character == '"' || character == '\\')
+            out << '\\' << *it;
+        else if (character < 0x20)
+            out << "\\u00" << hexDigits[character >> 4] << hexDigits[character & 0xf];
+        else
+            out << *it;
+    }
+
+    out << '"';
+}
+
+void TraceExporter::writeChromeTrace(std::ostream& out)
+{
+    const std::vector<BaseMock*>& mocks = MockRegistry::mocks();
+    const long pid = static_cast<long>(getpid());
+    const CallTimer::Scale scale = BaseMock::timestampScale();
+    long long origin = LLONG_MAX;
+    bool firstEvent = true;
+
+    for (const BaseMock* mockPtr : mocks) {
+        if (!mockPtr->timedCalls().empty() && mockPtr->timedCalls().front().timestamp < origin)
+            origin = mockPtr->timedCalls().front().timestamp;
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    for (std::size_t tid = 1; tid <= mocks.size(); tid++) {
+        const BaseMock* mockPtr = mocks[tid - 1];
+
+        out << (firstEvent ? "\n" : ",\n");
+        firstEvent = false;
+
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, mockPtr->name());
+        out << "}}";
+
+        for (const BaseMock::TimedCall& timedCall : mockPtr->timedCalls()) {
+            const long long elapsed = scale.toNanoseconds(timedCall.timestamp) - scale.toNanoseconds(origin);
+            const unsigned long long magnitude = elapsed < 0
+                ? 0ULL - static_cast<unsigned long long>(elapsed) : static_cast<unsigned long long>(elapsed);
+            /* Formatted apart, so that the fill of the stream is not changed.
+             * Chrome trace timestamps are in microseconds. */
+            char timestamp[48];
+
+            std::snprintf(timestamp, sizeof(timestamp), "%s%llu.%03u", elapsed < 0 ? "-" : "", magnitude / 1000,
+                          static_cast<unsigned int>(magnitude % 1000));
+
+            out << ",\n{\"name\":";
+            writeJsonString(out, mockPtr->name());
+            out << ",\"cat\":\"mockeur\",\"ph\":\"i\",\"s\":\"t\",\"pid\":" << pid << ",\"tid\":" << tid
+                << ",\"ts\":" << timestamp;
+            out << ",\"args\":{\"seq\":" << timedCall.sequenceNumber << "}}";
+        }
+    }
+
+    out << "\n]}\n";
+}
+
+bool TraceExporter::writeChromeTrace(const std::string& path)
+{
+    std::ofstream file(path.c_str());
+
+    if (!file)
+        return false;
+
+    writeChromeTrace(file);
+
+    return static_cast<bool>(file);
+}
+
+std::vector<unsigned long long> TraceExporter::gapHistogram(const BaseMock& mock)
+{
+    const std::vector<BaseMock::TimedCall>& timedCalls = mock.timedCalls();
+    const CallTimer::Scale scale = BaseMock::timestampScale();
+    std::vector<unsigned long long> histogram;
+
+    for (std::size_t i = 1; i < timedCalls.size(); i++) {
+        const long long signedGap = scale.toNanoseconds(timedCalls[i].timestamp)
+                                    - scale.toNanoseconds(timedCalls[i - 1].timestamp);
+        unsigned long long gap = signedGap > 0 ? static_cast<unsigned long long>(signedGap) : 0;
+        std::size_t bucket = 0;
+
+        while (gap > 1) {
+            gap >>= 1;
+            bucket++;
+        }
+
+        if (histogram.size() <= bucket)
+            histogram.resize(bucket + 1, 0);
+
+        histogram[bucket]++;
+    }
+
+    return histogram;
+}
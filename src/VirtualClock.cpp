@@ -0,0 +1,32 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file VirtualClock.cpp
+ * @brief Implementation of VirtualClock.hpp
+ */
+
+#include "VirtualClock.hpp"
+
+constexpr bool VirtualClock::is_steady;
+
+std::atomic<VirtualClock::rep> VirtualClock::elapsed(0);
+
+VirtualClock::time_point VirtualClock::now()
+{
+    return time_point(duration(elapsed.load(std::memory_order_relaxed)));
+}
+
+void VirtualClock::advance(duration elapsedTime)
+{
+    elapsed.fetch_add(elapsedTime.count(), std::memory_order_relaxed);
+}
+
+void VirtualClock::reset()
+{
+    elapsed.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,43 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file CountingArgumentMatcher.hpp
+ * @brief Matcher which counts its evaluations
+ */
+
+#ifndef COUNTINGARGUMENTMATCHER_HPP_
+#define COUNTINGARGUMENTMATCHER_HPP_
+
+#include "ArgumentMatcher/AbstractArgumentMatcher.hpp"
+
+template<typename Type>
+class CountingArgumentMatcher: public AbstractArgumentMatcher<Type>
+{
+public:
+    CountingArgumentMatcher(bool providedResult)
+        : AbstractArgumentMatcher<Type>(), result(providedResult), evaluations(0)
+    {
+    }
+
+    bool match(Type) const
+    {
+        evaluations++;
+        return result;
+    }
+
+    unsigned int evaluationCount() const
+    {
+        return evaluations;
+    }
+
+private:
+    bool result;
+    mutable unsigned int evaluations;
+};
+
+#endif /* COUNTINGARGUMENTMATCHER_HPP_ */
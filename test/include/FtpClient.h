@@ -56,6 +56,37 @@ enum DataModel ftp_getDataModel(void);
  */
 void ftp_setDataModel(enum DataModel dataModel);
 
+/**
+ * Return the time elapsed since an arbitrary point, in milliseconds.
+ * Important: this function will be mocked.
+ *
+ * @return The time elapsed since an arbitrary point, in milliseconds
+ */
+unsigned long ftp_clockMs(void);
+
+/**
+ * Compute the checksum of the provided bytes.
+ * Important: this function has a real implementation (in a shared library),
+ * it will be spied.
+ *
+ * @param content The content to check
+ * @param length The length of the content
+ *
+ * @return The checksum of the content
+ */
+unsigned int ftp_checksum(const char* content, unsigned int length);
+
+/**
+ * Parse the code of a reply of the FTP server.
+ * Important: this function has a real implementation (in a shared library),
+ * it will be wrapped (with the --wrap option of GNU ld).
+ *
+ * @param reply The reply of the server
+ *
+ * @return The code of the reply, or -1 if the reply is malformed
+ */
+int ftp_replyCode(const char* reply);
+
 /**
  * Try to send the provided file to some FTP server and return whether it
  * succeed or not.
@@ -66,4 +97,15 @@ void ftp_setDataModel(enum DataModel dataModel);
  */
 int sendFile (File_s* filePtr);
 
+/**
+ * Try to send the provided file to some FTP server until it is fully sent or
+ * the timeout expires.
+ *
+ * @param filePtr The pointer to the file object
+ * @param timeoutMs The timeout, in milliseconds
+ *
+ * @return Whether the file has been sent before the timeout
+ */
+int sendFileBefore (File_s* filePtr, unsigned long timeoutMs);
+
 #endif /* FTPCLIENT_H_ */
@@ -30,3 +30,18 @@ int sendFile (File_s* filePtr)
 
     return totalBytesSent == bytesToSend;
 }
+
+int sendFileBefore (File_s* filePtr, unsigned long timeoutMs)
+{
+    const unsigned long deadline = ftp_clockMs() + timeoutMs;
+    unsigned int totalBytesSent = 0;
+
+    while (totalBytesSent < filePtr->length) {
+        if (ftp_clockMs() >= deadline)
+            return 0;
+
+        totalBytesSent += ftp_send(&(filePtr->content[totalBytesSent]), filePtr->length-totalBytesSent);
+    }
+
+    return 1;
+}
@@ -0,0 +1,40 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file FtpProtocol.c
+ * @brief Real implementation of low level functions of the FTP client (the
+ *        functions which will be spied).
+ */
+
+#include "FtpClient.h"
+
+unsigned int ftp_checksum(const char* content, unsigned int length)
+{
+    unsigned int checksum = 0;
+    unsigned int i;
+
+    for (i = 0; i < length; i++)
+        checksum += (unsigned char) content[i];
+
+    return checksum;
+}
+
+int ftp_replyCode(const char* reply)
+{
+    int code = 0;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        if (reply[i] < '0' || reply[i] > '9')
+            return -1;
+
+        code = code * 10 + (reply[i] - '0');
+    }
+
+    return code;
+}
@@ -0,0 +1,223 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockScriptTest.cpp
+ * @brief Unit tests for the class MockScript (C++20)
+ */
+
+#include "Mock.hpp"
+#include "MockScript.hpp"
+#include "ArgumentMatcher/ArgumentMatcher.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#ifndef MOCKEUR_HAS_COROUTINES
+#error "MockScriptTest.cpp must be built with the coroutines of C++20"
+#endif
+
+/* Counts the allocations, to check that a call allocates nothing */
+static std::atomic<unsigned long> allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+    allocationCount++;
+
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+/* Control connection of a FTP server: int ftp_command(const char* command).
+ * The mock is initialized at compile time, before any constructor runs. */
+constinit Mock<int, const char*> mock_ftp_command;
+
+MockScript<int, const char*> ftpServer()
+{
+    const std::tuple<const char*>& call = co_await CallArguments();
+
+    /* Handshake */
+    co_yield 220;
+
+    while (std::strcmp(std::get<0>(call), "USER anonymous") != 0)
+        co_yield 530;
+    co_yield 331;
+    co_yield 230;
+
+    /* Transfers, until the end of the session */
+    while (std::strcmp(std::get<0>(call), "QUIT") != 0)
+        co_yield std::strncmp(std::get<0>(call), "RETR ", 5) == 0 ? 150 : 502;
+    co_yield 221;
+}
+
+MockScript<int, const char*> failingServer()
+{
+    co_yield 220;
+    throw std::runtime_error("connection reset");
+}
+
+/* Set by the slow server while it answers a call, until it is released */
+static std::atomic<bool> slowServerBusy(false);
+static std::atomic<bool> slowServerReleased(false);
+
+MockScript<int, const char*> slowServer()
+{
+    co_yield 220;
+
+    slowServerBusy = true;
+    while (!slowServerReleased)
+        std::this_thread::yield();
+
+    co_yield 200;
+}
+
+void testScriptAnswersSuccessiveCalls(void)
+{
+    mock_ftp_command.when(ArgumentMatcher::any<const char*>())->then(ftpServer);
+
+    assert(220 == mock_ftp_command.value("CONNECT"));
+    assert(530 == mock_ftp_command.value("USER root"));
+    assert(331 == mock_ftp_command.value("USER anonymous"));
+    assert(230 == mock_ftp_command.value("PASS guest"));
+    assert(150 == mock_ftp_command.value("RETR file.txt"));
+    assert(502 == mock_ftp_command.value("SITE CHMOD"));
+    assert(221 == mock_ftp_command.value("QUIT"));
+
+    /* The script has ended */
+    try {
+        mock_ftp_command.value("NOOP");
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    mock_ftp_command.clear();
+}
+
+void testScriptExceptionIsForwarded(void)
+{
+    mock_ftp_command.when(ArgumentMatcher::any<const char*>())->then(failingServer);
+
+    assert(220 == mock_ftp_command.value("CONNECT"));
+
+    try {
+        mock_ftp_command.value("NOOP");
+        assert(false);
+    } catch (std::runtime_error& e) {
+        assert(std::string("connection reset") == e.what());
+    }
+
+    mock_ftp_command.clear();
+}
+
+void testScriptStartsOverOnRestore(void)
+{
+    mock_ftp_command.when(ArgumentMatcher::any<const char*>())->then(ftpServer);
+
+    const Mock<int, const char*>::Snapshot session = mock_ftp_command.snapshot();
+
+    assert(220 == mock_ftp_command.value("CONNECT"));
+    assert(331 == mock_ftp_command.value("USER anonymous"));
+
+    mock_ftp_command.restore(session);
+
+    assert(220 == mock_ftp_command.value("CONNECT"));
+    assert(530 == mock_ftp_command.value("USER root"));
+
+    mock_ftp_command.clear();
+}
+
+void testScriptRejectsConcurrentCalls(void)
+{
+    mock_ftp_command.when(ArgumentMatcher::any<const char*>())->then(slowServer);
+
+    assert(220 == mock_ftp_command.value("CONNECT"));
+
+    std::thread caller([] () {
+        assert(200 == mock_ftp_command.value("NOOP"));
+    });
+
+    while (!slowServerBusy)
+        std::this_thread::yield();
+
+    /* The script is answering the other thread */
+    try {
+        mock_ftp_command.value("NOOP");
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    slowServerReleased = true;
+    caller.join();
+
+    mock_ftp_command.clear();
+}
+
+void testScriptCallsDoNotAllocate(void)
+{
+    MockScriptRunner<int, const char*> runner(ftpServer);
+
+    const unsigned long allocationsBefore = allocationCount;
+
+    assert(220 == runner.answer("CONNECT"));
+    assert(331 == runner.answer("USER anonymous"));
+    assert(230 == runner.answer("PASS guest"));
+
+    for (int i = 0; i < 1000; i++)
+        assert(150 == runner.answer("RETR file.txt"));
+
+    assert(allocationsBefore == allocationCount);
+}
+
+void testMockCreatedOnFirstUse(void)
+{
+    const unsigned long allocationsBefore = allocationCount;
+
+    {
+        Mock<int, const char*> unusedMock;
+    }
+
+    assert(allocationsBefore == allocationCount);
+
+    Mock<int, const char*> usedMock;
+
+    usedMock.when(ArgumentMatcher::any<const char*>())->thenReturn(200);
+
+    assert(allocationsBefore < allocationCount);
+    assert(200 == usedMock.value("NOOP"));
+    assert(1u == usedMock.numberOfCalls(ArgumentMatcher::any<const char*>()));
+}
+
+int main (int, const char* [])
+{
+    testScriptAnswersSuccessiveCalls();
+    testScriptExceptionIsForwarded();
+    testScriptStartsOverOnRestore();
+    testScriptRejectsConcurrentCalls();
+    testScriptCallsDoNotAllocate();
+    testMockCreatedOnFirstUse();
+
+    return EXIT_SUCCESS;
+}
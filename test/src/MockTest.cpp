@@ -10,24 +10,103 @@
  * @brief Unit tests for the class Mock
  */
 
+#include "CallSequence.hpp"
+#include "ControlPlane.hpp"
+#include "LookupTable.hpp"
 #include "Mock.hpp"
+#include "MockRegistry.hpp"
+#include "Spy.hpp"
+#include "TestExecutor.hpp"
+#include "TraceExporter.hpp"
+#include "VirtualClock.hpp"
 #include "ArgumentMatcher/ArgumentMatcher.hpp"
 
 #include "AlternativeMockPolicy.hpp"
+#include "CountingArgumentMatcher.hpp"
+/* Generated by mockeur_wrap, with CMake 3.1 or newer */
+#ifdef MOCKEUR_TEST_WRAP
+#include "mockeur-test-mockeur-wrap.hpp"
+#endif
 
 extern "C"
 {
 #include "FtpClient.h"
+#include <sys/wait.h>
+#include <unistd.h>
 }
 
+#include <atomic>
 #include <cassert>
+#include <cstdio>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 #include <stdexcept>
 
+/* Counts the allocations, to check that restoring a snapshot allocates
+ * nothing. Every form is replaced, as some tests allocate from several
+ * threads and the standard library also uses the non-throwing ones. */
+static std::atomic<unsigned long> allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+    allocationCount++;
+
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    allocationCount++;
+
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& nothrow) noexcept
+{
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
 /* Declaration of the mocks and definition of the mocked function */
 Mock<int, const char*, unsigned int> mock_ftp_send;
 Mock<enum DataModel> mock_ftp_getDataModel;
 Mock<void, enum DataModel> mock_ftp_setDataModel;
+Mock<unsigned long> mock_ftp_clockMs;
+Spy<unsigned int, const char*, unsigned int> spy_ftp_checksum("ftp_checksum");
 
 int ftp_send(const char* content, unsigned int length)
 {
@@ -44,11 +123,27 @@ void ftp_setDataModel(enum DataModel dataModel)
     mock_ftp_setDataModel.value(dataModel);
 }
 
+unsigned long ftp_clockMs(void)
+{
+    return mock_ftp_clockMs.value();
+}
+
+unsigned int ftp_checksum(const char* content, unsigned int length)
+{
+    return spy_ftp_checksum.value(content, length);
+}
+
 void tearDown()
 {
     mock_ftp_send.clear();
     mock_ftp_getDataModel.clear();
     mock_ftp_setDataModel.clear();
+    mock_ftp_clockMs.clear();
+    spy_ftp_checksum.clear();
+#ifdef MOCKEUR_TEST_WRAP
+    wrap_ftp_replyCode.clear();
+#endif
+    VirtualClock::reset();
 }
 
 /* First unit test */
@@ -132,7 +227,7 @@ void testSendInTwoTimesWithSpecializedMatcher(void)
 
 void testSetPolicy(void)
 {
-    AlternativeMockPolicy<int, const char*, unsigned int> mockPolicy;
+    static AlternativeMockPolicy<int, const char*, unsigned int> mockPolicy;
 
     mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
                        ArgumentMatcher::eq<unsigned int>(128u))
@@ -156,12 +251,1202 @@ void testSetPolicy(void)
     tearDown();
 }
 
+void testSpyForwardsToRealImplementation(void)
+{
+    const char* content = "abc";
+
+    assert(spy_ftp_checksum.hasRealFunction());
+
+    /* Not matched by any call handler: the real implementation is called */
+    assert(294u == ftp_checksum(content, 3));
+
+    spy_ftp_checksum.when(ArgumentMatcher::any<const char*>(),
+                          ArgumentMatcher::eq<unsigned int>(0))
+                    ->thenReturn(42u);
+
+    assert(42u == ftp_checksum(content, 0));
+    assert(97u == ftp_checksum(content, 1));
+    assert(98u == spy_ftp_checksum.real(&(content[1]), 1));
+
+    assert(3u == spy_ftp_checksum.numberOfCalls(ArgumentMatcher::eq<const char*>(content),
+                                                ArgumentMatcher::any<unsigned int>()));
+
+    tearDown();
+}
+
+#ifdef MOCKEUR_TEST_WRAP
+void testWrappedMockArmedAndDisarmed(void)
+{
+    /* Disarmed: the real implementation is called */
+    assert(226 == ftp_replyCode("226 Transfer complete"));
+
+    wrap_ftp_replyCode.when(ArgumentMatcher::any<const char*>())->thenReturn(421);
+    wrap_ftp_replyCode.arm();
+
+    assert(421 == ftp_replyCode("226 Transfer complete"));
+
+    wrap_ftp_replyCode.disarm();
+
+    assert(-1 == ftp_replyCode("Transfer complete"));
+    assert(1u == wrap_ftp_replyCode.numberOfCalls(ArgumentMatcher::any<const char*>()));
+
+    tearDown();
+
+    assert(!wrap_ftp_replyCode.armed());
+
+    /* Also when cleared as a Mock, like a generic tear down does */
+    Mock<int, const char*>& replyCodeMock = wrap_ftp_replyCode;
+
+    wrap_ftp_replyCode.arm();
+    replyCodeMock.clear();
+
+    assert(!wrap_ftp_replyCode.armed());
+}
+#endif
+
+void testSendWithSimulatedLatency(void)
+{
+    File_s* filePtr = new File_s;
+    filePtr->content = "Hello world!";
+    filePtr->length = 13;
+
+    mock_ftp_clockMs.when()->thenReturnVirtualTime(std::chrono::milliseconds(1));
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturnAfter(std::chrono::milliseconds(250), 13);
+
+    assert(sendFileBefore(filePtr, 1000));
+    assert(std::chrono::milliseconds(250) == VirtualClock::now().time_since_epoch());
+
+    tearDown();
+}
+
+void testSendTimesOut(void)
+{
+    File_s* filePtr = new File_s;
+    filePtr->content = "Hello world!";
+    filePtr->length = 13;
+
+    mock_ftp_clockMs.when()->thenReturnVirtualTime(std::chrono::milliseconds(1));
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenTimeout(std::chrono::seconds(30));
+
+    /* One hour of retries */
+    assert(!sendFileBefore(filePtr, 3600 * 1000));
+    assert(120u == mock_ftp_send.numberOfCalls(ArgumentMatcher::any<const char*>(),
+                                               ArgumentMatcher::any<unsigned int>()));
+    assert(std::chrono::hours(1) == VirtualClock::now().time_since_epoch());
+
+    tearDown();
+}
+
+/* Returns a fingerprint of the failures of ftp_send over the provided number
+ * of calls and counts them. */
+unsigned long long failurePattern(unsigned int calls, unsigned int& failures)
+{
+    unsigned long long pattern = 0;
+
+    failures = 0;
+
+    for (unsigned int i = 0; i < calls; i++) {
+        if (ftp_send("", 0) < 0) {
+            failures++;
+            pattern = pattern * 31 + i;
+        }
+    }
+
+    return pattern;
+}
+
+void testFailWithProbabilityIsReproducible(void)
+{
+    unsigned int failures = 0;
+    unsigned int failuresReplayed = 0;
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenFailWithProbability(0.25, -1, 0, 42);
+
+    const unsigned long long pattern = failurePattern(10000, failures);
+
+    assert(failures > 2300 && failures < 2700);
+
+    tearDown();
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenFailWithProbability(0.25, -1, 0, 42);
+
+    assert(pattern == failurePattern(10000, failuresReplayed));
+    assert(failures == failuresReplayed);
+
+    tearDown();
+}
+
+void testFailInBursts(void)
+{
+    unsigned int burstLength = 0;
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenFailInBursts(0.01, 8, -1, 0);
+
+    for (unsigned int i = 0; i < 10000; i++) {
+        if (ftp_send("", 0) < 0) {
+            burstLength++;
+        } else {
+            /* Bursts may be chained */
+            assert(burstLength % 8 == 0);
+            burstLength = 0;
+        }
+    }
+
+    tearDown();
+}
+
+void testFailAfter(void)
+{
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenFailAfter(2, -1, 13);
+
+    assert(13 == ftp_send("", 0));
+    assert(13 == ftp_send("", 0));
+    assert(-1 == ftp_send("", 0));
+    assert(-1 == ftp_send("", 0));
+
+    tearDown();
+}
+
+/* Return type without default constructor */
+struct Reply
+{
+    explicit Reply(int providedCode)
+        : code(providedCode)
+    {
+    }
+
+    int code;
+};
+
+void testReturnTypeWithoutDefaultConstructor(void)
+{
+    Mock<Reply, const char*> mock_ftp_command;
+
+    mock_ftp_command.when(ArgumentMatcher::strEq("NOOP"))->thenReturn(Reply(200));
+    mock_ftp_command.when(ArgumentMatcher::any<const char*>())->thenFailAfter(1, Reply(421), Reply(250));
+
+    assert(200 == mock_ftp_command.value("NOOP").code);
+    assert(250 == mock_ftp_command.value("CWD").code);
+    assert(421 == mock_ftp_command.value("CWD").code);
+}
+
+void testCallOrderAcrossMocks(void)
+{
+    File_s* filePtr = new File_s;
+    filePtr->content = "Hello world!";
+    filePtr->length = 13;
+
+    mock_ftp_getDataModel.when()->thenReturn(ASCII);
+    mock_ftp_setDataModel.when(ArgumentMatcher::any<enum DataModel>())->thenReturn();
+    /* Send 5 bytes at most */
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->then([] (const char*, unsigned int length) { return length < 5 ? length : 5; });
+
+    assert(sendFile(filePtr));
+
+    const CallSequence::Number setDataModelIndex =
+        mock_ftp_setDataModel.firstCallIndex(ArgumentMatcher::eq<enum DataModel>(BINARY));
+    const CallSequence::Number firstSendIndex =
+        mock_ftp_send.firstCallIndex(ArgumentMatcher::any<const char*>(), ArgumentMatcher::any<unsigned int>());
+    const CallSequence::Number lastSendIndex =
+        mock_ftp_send.lastCallIndex(ArgumentMatcher::any<const char*>(), ArgumentMatcher::any<unsigned int>());
+
+    assert(CallSequence::inOrder(mock_ftp_getDataModel.firstCallIndex(), setDataModelIndex,
+                                 firstSendIndex, lastSendIndex));
+    assert(!CallSequence::inOrder(firstSendIndex, setDataModelIndex));
+    assert(!CallSequence::inOrder(setDataModelIndex,
+                                  mock_ftp_setDataModel.firstCallIndex(ArgumentMatcher::eq<enum DataModel>(ASCII))));
+
+    /* 3 calls are needed to send 13 bytes, 5 by 5 */
+    assert(1u == mock_ftp_send.callsBetween(firstSendIndex, lastSendIndex,
+                                            ArgumentMatcher::any<const char*>(),
+                                            ArgumentMatcher::any<unsigned int>()));
+    assert(0u == mock_ftp_send.callsBetween(0, setDataModelIndex,
+                                            ArgumentMatcher::any<const char*>(),
+                                            ArgumentMatcher::any<unsigned int>()));
+    assert(lastSendIndex == mock_ftp_send.nextCallIndex(firstSendIndex + 1,
+                                                        ArgumentMatcher::any<const char*>(),
+                                                        ArgumentMatcher::eq<unsigned int>(3)));
+
+    tearDown();
+}
+
+void testChromeTraceExport(void)
+{
+    File_s* filePtr = new File_s;
+    filePtr->content = "Hello world!";
+    filePtr->length = 13;
+
+    mock_ftp_send.setName("ftp_send");
+    mock_ftp_send.recordTimestamps(true);
+    mock_ftp_getDataModel.setName("ftp_getDataModel");
+    mock_ftp_getDataModel.recordTimestamps(true);
+
+    mock_ftp_getDataModel.when()->thenReturn(BINARY);
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->then([] (const char*, unsigned int length) { return length < 5 ? length : 5; });
+
+    assert(sendFile(filePtr));
+
+    assert(2u <= MockRegistry::mocks().size());
+    assert(3u == mock_ftp_send.timedCalls().size());
+    assert(1u == mock_ftp_getDataModel.timedCalls().size());
+    assert(mock_ftp_getDataModel.timedCalls()[0].timestamp <= mock_ftp_send.timedCalls()[0].timestamp);
+    assert(CallSequence::inOrder(mock_ftp_send.timedCalls()[0].sequenceNumber,
+                                 mock_ftp_send.timedCalls()[2].sequenceNumber));
+
+    /* 2 gaps between the 3 calls */
+    std::vector<unsigned long long> histogram = TraceExporter::gapHistogram(mock_ftp_send);
+    unsigned long long gaps = 0;
+
+    for (unsigned long long bucketCount : histogram)
+        gaps += bucketCount;
+
+    assert(2u == gaps);
+    assert(TraceExporter::gapHistogram(mock_ftp_setDataModel).empty());
+
+    std::ostringstream trace;
+
+    TraceExporter::writeChromeTrace(trace);
+
+    const std::string json = trace.str();
+
+    assert(0u == json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    assert(std::string::npos != json.find("\"args\":{\"name\":\"ftp_getDataModel\"}"));
+    assert(std::string::npos != json.find("{\"name\":\"ftp_send\",\"cat\":\"mockeur\",\"ph\":\"i\""));
+    assert(std::string::npos != json.find("\"ts\":0.000,"));
+
+    /* The formatting of the stream is left unchanged */
+    assert(' ' == trace.fill());
+
+    tearDown();
+
+    assert(mock_ftp_send.timedCalls().empty());
+
+    mock_ftp_send.recordTimestamps(false);
+    mock_ftp_getDataModel.recordTimestamps(false);
+}
+
+void testCallSitesAttribution(void)
+{
+    File_s* filePtr = new File_s;
+    filePtr->content = "Hello world!";
+    filePtr->length = 13;
+
+    mock_ftp_send.recordCallers(true);
+    mock_ftp_getDataModel.when()->thenReturn(BINARY);
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->then([] (const char*, unsigned int length) { return length < 5 ? length : 5; });
+
+    assert(sendFile(filePtr));
+
+    /* The 3 calls are made by the same call site of sendFile */
+    std::vector<BaseMock::CallSite> sites = mock_ftp_send.callSites();
+    assert(1u == sites.size());
+    assert(3u == sites[0].count);
+    assert("sendFile" == sites[0].function);
+    assert(0u < sites[0].offset);
+    assert(sites[0].object.find("mockeur-test") != std::string::npos);
+
+    /* Calls are not counted per call site by default */
+    assert(mock_ftp_getDataModel.callSites().empty());
+
+    mock_ftp_send.recordCallers(false);
+    tearDown();
+    assert(mock_ftp_send.callSites().empty());
+}
+
+void testExecutorInWorkerProcesses(void)
+{
+    TestExecutor executor;
+    const unsigned long long sendCallsBefore = mock_ftp_send.callCount();
+
+    executor.setTearDown(tearDown);
+    executor.addTest("sendInThreeTimes", [] () {
+        File_s* filePtr = new File_s;
+        filePtr->content = "Hello world!";
+        filePtr->length = 13;
+
+        mock_ftp_getDataModel.when()->thenReturn(BINARY);
+        mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                           ArgumentMatcher::any<unsigned int>())
+                     ->then([] (const char*, unsigned int length) { return length < 5 ? length : 5; });
+
+        if (!sendFile(filePtr))
+            throw std::runtime_error("sendFile failed");
+    });
+    executor.addTest("throws", [] () { throw std::runtime_error("expected failure"); });
+    executor.addTest("crashes", [] () { std::abort(); });
+    executor.addTest("passesAfterCrash", [] () {});
+
+    assert(2u == executor.run(2));
+
+    const std::vector<TestExecutor::Result>& results = executor.results();
+
+    assert(4u == results.size());
+    assert(TestExecutor::PASSED == results[0].status);
+    /* The named mocks, in the order of their registration */
+    assert(2u == results[0].mockCalls.size());
+    assert("ftp_send" == results[0].mockCalls[0].first);
+    assert(3u == results[0].mockCalls[0].second);
+    assert("ftp_getDataModel" == results[0].mockCalls[1].first);
+    assert(1u == results[0].mockCalls[1].second);
+    assert(TestExecutor::FAILED == results[1].status);
+    assert("expected failure" == results[1].message);
+    assert(TestExecutor::CRASHED == results[2].status);
+    assert(std::string::npos != results[2].message.find("signal"));
+    assert(TestExecutor::PASSED == results[3].status);
+
+    /* The tests ran in the workers, not in this process */
+    assert(sendCallsBefore == mock_ftp_send.callCount());
+
+    std::ostringstream report;
+
+    executor.writeReport(report);
+
+    assert(std::string::npos != report.str().find("[CRASHED] crashes"));
+    assert(std::string::npos != report.str().find("2 of 4 tests did not pass"));
+}
+
+void testExecutorWithFailingTearDown(void)
+{
+    TestExecutor executor;
+
+    /* A child process of another part of the program, which the executor
+     * must not reap */
+    const pid_t otherChildPid = fork();
+
+    if (otherChildPid == 0)
+        _exit(7);
+
+    /* Each worker leaves after its first test, instead of unwinding into
+     * this function */
+    executor.setTearDown([] () { throw std::runtime_error("tear down failed"); });
+    executor.addTest("first", [] () {});
+    executor.addTest("second", [] () {});
+
+    assert(2u == executor.run(1));
+    assert(TestExecutor::FAILED == executor.results()[0].status);
+    assert("tear down failed" == executor.results()[0].message);
+    assert(TestExecutor::FAILED == executor.results()[1].status);
+
+    int otherChildStatus = 0;
+
+    assert(otherChildPid == waitpid(otherChildPid, &otherChildStatus, 0));
+    assert(WIFEXITED(otherChildStatus) && 7 == WEXITSTATUS(otherChildStatus));
+}
+
+void testSnapshotAndRestore(void)
+{
+    /* Baseline: the 2 first sends succeed, then every send fails */
+    mock_ftp_getDataModel.when()->thenReturn(ASCII);
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenFailAfter(2, 0, 5);
+
+    Mock<enum DataModel>::Snapshot dataModelBaseline = mock_ftp_getDataModel.snapshot();
+    Mock<int, const char*, unsigned int>::Snapshot sendBaseline = mock_ftp_send.snapshot();
+
+    /* Nothing new to take */
+    assert(sendBaseline == mock_ftp_send.snapshot());
+
+    assert(5u == ftp_send("Hello", 5));
+    assert(5u == ftp_send("Hello", 5));
+    assert(0u == ftp_send("Hello", 5));
+
+    /* A per-test override, tried after the baseline */
+    mock_ftp_getDataModel.when()->thenReturn(BINARY);
+    assert(ASCII == ftp_getDataModel());
+
+    mock_ftp_send.restore(sendBaseline);
+    mock_ftp_getDataModel.restore(dataModelBaseline);
+
+    /* The history is cleared and the fault injection starts over */
+    assert(0u == mock_ftp_send.numberOfCalls(ArgumentMatcher::any<const char*>(),
+                                             ArgumentMatcher::any<unsigned int>()));
+    assert(5u == ftp_send("Hello", 5));
+    assert(5u == ftp_send("Hello", 5));
+    assert(0u == ftp_send("Hello", 5));
+    assert(ASCII == ftp_getDataModel());
+
+    /* The snapshot survives the clear of the mock */
+    tearDown();
+    mock_ftp_getDataModel.restore(dataModelBaseline);
+    assert(ASCII == ftp_getDataModel());
+
+    tearDown();
+}
+
+void testRestoreIndependentOfSnapshotSize(void)
+{
+    Mock<int, unsigned int> mock_readLargeRegister;
+    Mock<int, unsigned int> mock_readSmallRegister;
+
+    for (unsigned int address = 0; address < 200; address++)
+        mock_readLargeRegister.when(ArgumentMatcher::eq(address))->thenReturn(static_cast<int>(address));
+    mock_readSmallRegister.when(ArgumentMatcher::any<unsigned int>())->thenReturn(0);
+
+    Mock<int, unsigned int>::Snapshot largeBaseline = mock_readLargeRegister.snapshot();
+    Mock<int, unsigned int>::Snapshot smallBaseline = mock_readSmallRegister.snapshot();
+
+    mock_readLargeRegister.restore(largeBaseline);
+    mock_readSmallRegister.restore(smallBaseline);
+
+    /* Nothing added since the snapshot: the version of the snapshot is
+     * published again */
+    unsigned long allocationsBefore = allocationCount.load();
+
+    mock_readLargeRegister.restore(largeBaseline);
+    assert(allocationsBefore == allocationCount);
+    assert(199 == mock_readLargeRegister.value(199));
+
+    /* A per-test override: restoring retires it, without copying the
+     * handlers of the snapshot */
+    unsigned long largeAllocations = 0;
+    unsigned long smallAllocations = 0;
+
+    for (int round = 0; round < 2; round++) {
+        mock_readLargeRegister.when(ArgumentMatcher::any<unsigned int>())->thenReturn(-1);
+        mock_readSmallRegister.when(ArgumentMatcher::any<unsigned int>())->thenReturn(-1);
+
+        allocationsBefore = allocationCount.load();
+        mock_readLargeRegister.restore(largeBaseline);
+        largeAllocations = allocationCount.load() - allocationsBefore;
+
+        allocationsBefore = allocationCount.load();
+        mock_readSmallRegister.restore(smallBaseline);
+        smallAllocations = allocationCount.load() - allocationsBefore;
+    }
+
+    assert(largeAllocations == smallAllocations);
+    assert(5 == mock_readLargeRegister.value(5));
+}
+
+void testLookupTable(void)
+{
+    /* Register map: (bank, address) -> value */
+    Mock<int, unsigned short, unsigned int> mock_readRegister;
+    LookupTableBuilder<int, unsigned short, unsigned int> generatedTable;
+
+    for (unsigned int address = 0; address < 10000; address++)
+        generatedTable.add(static_cast<int>(address * 3), 1, address);
+
+    generatedTable.write("mockeur-test-registers.tbl");
+
+    std::istringstream csv("# bank, address, value\n"
+                           "2, 0x10, -1\n"
+                           "\n"
+                           "2, 0x20, 42\n");
+    TableBuilder csvTable(sizeof(unsigned short) + sizeof(unsigned int), sizeof(int));
+
+    csvTable.addCsv(csv, { TableBuilder::UINT16, TableBuilder::UINT32 }, TableBuilder::INT32);
+    csvTable.write("mockeur-test-registers-csv.tbl");
+
+    std::shared_ptr<const LookupTable<int, unsigned short, unsigned int> > generatedTablePtr =
+        std::make_shared<LookupTable<int, unsigned short, unsigned int> >("mockeur-test-registers.tbl");
+
+    assert(10000u == generatedTablePtr->size());
+
+    /* The handlers instantiated before the tables are tried first */
+    mock_readRegister.when(ArgumentMatcher::eq<unsigned short>(1), ArgumentMatcher::eq<unsigned int>(7))
+                     ->thenReturn(-7);
+    mock_readRegister.whenInTable(generatedTablePtr);
+    mock_readRegister.whenInTable(std::make_shared<const LookupTable<int, unsigned short, unsigned int> >(
+        "mockeur-test-registers-csv.tbl"));
+
+    assert(-7 == mock_readRegister.value(1, 7));
+    assert(0 == mock_readRegister.value(1, 0));
+    assert(29997 == mock_readRegister.value(1, 9999));
+    assert(-1 == mock_readRegister.value(2, 0x10));
+    assert(42 == mock_readRegister.value(2, 0x20));
+
+    try {
+        mock_readRegister.value(3, 0);
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    try {
+        LookupTable<int, unsigned int> wrongTable("mockeur-test-registers.tbl");
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    /* A value which does not fit its column */
+    std::istringstream outOfRangeCsv("1, 2, 3\n"
+                                     "1, 300, 3\n");
+    TableBuilder outOfRangeTable(sizeof(unsigned short) + sizeof(unsigned char), sizeof(int));
+
+    try {
+        outOfRangeTable.addCsv(outOfRangeCsv, { TableBuilder::UINT16, TableBuilder::UINT8 }, TableBuilder::INT32);
+        assert(false);
+    } catch (std::runtime_error& e) {
+        assert(std::string(e.what()).find("line 2") != std::string::npos);
+    }
+
+    /* A corrupt header, whose size of the keys overflows */
+    std::ofstream corruptFile("mockeur-test-corrupt.tbl", std::ios::binary | std::ios::trunc);
+    const std::uint32_t fieldSizes[2] = { 8, 8 };
+    const std::uint64_t hugeRowCount = 1ULL << 61;
+
+    corruptFile.write("MOCKTBL1", 8);
+    corruptFile.write(reinterpret_cast<const char*>(fieldSizes), sizeof(fieldSizes));
+    corruptFile.write(reinterpret_cast<const char*>(&hugeRowCount), sizeof(hugeRowCount));
+    corruptFile.close();
+
+    try {
+        LookupTable<long long, unsigned long long> corruptTable("mockeur-test-corrupt.tbl");
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    std::remove("mockeur-test-registers.tbl");
+    std::remove("mockeur-test-registers-csv.tbl");
+    std::remove("mockeur-test-corrupt.tbl");
+}
+
+void testWaitForCallsFromAnotherThread(void)
+{
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->then([] (const char*, unsigned int length) { return length; });
+
+    /* A call recorded before the wait is counted */
+    ftp_send("Hello", 5);
+
+    std::thread sender([] () {
+        for (int i = 0; i < 3; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ftp_send("world", 5);
+        }
+    });
+
+    assert(mock_ftp_send.waitForCalls(4, ArgumentMatcher::any<const char*>(),
+                                      ArgumentMatcher::any<unsigned int>(), std::chrono::seconds(10)));
+    sender.join();
+
+    /* Only 4 calls, and none with 6 bytes */
+    assert(!mock_ftp_send.waitForCalls(5, ArgumentMatcher::any<const char*>(),
+                                       ArgumentMatcher::any<unsigned int>(), std::chrono::milliseconds(1)));
+    assert(!mock_ftp_send.waitForCalls(1, ArgumentMatcher::any<const char*>(),
+                                       ArgumentMatcher::eq<unsigned int>(6), std::chrono::milliseconds(0)));
+
+    tearDown();
+}
+
+void testReconfigureWhileOtherThreadsCall(void)
+{
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> callers;
+
+    mock_ftp_getDataModel.when()->thenReturn(ASCII);
+
+    for (int i = 0; i < 4; i++) {
+        callers.push_back(std::thread([&failed] () {
+            for (int call = 0; call < 5000; call++) {
+                try {
+                    const enum DataModel dataModel = ftp_getDataModel();
+
+                    if (dataModel != ASCII && dataModel != BINARY)
+                        failed = true;
+                } catch (std::runtime_error&) {
+                    /* No handler: a partial change has been seen */
+                    failed = true;
+                }
+            }
+        }));
+    }
+
+    for (int change = 0; change < 200; change++) {
+        if (change % 2 == 0) {
+            mock_ftp_getDataModel.replace().when()->thenReturn(BINARY);
+        } else {
+            mock_ftp_getDataModel.beginUpdate();
+            mock_ftp_getDataModel.clear();
+            mock_ftp_getDataModel.when()->thenReturn(ASCII);
+            mock_ftp_getDataModel.commitUpdate();
+        }
+    }
+
+    for (std::thread& caller : callers)
+        caller.join();
+
+    assert(!failed);
+
+    tearDown();
+}
+
+void testHandlerUsedOnceConfigured(void)
+{
+    CallHandler<int, const char*, unsigned int>* pendingHandlerPtr
+        = mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                             ArgumentMatcher::eq<unsigned int>(3));
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+
+    /* Not configured yet: the next handler answers */
+    assert(0 == ftp_send("abc", 3));
+
+    pendingHandlerPtr->thenReturn(3);
+
+    assert(3 == ftp_send("abc", 3));
+    assert(0 == ftp_send("ab", 2));
+
+    tearDown();
+}
+
+void testInjectFailuresWhileOtherThreadsCall(void)
+{
+    std::atomic<unsigned int> succeededCount(0);
+    std::vector<std::thread> callers;
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+
+    for (int i = 0; i < 4; i++) {
+        callers.push_back(std::thread([&succeededCount] () {
+            int result;
+
+            /* Until the link is down */
+            do {
+                result = ftp_send("data", 4);
+
+                if (result == 4)
+                    succeededCount++;
+            } while (result != -1);
+        }));
+    }
+
+    /* Link failure after 1000 calls, injected while the threads call */
+    mock_ftp_send.replace().when(ArgumentMatcher::any<const char*>(),
+                                 ArgumentMatcher::any<unsigned int>())
+                 ->thenFailAfter(1000, -1, 4);
+
+    for (std::thread& caller : callers)
+        caller.join();
+
+    assert(1000u == succeededCount);
+
+    tearDown();
+}
+
+void testCombinedMatchers(void)
+{
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+
+    for (unsigned int length = 0; length < 10; length++)
+        ftp_send("data", length);
+
+    assert(2u == mock_ftp_send.numberOfCalls(ArgumentMatcher::any<const char*>(),
+                                             ArgumentMatcher::anyOf(ArgumentMatcher::eq<unsigned int>(3),
+                                                                    ArgumentMatcher::eq<unsigned int>(7))));
+    assert(9u == mock_ftp_send.numberOfCalls(ArgumentMatcher::any<const char*>(),
+                                             ArgumentMatcher::not_(ArgumentMatcher::eq<unsigned int>(3))));
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::any<const char*>(),
+                                             ArgumentMatcher::allOf(ArgumentMatcher::not_(ArgumentMatcher::eq<unsigned int>(3)),
+                                                                    ArgumentMatcher::any<unsigned int>(),
+                                                                    ArgumentMatcher::eq<unsigned int>(7))));
+
+    tearDown();
+}
+
+void testMatchersReorderedBySelectivity(void)
+{
+    CountingArgumentMatcher<const char*> contentMatcher(true);
+    CountingArgumentMatcher<unsigned int> alwaysMatcher(true);
+    CountingArgumentMatcher<unsigned int> neverMatcher(false);
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+
+    for (unsigned int call = 0; call < 2000; call++)
+        ftp_send("data", call);
+
+    /* The selective matcher of the length ends up checked before the content */
+    assert(1u == mock_ftp_send.numberOfCalls(&contentMatcher, ArgumentMatcher::eq<unsigned int>(1000)));
+    assert(contentMatcher.evaluationCount() < 1000u);
+
+    /* The matcher which always rejects ends up evaluated first */
+    assert(0u == mock_ftp_send.numberOfCalls(ArgumentMatcher::any<const char*>(),
+                                             ArgumentMatcher::allOf(&alwaysMatcher, &neverMatcher)));
+    assert(alwaysMatcher.evaluationCount() < 1000u);
+    assert(2000u == neverMatcher.evaluationCount());
+
+    tearDown();
+}
+
+void testStringMatchers(void)
+{
+    char command[] = "STOR report.txt";
+    const std::string longCommand = std::string(100, 'x') + "xxxxy" + std::string(37, 'x') + "needle";
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+
+    ftp_send(command, 15);
+    ftp_send("RETR data.txt", 13);
+    ftp_send("RETR Data.bin", 13);
+    ftp_send(longCommand.c_str(), static_cast<unsigned int>(longCommand.size()));
+    ftp_send(nullptr, 0);
+
+    /* The content is compared, not the pointer */
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::strEq("STOR report.txt"),
+                                             ArgumentMatcher::any<unsigned int>()));
+    assert(2u == mock_ftp_send.numberOfCalls(ArgumentMatcher::strPrefix("RETR "),
+                                             ArgumentMatcher::any<unsigned int>()));
+    assert(2u == mock_ftp_send.numberOfCalls(ArgumentMatcher::strContains(".txt"),
+                                             ArgumentMatcher::any<unsigned int>()));
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::strContains("xxxxy"),
+                                             ArgumentMatcher::any<unsigned int>()));
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::strContains("needle"),
+                                             ArgumentMatcher::any<unsigned int>()));
+    assert(0u == mock_ftp_send.numberOfCalls(ArgumentMatcher::strContains("needles"),
+                                             ArgumentMatcher::any<unsigned int>()));
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::regex("^RETR [a-z]+\\.txt$"),
+                                             ArgumentMatcher::any<unsigned int>()));
+
+    assert(ArgumentMatcher::strEq<char*>("STOR report.txt")->match(command));
+    assert(ArgumentMatcher::regex<char*>("report")->match(command));
+
+    try {
+        ArgumentMatcher::regex("(unclosed");
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    tearDown();
+}
+
+void testBytesMatchers(void)
+{
+    const char payload[] = "STOR report.txt\0\x01\x02";
+    const std::string binary(payload, sizeof(payload) - 1);
+
+    mock_ftp_send.when(ArgumentMatcher::bytesEq(0, 1, "QUIT"))->thenReturn(221);
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+
+    /* Only the bytes within the length are compared */
+    assert(221 == ftp_send("QUIT and more", 4));
+    assert(0 == ftp_send("QUIT", 3));
+    ftp_send(payload, static_cast<unsigned int>(binary.size()));
+    ftp_send(payload, 4);
+    ftp_send(nullptr, 0);
+
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::bytesEq(0, 1, binary)));
+    assert(2u == mock_ftp_send.numberOfCalls(ArgumentMatcher::bytesPrefix(0, 1, "STOR")));
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::bytesHash(0, 1, ArgumentMatcher::hashBytes(binary.data(),
+                                                                                                        binary.size()))));
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::bytesEq(0, 1, "")));
+    assert(ArgumentMatcher::hashBytes("QUIT", 4) != ArgumentMatcher::hashBytes("QUIT", 3));
+
+    /* The length is not a pointer */
+    try {
+        mock_ftp_send.numberOfCalls(ArgumentMatcher::bytesEq(1, 0, "QUIT"));
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    tearDown();
+}
+
+void testCallFingerprints(void)
+{
+    const char firstBuffer[] = "LIST";
+    const char secondBuffer[] = "LIST";
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+
+    ftp_send(firstBuffer, 4);
+
+    /* The calls already recorded are fingerprinted too */
+    mock_ftp_send.recordFingerprints(true);
+
+    ftp_send(firstBuffer, 4);
+    ftp_send(secondBuffer, 4);
+    ftp_send(firstBuffer, 2);
+    ftp_send(firstBuffer, 4);
+
+    assert(3u == mock_ftp_send.numberOfCalls(ArgumentMatcher::eq<const char*>(firstBuffer),
+                                             ArgumentMatcher::eq<unsigned int>(4)));
+    assert(0u == mock_ftp_send.numberOfCalls(ArgumentMatcher::eq<const char*>(secondBuffer),
+                                             ArgumentMatcher::eq<unsigned int>(2)));
+    assert(3u == mock_ftp_send.distinctCalls());
+
+    std::vector<Mock<int, const char*, unsigned int>::CallFrequency> topCalls = mock_ftp_send.topCalls(2);
+
+    assert(2u == topCalls.size());
+    assert(3u == topCalls[0].count);
+    assert(firstBuffer == std::get<0>(topCalls[0].arguments));
+    assert(1u == topCalls[1].count);
+    assert(secondBuffer == std::get<0>(topCalls[1].arguments));
+    assert(topCalls[0].firstCall < topCalls[1].firstCall);
+
+    /* By content, both buffers send the same command */
+    mock_ftp_send.fingerprintContent(0, 1);
+
+    assert(2u == mock_ftp_send.distinctCalls());
+    assert(4u == mock_ftp_send.topCalls(1)[0].count);
+    assert(4u == mock_ftp_send.numberOfCalls(ArgumentMatcher::bytesEq(0, 1, "LIST")));
+    assert(1u == mock_ftp_send.numberOfCalls(ArgumentMatcher::bytesEq(0, 1, "LI")));
+    assert(3u == mock_ftp_send.numberOfCalls(ArgumentMatcher::eq<const char*>(firstBuffer),
+                                             ArgumentMatcher::eq<unsigned int>(4)));
+
+    mock_ftp_send.recordFingerprints(false);
+
+    try {
+        mock_ftp_send.distinctCalls();
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    tearDown();
+}
+
+void testRepeatedCallsCompressed(void)
+{
+    const char buffer[] = "NOOP";
+
+    mock_ftp_getDataModel.when()->thenReturn(BINARY);
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(4);
+
+    mock_ftp_getDataModel.compressRepeatedCalls(true);
+    mock_ftp_send.compressRepeatedCalls(true);
+
+    /* Polling loop: the calls of both mocks alternate */
+    for (unsigned int i = 0; i < 5; i++) {
+        ftp_getDataModel();
+        ftp_send(buffer, 4);
+    }
+
+    ftp_getDataModel();
+    ftp_getDataModel();
+
+    const CallSequence::Number firstPollIndex = mock_ftp_getDataModel.nextCallIndex(0);
+
+    assert(7u == mock_ftp_getDataModel.numberOfCalls());
+    assert(5u == mock_ftp_send.numberOfCalls(ArgumentMatcher::eq<const char*>(buffer),
+                                             ArgumentMatcher::eq<unsigned int>(4)));
+    assert(firstPollIndex + 11 == mock_ftp_getDataModel.lastCallIndex());
+    assert(firstPollIndex + 9 == mock_ftp_send.lastCallIndex(ArgumentMatcher::any<const char*>(),
+                                                             ArgumentMatcher::any<unsigned int>()));
+    assert(firstPollIndex + 4 == mock_ftp_getDataModel.nextCallIndex(firstPollIndex + 3));
+    assert(firstPollIndex + 10 == mock_ftp_getDataModel.nextCallIndex(firstPollIndex + 8));
+    assert(4u == mock_ftp_getDataModel.callsBetween(firstPollIndex + 1, firstPollIndex + 9));
+    assert(5u == mock_ftp_getDataModel.callsBetween(firstPollIndex + 3, firstPollIndex + 12));
+    assert(2u == mock_ftp_send.callsBetween(firstPollIndex, firstPollIndex + 4,
+                                            ArgumentMatcher::any<const char*>(),
+                                            ArgumentMatcher::any<unsigned int>()));
+    assert(mock_ftp_getDataModel.waitForCalls(7, std::chrono::milliseconds(0)));
+    assert(!mock_ftp_getDataModel.waitForCalls(8, std::chrono::milliseconds(0)));
+
+    mock_ftp_getDataModel.compressRepeatedCalls(false);
+    mock_ftp_send.compressRepeatedCalls(false);
+
+    tearDown();
+}
+
+void testUnevenRepeatedCallsCompressed(void)
+{
+    const char buffer[] = "NOOP";
+    std::vector<CallSequence::Number> polls;
+
+    mock_ftp_getDataModel.when()->thenReturn(BINARY);
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(4);
+
+    mock_ftp_getDataModel.compressRepeatedCalls(true);
+    mock_ftp_send.compressRepeatedCalls(true);
+
+    /* Polling loop which sends a variable number of commands */
+    const unsigned long allocationsBefore = allocationCount.load();
+
+    for (unsigned int i = 0; i < 1000; i++) {
+        ftp_getDataModel();
+
+        for (unsigned int j = 0; j < i % 3; j++)
+            ftp_send(buffer, 4);
+    }
+
+    /* A single entry per mock, whose varints grow geometrically */
+    assert(allocationCount.load() - allocationsBefore < 100);
+
+    polls.push_back(mock_ftp_getDataModel.nextCallIndex(0));
+
+    for (unsigned int i = 1; i < 1000; i++)
+        polls.push_back(polls.back() + 1 + (i - 1) % 3);
+
+    assert(1000u == mock_ftp_getDataModel.numberOfCalls());
+    assert(999u == mock_ftp_send.numberOfCalls(ArgumentMatcher::any<const char*>(),
+                                               ArgumentMatcher::any<unsigned int>()));
+    assert(polls.back() == mock_ftp_getDataModel.lastCallIndex());
+
+    for (unsigned int i = 1; i < 1000; i += 37) {
+        assert(polls[i] == mock_ftp_getDataModel.nextCallIndex(polls[i - 1]));
+        assert(polls[i] == mock_ftp_getDataModel.nextCallIndex(polls[i] - 1));
+        assert(i - 1 == mock_ftp_getDataModel.callsBetween(polls[0], polls[i]));
+        assert(i + 1 == mock_ftp_getDataModel.callsBetween(0, polls[i] + 1));
+    }
+
+    mock_ftp_getDataModel.compressRepeatedCalls(false);
+    mock_ftp_send.compressRepeatedCalls(false);
+
+    tearDown();
+}
+
+void testParallelQueries(void)
+{
+    const char listCommand[] = "LIST";
+    const char noopCommand[] = "NOOP";
+    const std::size_t defaultThreshold = BaseMock::parallelQueryThreshold();
+    CountingArgumentMatcher<unsigned int> countingMatcher(true);
+    unsigned int listOfLength3 = 0;
+
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+
+    for (unsigned int i = 0; i < 100000; i++) {
+        ftp_send(i % 10 == 0 ? listCommand : noopCommand, i % 7);
+
+        if (i % 10 == 0 && i % 7 == 3)
+            listOfLength3++;
+    }
+
+    BaseMock::setParallelQueryThreads(4);
+    BaseMock::setParallelQueryThreshold(1000);
+
+    assert(10000u == mock_ftp_send.numberOfCalls(ArgumentMatcher::eq<const char*>(listCommand),
+                                                 ArgumentMatcher::any<unsigned int>()));
+    assert(listOfLength3 == mock_ftp_send.numberOfCalls(ArgumentMatcher::eq<const char*>(listCommand),
+                                                        ArgumentMatcher::eq<unsigned int>(3)));
+    assert(90000u == mock_ftp_send.numberOfCalls(ArgumentMatcher::strEq("NOOP"),
+                                                 ArgumentMatcher::not_(ArgumentMatcher::eq<unsigned int>(7))));
+    assert(listOfLength3 == mock_ftp_send.numberOfCalls(ArgumentMatcher::regex("^LI"),
+                                                        ArgumentMatcher::anyOf(ArgumentMatcher::eq<unsigned int>(3),
+                                                                               ArgumentMatcher::eq<unsigned int>(8))));
+
+    /* A matcher which is not thread-safe is only evaluated by the calling
+     * thread */
+    assert(100000u == mock_ftp_send.numberOfCalls(ArgumentMatcher::any<const char*>(), &countingMatcher));
+    assert(100000u == countingMatcher.evaluationCount());
+
+    BaseMock::setParallelQueryThreshold(defaultThreshold);
+
+    tearDown();
+}
+
+void testCallPattern(void)
+{
+    const char buffer[] = "DATA";
+
+    mock_ftp_getDataModel.when()->thenReturn(BINARY);
+    mock_ftp_setDataModel.when(ArgumentMatcher::any<enum DataModel>())->thenReturn();
+    mock_ftp_send.when(ArgumentMatcher::any<const char*>(),
+                       ArgumentMatcher::any<unsigned int>())
+                 ->thenReturn(0);
+    mock_ftp_send.compressRepeatedCalls(true);
+
+    ftp_setDataModel(BINARY);
+    ftp_send(buffer, 3);
+    ftp_send(buffer, 3);
+    ftp_getDataModel();
+    ftp_send(buffer, 2);
+    ftp_send(buffer, 0);
+    ftp_send(buffer, 0);
+    ftp_setDataModel(ASCII);
+    ftp_send(buffer, 1);
+    ftp_send(buffer, 0);
+    ftp_setDataModel(BINARY);
+    ftp_send(buffer, 0);
+    ftp_setDataModel(BINARY);
+    ftp_send(buffer, 4);
+    ftp_send(buffer, 0);
+
+    const CallPattern binary = mock_ftp_setDataModel.callWith(ArgumentMatcher::eq<enum DataModel>(BINARY));
+    const CallPattern content = mock_ftp_send.callWith(ArgumentMatcher::any<const char*>(),
+                                                       ArgumentMatcher::not_(ArgumentMatcher::eq<unsigned int>(0)));
+    const CallPattern end = mock_ftp_send.callWith(ArgumentMatcher::any<const char*>(),
+                                                   ArgumentMatcher::eq<unsigned int>(0));
+    const CallPattern anySend = mock_ftp_send.callWith(ArgumentMatcher::any<const char*>(),
+                                                       ArgumentMatcher::any<unsigned int>());
+
+    /* The repeated calls to ftp_send are counted one by one, and the call to
+     * ftp_getDataModel is not seen by the pattern */
+    const std::vector<CallPattern::Match> transfers = binary.then(content.oneOrMore()).then(end).matches();
+
+    assert(2u == transfers.size());
+    assert(mock_ftp_setDataModel.firstCallIndex(ArgumentMatcher::eq<enum DataModel>(BINARY)) == transfers[0].first);
+    assert(mock_ftp_send.firstCallIndex(ArgumentMatcher::any<const char*>(),
+                                        ArgumentMatcher::eq<unsigned int>(0)) == transfers[0].last);
+    assert(5u == transfers[0].callCount);
+    assert(mock_ftp_setDataModel.lastCallIndex(ArgumentMatcher::eq<enum DataModel>(BINARY)) == transfers[1].first);
+    assert(mock_ftp_send.lastCallIndex(ArgumentMatcher::any<const char*>(),
+                                       ArgumentMatcher::eq<unsigned int>(0)) == transfers[1].last);
+    assert(3u == transfers[1].callCount);
+
+    assert(2u == binary.then(content.optional()).then(end).count());
+    assert(5u == end.count());
+    assert(2u == end.then(end).count());
+    assert(5u == anySend.then(anySend).count());
+
+    /* The longest match from the first data model covers every call */
+    const std::vector<CallPattern::Match> session =
+        binary.or_(mock_ftp_setDataModel.callWith(ArgumentMatcher::eq<enum DataModel>(ASCII)))
+              .then(CallPattern::anyCall().zeroOrMore())
+              .then(end)
+              .matches();
+
+    assert(1u == session.size());
+    assert(14u == session[0].callCount);
+
+    try {
+        CallPattern::anyCall().count();
+        assert(false);
+    } catch (const std::runtime_error&) {
+    }
+
+    mock_ftp_send.compressRepeatedCalls(false);
+
+    tearDown();
+}
+
+void testControlPlane(void)
+{
+    mock_ftp_getDataModel.setName("ftp_getDataModel");
+
+    mock_ftp_getDataModel.when()->thenReturn(ASCII);
+    mock_ftp_getDataModel.addBehavior("ascii", mock_ftp_getDataModel.snapshot());
+    mock_ftp_getDataModel.clear();
+    mock_ftp_getDataModel.when()->thenReturn(BINARY);
+    mock_ftp_getDataModel.addBehavior("binary", mock_ftp_getDataModel.snapshot());
+
+    ControlPlane controlPlane("/mockeur-test-control", std::chrono::milliseconds(1));
+    ControlClient client(controlPlane.regionName());
+
+    assert(BINARY == ftp_getDataModel());
+
+    client.switchBehavior("ftp_getDataModel", "ascii");
+    assert(ASCII == ftp_getDataModel());
+
+    client.setReturnValue("ftp_getDataModel", "2");
+    assert(EBCDIC == ftp_getDataModel());
+
+    /* The history is kept by the changes of behavior */
+    assert(3u == mock_ftp_getDataModel.numberOfCalls());
+    assert(mock_ftp_getDataModel.callCount() == client.callCount("ftp_getDataModel"));
+
+    std::vector<ControlClient::MockStatus> statuses = client.mocks();
+    bool listed = false;
+
+    for (const ControlClient::MockStatus& status : statuses)
+        listed = listed || status.name == "ftp_getDataModel";
+
+    assert(listed);
+
+    try {
+        client.switchBehavior("ftp_getDataModel", "unknown");
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    try {
+        client.setReturnValue("ftp_getDataModel", "binary");
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    try {
+        client.callCount("unknown");
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    try {
+        ControlClient otherClient(controlPlane.regionName());
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    /* The region of a running control plane is not reset */
+    try {
+        ControlPlane otherControlPlane(controlPlane.regionName());
+        assert(false);
+    } catch (std::runtime_error&) {
+    }
+
+    assert(mock_ftp_getDataModel.callCount() == client.callCount("ftp_getDataModel"));
+    assert(EBCDIC == ftp_getDataModel());
+
+    tearDown();
+}
+
 int main (int, const char* [])
 {
     testDirectlySendFullContent();
     testUnableToSendAnyByte();
     testSendInTwoTimesWithSpecializedMatcher();
     testSetPolicy();
+    testSpyForwardsToRealImplementation();
+#ifdef MOCKEUR_TEST_WRAP
+    testWrappedMockArmedAndDisarmed();
+#endif
+    testSendWithSimulatedLatency();
+    testSendTimesOut();
+    testFailWithProbabilityIsReproducible();
+    testFailInBursts();
+    testFailAfter();
+    testReturnTypeWithoutDefaultConstructor();
+    testCallOrderAcrossMocks();
+    testChromeTraceExport();
+    testCallSitesAttribution();
+    testExecutorInWorkerProcesses();
+    testExecutorWithFailingTearDown();
+    testSnapshotAndRestore();
+    testRestoreIndependentOfSnapshotSize();
+    testLookupTable();
+    testWaitForCallsFromAnotherThread();
+    testReconfigureWhileOtherThreadsCall();
+    testHandlerUsedOnceConfigured();
+    testInjectFailuresWhileOtherThreadsCall();
+    testCombinedMatchers();
+    testMatchersReorderedBySelectivity();
+    testStringMatchers();
+    testBytesMatchers();
+    testCallFingerprints();
+    testRepeatedCallsCompressed();
+    testUnevenRepeatedCallsCompressed();
+    testParallelQueries();
+    testCallPattern();
+    testControlPlane();
 
     return EXIT_SUCCESS;
 }
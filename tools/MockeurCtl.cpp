@@ -0,0 +1,64 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockeurCtl.cpp
+ * @brief Controls the mocks of a running process through its ControlPlane
+ *
+ * Usage: mockeur-ctl <region> list
+ *        mockeur-ctl <region> count <mock>
+ *        mockeur-ctl <region> behavior <mock> <behavior>
+ *        mockeur-ctl <region> return <mock> <value>
+ */
+
+#include "ControlPlane.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static int usage()
+{
+    std::cerr << "Usage: mockeur-ctl <region> list\n"
+              << "       mockeur-ctl <region> count <mock>\n"
+              << "       mockeur-ctl <region> behavior <mock> <behavior>\n"
+              << "       mockeur-ctl <region> return <mock> <value>" << std::endl;
+
+    return EXIT_FAILURE;
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc < 3)
+        return usage();
+
+    const std::string command = argv[2];
+
+    try {
+        ControlClient client(argv[1]);
+
+        if (command == "list" && argc == 3) {
+            for (const ControlClient::MockStatus& status : client.mocks())
+                std::cout << status.name << ' ' << status.callCount << '\n';
+        } else if (command == "count" && argc == 4) {
+            std::cout << client.callCount(argv[3]) << '\n';
+        } else if (command == "behavior" && argc == 5) {
+            client.switchBehavior(argv[3], argv[4]);
+        } else if (command == "return" && argc == 5) {
+            client.setReturnValue(argv[3], argv[4]);
+        } else {
+            return usage();
+        }
+    } catch (std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
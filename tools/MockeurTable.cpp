@@ -0,0 +1,90 @@
+/*
+ * (c) Copyright 2013-2014 Vladimir Svoboda
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution.
+ */
+
+/**
+ * @file MockeurTable.cpp
+ * @brief Builds the file of a LookupTable from a CSV file
+ *
+ * Usage: mockeur-table -k <type> [-k <type>...] -v <type> <input.csv> <output>
+ *
+ * Each -k gives the type of an argument of the mocked function, in order, and
+ * -v the type of its return value: i8, u8, i16, u16, i32, u32, i64, u64, f32
+ * or f64 (an enumeration is usually an i32).
+ */
+
+#include "TableFile.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static int usage()
+{
+    std::cerr << "Usage: mockeur-table -k <type> [-k <type>...] -v <type> <input.csv> <output>\n"
+              << "Types: i8, u8, i16, u16, i32, u32, i64, u64, f32, f64" << std::endl;
+
+    return EXIT_FAILURE;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<TableBuilder::FieldType> keyFields;
+    TableBuilder::FieldType valueField = TableBuilder::INT32;
+    bool hasValueField = false;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        TableBuilder::FieldType fieldType;
+
+        if ((std::strcmp(argv[i], "-k") == 0 || std::strcmp(argv[i], "-v") == 0) && i + 1 < argc) {
+            if (!TableBuilder::parseFieldType(argv[i + 1], fieldType))
+                return usage();
+
+            if (argv[i][1] == 'k') {
+                keyFields.push_back(fieldType);
+            } else {
+                valueField = fieldType;
+                hasValueField = true;
+            }
+
+            i++;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (!hasValueField || paths.size() != 2)
+        return usage();
+
+    std::size_t keySize = 0;
+
+    for (TableBuilder::FieldType fieldType : keyFields)
+        keySize += TableBuilder::fieldSize(fieldType);
+
+    std::ifstream in(paths[0].c_str());
+
+    if (!in) {
+        std::cerr << "Cannot open " << paths[0] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        TableBuilder builder(keySize, TableBuilder::fieldSize(valueField));
+
+        builder.addCsv(in, keyFields, valueField);
+        builder.write(paths[1]);
+    } catch (std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}